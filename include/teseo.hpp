@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <functional>
 #include <ostream>
 #include <stdexcept>
 #include <string>
@@ -24,6 +25,7 @@
 namespace teseo {
 
 class Iterator; // forward declaration
+class TaskGroup; // forward declaration
 class Teseo; // forward declaration
 class Transaction; // forward declaration
 
@@ -323,7 +325,9 @@ public:
     uint64_t num_edges() const;
 
     /**
-     * Retrieve the logical ID of the given vertex. That is its rank among all vertices,
+     * Retrieve the logical ID of the given vertex. That is its rank among all vertices, by default sorted
+     * by vertex ID. Read-only transactions can be configured to assign the logical IDs in a different
+     * order, e.g. by decreasing degree.
      * @return a value in [0, num_vertices)
      */
     uint64_t logical_id(uint64_t vertex_id) const;
@@ -338,6 +342,14 @@ public:
      */
     bool is_read_only() const;
 
+    /**
+     * Hint the number of queries on the degree of the vertices that this transaction is expected to perform.
+     * After a few queries, the degrees can be answered by an auxiliary view of the whole graph. The view is
+     * built only when its cost is expected to pay off over the remaining queries. Without a hint, the
+     * transaction is assumed to perform as many queries again as it has performed so far.
+     */
+    void hint_degree_queries(uint64_t num_queries);
+
     /**
      * Commit the transaction
      */
@@ -397,12 +409,123 @@ public:
      */
     Transaction start_transaction(bool read_only = false);
 
+    /**
+     * Make the committed transactions durable in a redo log, stored in a local file. If the log already
+     * exists, its content is first replayed into the database. From then on, a read-write transaction
+     * returns from commit only after its changes have been synced to the log.
+     * This method must not be invoked while other transactions are active.
+     * @param path the path to the log file
+     */
+    void enable_redo_log(const std::string& path);
+
+    /**
+     * Stop recording the committed transactions in the redo log.
+     * This method must not be invoked while other transactions are active.
+     */
+    void disable_redo_log();
+
+    /**
+     * Write a snapshot of the current content of the database into a local file. The snapshot is
+     * consistent with the state observed by a read-only transaction started by this method.
+     * @param path the path to the checkpoint file
+     */
+    void checkpoint(const std::string& path);
+
+    /**
+     * Load the content of a checkpoint, previously written with the method #checkpoint. The database
+     * must be empty and this method must not be invoked while other transactions are active.
+     * @param path the path to the checkpoint file
+     */
+    void restore(const std::string& path);
+
+    /**
+     * Release the memory not used anymore by the storage, e.g. after many vertices and edges have been removed.
+     * The sparse leaves are merged together or moved into smaller leaves, the index of the vertices is rehashed
+     * down and the memory released is returned to the OS. The transactions can still be executed concurrently.
+     */
+    void compact();
+
+    /**
+     * Set the amount of memory, in bytes, for the storage of the vertices and edges above which the database
+     * automatically compacts itself in the background, as in #compact. A value of 0 disables the automatic
+     * compaction.
+     */
+    void set_memory_target(uint64_t bytes);
+
+    /**
+     * Execute fn(i) for each i in [begin, end), in parallel. The interval is split in chunks of `grain' indices,
+     * processed by the calling thread and by a pool of threads owned by the database. The threads of the pool are
+     * already registered, there is no need to invoke #register_thread inside fn. The method returns once all
+     * indices have been processed. If fn raises an exception, the remaining chunks are skipped and the
+     * exception is rethrown to the caller.
+     */
+    void parallel_for(uint64_t begin, uint64_t end, uint64_t grain, const std::function<void(uint64_t)>& fn);
+
+    /**
+     * Execute fn(tx, it, i) for each i in [begin, end), in parallel, as above. Each participating thread operates on
+     * its own copy `tx' of the given transaction and on its own iterator `it', created from the copy. Both are
+     * released before the method returns, so that the transaction can be terminated afterwards.
+     */
+    void parallel_for(const Transaction& transaction, uint64_t begin, uint64_t end, uint64_t grain, const std::function<void(Transaction&, Iterator&, uint64_t)>& fn);
+
     /**
      * Opaque reference to the implementation handle, only for debugging purposes
      */
     void* handle_impl();
 };
 
+/*****************************************************************************
+ *                                                                           *
+ *   Group of parallel tasks                                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+/**
+ * A group of closures executed asynchronously by the same pool of threads of Teseo#parallel_for. The closures
+ * can spawn further closures in the same group. Use the method #wait to wait for all of them to complete.
+ * An instance of TaskGroup is not meant to be shared among threads, only its closures can invoke #run concurrently.
+ */
+class TaskGroup {
+    void* m_pImpl; // opaque pointer to the implementation
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+public:
+    /**
+     * Create a new group of closures for the given database
+     */
+    TaskGroup(Teseo& database);
+
+    /**
+     * Create a new group of closures, operating on the given transaction
+     */
+    TaskGroup(Teseo& database, const Transaction& transaction);
+
+    /**
+     * Destructor. It waits for the closures still running, ignoring their exceptions.
+     */
+    ~TaskGroup();
+
+    /**
+     * Execute the given closure asynchronously
+     */
+    void run(std::function<void()> fn);
+
+    /**
+     * Execute the given closure asynchronously, on its own copy of the transaction of the group and its own
+     * iterator, created from the copy.
+     * @throws LogicalError if the group has not been created with a transaction
+     */
+    void run(std::function<void(Transaction&, Iterator&)> fn);
+
+    /**
+     * Wait for all closures to complete. The calling thread helps executing the closures not started yet.
+     * If any closure raised an exception, the first one is rethrown.
+     */
+    void wait();
+};
+
 } // namespace
 
 // Implementation details. It defines the templates for the method Iterator#scan()
@@ -17,11 +17,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <cinttypes>
 #include <condition_variable>
 #include <mutex>
-
-#include "teseo/util/abtree.hpp"
+#include <vector>
 
 namespace teseo::memstore{ class Key; } // forward declaration
 
@@ -33,16 +33,25 @@ class PartialResult; // forward declaration
 
 /**
  * Class to create the final degree vectors out of a collection of partial results.
+ *
+ * The partial results are issued and consumed by the same thread, in order, while the workers compute them
+ * concurrently. Each partial result is stored in the slot given by its ID and flagged as ready by the worker
+ * once computed, without acquiring any lock. The consumer only blocks when the next partial result in the
+ * sequence is not ready yet.
  */
 class Builder{
     Builder(const Builder&) = delete;
     Builder& operator=(const Builder&) = delete;
 
-    uint64_t m_num_partial_results; // the total number of instances of PartialResults issued
-    std::mutex m_mutex; // to guarantee thread-safety
+    std::vector<PartialResult*> m_slots; // the partial results issued, indexed by their ID. Only accessed by the owner thread
+    uint64_t m_num_collected_results; // total number of items fetched so far
+    std::atomic<bool> m_waiting; // whether the consumer is waiting for the next partial result to become ready
+    std::atomic<uint64_t> m_num_active_producers; // number of workers still inside #collect, the instance cannot be released until they leave
+    std::mutex m_mutex; // to sleep while the next partial result is not ready
     std::condition_variable m_condvar; // to signal the builder a new item is available
-    teseo::util::ABTree</* id */ uint64_t, PartialResult*> m_queue; // the available partial results, as collected from the workers
-    uint64_t m_num_collected_results; // total number of items fetched from the queue, so far
+
+    // Wait for the given partial result to be computed by the workers
+    void wait(PartialResult* partial_result);
 
 public:
     // Init the builder
@@ -57,7 +66,7 @@ public:
     // Collect a partial result previously issued
     void collect(PartialResult* partial_result);
 
-    // Fetch the next item from the queue. Return NULL if the queue has been exhausted.
+    // Fetch the next item in the sequence, waiting for it to be ready. Return NULL if the sequence has been exhausted.
     // Remember to explicitly deallocate the item retrieved once used.
     PartialResult* next();
 
@@ -17,20 +17,48 @@
 
 #pragma once
 
+#include "teseo/aux/change.hpp"
+#include "teseo/aux/ordering.hpp"
 #include "teseo/context/static_configuration.hpp" // numa_num_nodes
 #include "teseo/util/latch.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace teseo::gc {  class GarbageCollector; }
+namespace teseo::memstore { class Memstore; } // forward declaration
+namespace teseo::transaction { class TransactionImpl; } // forward declaration
 
 namespace teseo::aux {
 
+class DynamicView; // forward declaration
 class StaticView; // forward declaration
+class VersionedTree; // forward declaration
 
 /**
- * Cache for the last created view. Used by the global_context
+ * Cache for the last created views. Used by the global_context
+ *
+ * While a view is cached, the cache also records, in commit order, the changes to the vertices and their degrees
+ * performed by the read-write transactions. A transaction can then reuse a view built for another snapshot, if
+ * no change was committed in between, or derive its view from an older cached view, rather than rebuilding it
+ * from scratch by scanning the whole memstore.
+ *
+ * The views for multiple snapshots are retained, so that older long-running read-only transactions do not need to
+ * rebuild them. Views are evicted when they cannot be used anymore by any active or future transaction, or
+ * when their total size exceeds the memory budget. The views of the most recent snapshot are always retained.
+ *
+ * The most recent views are published through an atomic pointer, protected by the epochs of the garbage collector,
+ * so that the readers can retrieve them without acquiring any latch. When no cached view is suitable, only one
+ * transaction at the time builds the new views, while the others wait for its result.
+ *
+ * For the read-write transactions, the cache maintains a single counting tree with the last committed state of the
+ * vertices and their degrees, updated as the writers commit. The dynamic views of the read-write transactions
+ * are backed by this tree, rather than scanning the whole memstore for each transaction.
  */
 class Cache {
     Cache(const Cache&) = delete;
@@ -38,27 +66,106 @@ class Cache {
     constexpr static uint64_t NUM_NODES = context::StaticConfiguration::numa_num_nodes;
     static_assert(NUM_NODES >= 1, "We expect to have at least one memory node available");
 
-    mutable util::Latch m_latch; // to provide thread-safety
-    uint64_t m_transaction_id; // the read ID associated to the last created view
-    aux::StaticView* m_views[NUM_NODES]; // the last created view
+    // The cached views for a snapshot, immutable once published
+    struct Entry {
+        uint64_t m_transaction_id; // the read ID associated to the views
+        aux::StaticView* m_views[NUM_NODES]; // one view per NUMA node
+        uint64_t m_memory_footprint; // the amount of memory used by the views, in bytes
+    };
+
+    std::atomic<Entry*> m_entry; // the views for the most recent snapshot
+    std::atomic<uint64_t> m_changes_lbound; // lower bound for the ID of the first change recorded after the most recent snapshot, or max if none
+    mutable util::Latch m_latch; // to provide thread-safety to the versions and the log of changes
+    std::vector<Entry*> m_versions; // all cached views, sorted by transaction ID
+    uint64_t m_memory_footprint; // the total amount of memory used by the cached views, in bytes
+    std::atomic<uint64_t> m_memory_budget; // the max amount of memory that the cached views can use, in bytes
+    std::vector<Change> m_changes; // the changes committed after the oldest cached view, sorted by transaction ID
+    uint64_t m_changes_start; // the log of changes is complete only for the transactions with an ID >= m_changes_start
+    std::mutex m_build_mutex; // to sync the transactions waiting for the construction of a new view
+    std::condition_variable m_build_condvar; // to wake up the transactions waiting for the construction of a new view
+    bool m_build_in_progress; // whether a transaction is building a new view
+    uint64_t m_build_transaction_id; // the read ID of the transaction building the new view
+    uint64_t m_build_generation; // number of views built so far, to detect when a build has completed
+    const Ordering m_ordering; // the policy to assign the logical IDs in the views built from scratch
+    VersionedTree* m_dynamic; // the tree shared by the dynamic views of the read-write transactions, or nullptr
+    std::mutex m_dynamic_mutex; // to ensure that only one transaction at the time builds the shared tree
+    uint64_t m_last_commit_id; // the ID of the last writer committed with some changes, or max if unknown
     //gc::GarbageCollector* m_garbage_collector; // to remove the references to leaves
 
-    // Remove the previously cached views
-    void unset(); // the latch must be held by the invoker
+    // Retrieve the most recent views, if suitable for the given transaction, without acquiring any latch
+    bool get_if_cached(uint64_t transaction_id, aux::StaticView** output);
+
+    // Retrieve the views for the given transaction from any cached snapshot, or derive them from an older snapshot
+    // and the log of changes
+    // @return false if none of the cached views is suitable
+    bool derive(uint64_t transaction_id, aux::StaticView** output);
+
+    // Build the views for the given transaction, either derived from the cached views or from scratch
+    void build(memstore::Memstore* memstore, transaction::TransactionImpl* transaction, aux::StaticView** output);
+
+    // Retrieve the position of the first change with a transaction ID >= the given ID
+    uint64_t changes_lower_bound(uint64_t transaction_id) const; // the latch must be held by the invoker
+
+    // Check whether the views of the given entry are valid for the given transaction
+    bool is_valid(const Entry* entry, uint64_t transaction_id) const; // the latch must be held by the invoker
+
+    // Evict the views that cannot be used anymore, or exceed the memory budget, and prune the log of changes
+    void evict(uint64_t high_water_mark); // the latch must be held by the invoker
+
+    // Remove the cached views at the given position in m_versions
+    void unset(uint64_t position); // the latch must be held by the invoker
+
+    // Remove all cached views
+    void unset_all(); // the latch must be held by the invoker
+
+    // Release the given entry, invoked by the garbage collector
+    static void delete_entry(void* entry);
+
+    // Retrieve the shared tree, if it has been initialised, and increment its ref count
+    VersionedTree* acquire_dynamic();
+
+    // Build a new shared tree from scratch, with its ref count already incremented for the caller
+    VersionedTree* build_dynamic(memstore::Memstore* memstore);
+
+    // Record the changes committed by a writer into the shared tree, drop the tree if it has become too expensive to maintain
+    void commit_dynamic(std::vector<Change>& changes, uint64_t transaction_id, std::optional<util::WriteLatch>& xlock_dynamic); // the latch must be held by the invoker
 
 public:
     // Init the cache
-    Cache();
+    Cache(uint64_t memory_budget = context::StaticConfiguration::aux_cache_memory_budget, Ordering ordering = Ordering::VERTEX_ID);
 
     // Destructor
     ~Cache();
 
-    // Retrieve the cached views, if suitable for the given transaction id
-    bool get(uint64_t transaction_id, uint64_t highest_txn_rw_id, aux::StaticView** output);
+    // Retrieve the views for the given transaction, either the cached views, new views derived from them, or
+    // new views built from scratch
+    void get(memstore::Memstore* memstore, transaction::TransactionImpl* transaction, aux::StaticView** output);
+
+    // Check whether the views for the given read-only transaction are already available, without building them
+    bool has_view(uint64_t transaction_id) const;
+
+    // Check whether the shared tree can back the dynamic view of the given read-write transaction
+    bool has_dynamic(uint64_t transaction_id) const;
 
-    // Update the last saved views
+    // Retrieve a dynamic view for the given read-write transaction, backed by the shared tree. The tree is built
+    // on the first invocation. Return nullptr if the tree cannot be used by the transaction
+    DynamicView* get_dynamic(memstore::Memstore* memstore, transaction::TransactionImpl* transaction);
+
+    // Save the views for the given snapshot
     void set(aux::StaticView** views, uint64_t transaction_id);
 
+    // Draw the commit ID for the given read-write transaction and record its changes
+    uint64_t commit(transaction::TransactionImpl* transaction);
+
+    // Set the max amount of memory that the cached views can use, in bytes
+    void set_memory_budget(uint64_t bytes);
+
+    // Retrieve the number of snapshots currently cached
+    uint64_t num_versions() const;
+
+    // Retrieve the changes to the vertices and their degrees performed by the given transaction
+    static std::vector<Change> changes(const transaction::TransactionImpl* transaction);
+
     // Retrieve a representation of this instance, for debugging purposes
     std::string to_string() const;
 
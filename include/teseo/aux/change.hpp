@@ -0,0 +1,50 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <ostream>
+#include <string>
+
+namespace teseo::aux {
+
+/**
+ * A change to the set of vertices, or to the degree of a vertex, committed by a read-write transaction. It is
+ * recorded by the aux cache, to derive the new static views from the last cached view.
+ */
+class Change {
+public:
+    enum Type : uint64_t {
+        INSERT_VERTEX, // a new vertex has been inserted, with degree 0
+        REMOVE_VERTEX, // a vertex has been removed
+        INCR_DEGREE, // an edge attached to the vertex has been inserted
+        DECR_DEGREE, // an edge attached to the vertex has been removed
+    };
+
+    uint64_t m_transaction_id; // the commit ID of the transaction that performed the change
+    uint64_t m_vertex_id; // the vertex affected by the change
+    Type m_type; // the type of change
+
+    // Get a string representation of the change, for debugging purposes
+    std::string to_string() const;
+};
+
+// Print to stdout the change, for debugging purposes
+std::ostream& operator<<(std::ostream& out, const Change& change);
+
+} // namespace
@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <ostream>
+#include <string>
+
+namespace teseo::aux {
+
+/**
+ * Cost model to decide whether a transaction should answer its queries on the degree of a vertex through the
+ * auxiliary view, rather than the memstore. Building a view requires to scan the whole graph, it only pays off
+ * when the expected cost of the remaining lookups in the memstore exceeds the cost to build the view.
+ *
+ * Both costs are sampled at runtime, as a moving average of the observed lookups and builds.
+ *
+ * This class is thread safe.
+ */
+class CostModel {
+    CostModel(const CostModel&) = delete;
+    CostModel& operator=(const CostModel&) = delete;
+
+    std::atomic<double> m_cost_lookup; // average cost of a degree lookup in the memstore, in nanosecs
+    std::atomic<double> m_cost_build; // average cost to build a view from scratch, in nanosecs per vertex & edge
+
+    // Add the given sample to a moving average
+    static void update(std::atomic<double>& average, double sample);
+
+public:
+    // Init the model with the default costs
+    CostModel();
+
+    // Record the time spent, in nanosecs, to retrieve the degree of a vertex from the memstore
+    void record_lookup(uint64_t nanosecs);
+
+    // Record the time spent, in nanosecs, to build a view from scratch for a graph with the given number of vertices & edges
+    void record_build(uint64_t num_elements, uint64_t nanosecs);
+
+    // Estimated cost, in nanosecs, of a degree lookup in the memstore
+    double lookup_cost() const;
+
+    // Estimated cost, in nanosecs, to build a view from scratch for a graph with the given number of vertices & edges
+    double build_cost(uint64_t num_elements) const;
+
+    /**
+     * Decide whether to build the auxiliary view to answer the remaining degree lookups of a transaction
+     * @param num_lookups the number of lookups performed so far by the transaction
+     * @param expected_lookups the total number of lookups expected by the user, or 0 if unknown. When unknown,
+     *        or already exceeded, the transaction is expected to perform as many lookups as done so far.
+     * @param num_elements the number of vertices & edges in the graph
+     * @param is_cached whether a view is already available from the cache, and it does not need to be built
+     */
+    bool use_aux_view(uint64_t num_lookups, uint64_t expected_lookups, uint64_t num_elements, bool is_cached) const;
+
+    // Retrieve a string representation of the model, for debugging purposes
+    std::string to_string() const;
+};
+
+// Print to the output stream a string representation of the model, for debugging purposes
+std::ostream& operator<<(std::ostream& out, const CostModel& model);
+
+} // namespace
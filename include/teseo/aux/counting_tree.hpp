@@ -170,6 +170,12 @@ public:
      */
     bool get_by_vertex_id_optimistic(uint64_t vertex_id, util::OptimisticLatch<0>& latch, uint64_t version, ItemUndirected* output_item, uint64_t* output_rank = nullptr) const;
 
+    /**
+     * Retrieve the number of elements with a vertex ID smaller than the given one. The vertex itself does not need to exist.
+     * Precondition: the caller accesses the data structure in mutual exclusion
+     */
+    uint64_t rank(uint64_t vertex_id) const;
+
     /**
      * Retrieve the element associated to the given rank
      * Precondition: the caller accesses the data structure in mutual exclusion
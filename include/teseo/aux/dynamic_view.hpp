@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "teseo/aux/counting_tree.hpp"
 #include "teseo/aux/view.hpp"
 #include "teseo/util/latch.hpp"
@@ -26,21 +28,56 @@ namespace teseo::transaction { class TransactionImpl; } // forward declaration
 
 namespace teseo::aux {
 
+class VersionedTree; // forward declaration
+
 /**
  * A dynamic mapping between logical IDs and vertex IDs, including their degrees. The view can be
  * altered by creating new vertices, removing the existing vertices or modifying the degrees.
  *
+ * The view either owns a private counting tree, built by scanning the whole memstore, or it is backed by
+ * the counting tree shared by all read-write transactions, see VersionedTree. In the latter case, the view
+ * only stores the differences between the snapshot of its transaction and the shared tree.
+ *
  * This class is thread safe.
  */
 class DynamicView : public View {
     DynamicView(const DynamicView&) = delete;
     DynamicView& operator=(const DynamicView&) = delete;
 
-    CountingTree m_tree; // mapping between vertex ID and logical IDs
+    // The difference between the snapshot of the transaction and the shared tree for a single vertex
+    struct Diff {
+        int64_t m_presence; // +1 if only the snapshot contains the vertex, -1 if only the shared tree contains it
+        int64_t m_degree; // the difference of the degrees, a vertex that does not exist has degree 0
+    };
+
+    CountingTree m_tree; // mapping between vertex ID and logical IDs, when the view owns its private tree
     mutable util::OptimisticLatch<0> m_latch; // to ensure thread-safety
+    VersionedTree* m_shared; // the tree shared by the read-write transactions, or nullptr if the view owns its tree
+    const uint64_t m_transaction_id; // the read ID of the transaction, to translate the content of the shared tree
+    mutable uint64_t m_shared_position; // the position of the next delta of the shared tree to merge
+    mutable std::map<uint64_t, Diff> m_diffs; // the differences w.r.t. the shared tree, sorted by vertex ID
+    mutable int64_t m_diffs_num_vertices; // the difference of the number of vertices w.r.t. the shared tree
 
     // Create a new instance of the view
     DynamicView(CountingTree&& tree);
+    DynamicView(VersionedTree* shared, uint64_t transaction_id);
+
+    // Merge the deltas of the transactions committed in the shared tree since the last invocation.
+    // Precondition: the caller holds the latch of this view and the latch of the shared tree, at least in read mode
+    void shared_sync() const;
+
+    // Record a difference w.r.t. the shared tree
+    void shared_add_diff(uint64_t vertex_id, int64_t presence, int64_t degree) const;
+
+    // Retrieve the state of the vertex in the snapshot of the transaction, backed by the shared tree
+    bool shared_get(uint64_t vertex_id, uint64_t* out_degree) const;
+
+    // Implementation of the API for the views backed by the shared tree.
+    // Precondition: the caller holds the latch of this view and the latch of the shared tree, at least in read mode
+    uint64_t shared_vertex_id(uint64_t logical_id) const;
+    uint64_t shared_logical_id(uint64_t vertex_id) const;
+    uint64_t shared_degree(uint64_t id, bool is_logical) const;
+    uint64_t shared_num_vertices() const;
 
 public:
     // Destructor
@@ -73,6 +110,10 @@ public:
     // Create a view for the given transaction
     static DynamicView* create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction);
 
+    // Create a view for the given transaction backed by the shared tree. Return nullptr if the shared tree cannot
+    // be used by the transaction, as it started before the tree had been initialised
+    static DynamicView* create_undirected(VersionedTree* shared, transaction::TransactionImpl* transaction);
+
     // Dump the content of the view to stdout, for debugging purposes
     void dump() const;
 };
@@ -0,0 +1,33 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+
+namespace teseo::aux {
+
+/**
+ * The policy to assign the logical IDs to the vertices in the static views. Graph kernels usually index
+ * their per-vertex arrays by logical ID, hence the policy determines the locality of their accesses.
+ */
+enum class Ordering : uint8_t {
+    VERTEX_ID, // the rank of the vertex among all vertices, sorted by vertex ID
+    DEGREE_DESC, // vertices with higher degree first, ties are broken by vertex ID
+};
+
+} // namespace
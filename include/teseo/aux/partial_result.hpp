@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cinttypes>
 #include <utility>
 
@@ -32,7 +33,7 @@ class Builder; // forward declaration
  * Used by the workers to collect the partial degrees of each vertex, before aggregating
  * the final result, the aux vector, in the builder.
  *
- * This class is not thread-safe.
+ * This class is not thread-safe, except for the flag #is_ready.
  */
 class PartialResult {
     PartialResult(const PartialResult&) = delete;
@@ -45,6 +46,7 @@ class PartialResult {
     ItemUndirected* m_array; // the container for the items
     int64_t m_last; // the index of the last vertex inserted
     uint64_t m_capacity; // the max number of items that can be stored in the container `m_array'
+    std::atomic<bool> m_ready; // set by the worker once the partial result has been computed
 
     // Reset the capacity of the container `m_array'
     void resize(uint64_t new_capacity);
@@ -62,6 +64,12 @@ public:
     // Signal to the builder that this partial result is ready to be consumed
     void done();
 
+    // Flag the partial result as computed, invoked by the builder
+    void set_ready() noexcept;
+
+    // Check whether the partial result has been computed and it can be consumed
+    bool is_ready() const noexcept;
+
     // Observer, get the logical ID of this instance
     uint64_t id() const noexcept;
 
@@ -17,7 +17,11 @@
 
 #pragma once
 
+#include <limits>
+#include <vector>
+
 #include "teseo/aux/item.hpp"
+#include "teseo/aux/ordering.hpp"
 #include "teseo/aux/view.hpp"
 
 namespace teseo::memstore { class Memstore; } // forward declaration
@@ -25,44 +29,93 @@ namespace teseo::transaction { class TransactionImpl; } // forward declaration
 
 namespace teseo::aux {
 
+class Change; // forward declaration
 class ItemUndirected; // forward declaration
 
 /**
  * A mapping between logical IDs and vertex IDs, including their degree.
  *
+ * The view is stored in a compact columnar layout: the degrees are kept in a 32-bit column, with the few degrees that
+ * do not fit in 32 bits moved to a side table, sorted by logical ID. The slots of the dictionary only store the logical
+ * IDs, in 32 bits when the number of vertices allows it, as the key can be retrieved from the column of the vertex IDs.
+ * When the vertex IDs are contiguous and the logical IDs follow their order, both the column of the vertex IDs and the
+ * dictionary are elided altogether, as the mapping is implicit.
+ *
  * This class is not thread safe
  */
 class StaticView : public View {
     StaticView(const StaticView&) = delete;
     StaticView& operator=(const StaticView&) = delete;
 
-    const uint64_t m_num_vertices; // total number of vertices in the view, also the size of the degree vector
-    const ItemUndirected* m_degree_vector; // Map a logical ID to its vertex_id and its degree
+    // A degree that does not fit in the 32-bit column
+    struct Overflow {
+        uint64_t m_logical_id; // the vertex, as logical ID
+        uint64_t m_degree; // its degree
+    };
+
+    // Marker in the column of the degrees, the actual degree is stored in the overflow table
+    constexpr static uint32_t DEGREE_OVERFLOW = std::numeric_limits<uint32_t>::max();
+
+    const uint64_t m_num_vertices; // total number of vertices in the view, also the size of the columns
+    void* m_columns; // the chunk of memory holding the column of the vertex IDs, the overflow table and the column of the degrees
+    const uint64_t* m_vertex_ids; // map a logical ID to its vertex ID, nullptr if the vertex IDs are implicit
+    const uint64_t m_first_vertex_id; // with implicit vertex IDs, the vertex ID associated to the logical ID 0
+    const Overflow* m_overflow; // the degrees that do not fit in the column m_degrees, sorted by logical ID
+    const uint64_t m_num_overflow; // number of entries in the overflow table
+    const uint32_t* m_degrees; // map a logical ID to its degree, or DEGREE_OVERFLOW
     const bool m_hash_direct; // whether the hash table is an array for direct access
-    const uint64_t m_hash_capacity; // the size of the dictionary to map the vertex ids to their logical IDs
+    const bool m_hash_narrow; // whether the slots of the dictionary are 32-bit wide
+    const uint64_t m_hash_capacity; // the number of slots of the dictionary to map the vertex ids to their logical IDs
     const uint64_t m_hash_const; // hash constant to compute the hash function
+    const Ordering m_ordering; // the policy used to assign the logical IDs
 
     // Build the dictionary for the vertex IDs. Invoked at initialisation
     void create_vertex_id_mapping();
 
     struct HashParams {
+        bool m_implicit; // no dictionary, the logical ID is the vertex ID minus m_first_vertex_id
         bool m_direct; // use a direct table rather than an hash table?
-        uint64_t m_capacity; // the capacity of the dictionary array
+        bool m_narrow; // use 32-bit slots?
+        uint64_t m_capacity; // the number of slots of the dictionary
         uint64_t m_const; // first hash key
+        uint64_t m_first_vertex_id; // with implicit vertex IDs, the first vertex in the view
         bool m_initialised; // whether the hash table has already been initialised
 
-        HashParams(uint64_t max_vertex_id, uint64_t num_vertices);
+        HashParams(const ItemUndirected* degree_vector /* sorted by vertex ID */, uint64_t num_vertices, Ordering ordering);
+        HashParams(const StaticView* view); // same parameters of an existing view
+
+        // The size of the dictionary, in bytes
+        uint64_t size() const;
     };
 
     // Actual init. Build an instance with the static method #create_undirected
-    StaticView(uint64_t num_vertices, const ItemUndirected* degree_vector, const HashParams& hash);
+    StaticView(uint64_t num_vertices, void* columns, uint64_t num_overflow, const HashParams& hash, Ordering ordering);
+
+    // Rearrange the degree vector, sorted by vertex ID, according to the given ordering policy
+    static void sort(ItemUndirected* degree_vector, uint64_t num_vertices, Ordering ordering);
+
+    // Create a view on the first NUMA node out of the given degree vector, already rearranged according to the ordering
+    // policy. The degree vector is released. With `dictionary', the slots of the dictionary are copied from an existing view
+    static StaticView* create(uint64_t num_vertices, ItemUndirected* degree_vector, HashParams hash, Ordering ordering, const StaticView* dictionary = nullptr);
+
+    // Copy the view in out_array[0] to the remaining NUMA nodes
+    static void replicate(StaticView** out_array, uint64_t out_sz, HashParams hash);
 
     // Compute the hash the given vertex id
     uint64_t hash(uint64_t vertex_id) const noexcept;
 
     // Access the hash table
-    uint64_t* hash_table();
-    const uint64_t* hash_table() const;
+    template<typename T> T* hash_table();
+    template<typename T> const T* hash_table() const;
+
+    // Retrieve the logical ID of the given vertex from the dictionary, with slots of type T
+    template<typename T> uint64_t lookup(uint64_t vertex_id) const noexcept;
+
+    // Insert the vertices with logical IDs in [start, end) into the dictionary, with slots of type T
+    template<typename T> void hashmap_insert0(uint64_t start, uint64_t end, bool concurrent);
+
+    // Retrieve the content of the view as a degree vector, indexed by logical ID
+    void copy_to(ItemUndirected* degree_vector) const;
 
 protected:
     // Invoked by the ref count mechanism before deleting this class
@@ -88,13 +141,33 @@ public:
     // Retrieve the total number of vertices
     uint64_t num_vertices() const noexcept;
 
-    // Retrieve the underlying degree vector
-    const ItemUndirected* degree_vector() const;
+    // Retrieve the policy used to assign the logical IDs
+    Ordering ordering() const noexcept;
+
+    // Retrieve the amount of memory, in bytes, used by the view
+    uint64_t memory_footprint() const noexcept;
+
+    // Whether the column of the vertex IDs and the dictionary have been elided, as the vertex IDs are contiguous
+    bool is_implicit() const noexcept;
+
+    // Retrieve the number of degrees that did not fit in the 32-bit column
+    uint64_t num_overflow() const noexcept;
 
     // Create a view on each NUMA node for the given transaction
-    static void create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction, StaticView** out, uint64_t out_sz); // NUMA-aware API
-    static StaticView* create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction); // old API, only used for tests
-    static StaticView* create_undirected(uint64_t num_vertices, const ItemUndirected* degree_vector); // old API used for tests
+    static void create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction, StaticView** out, uint64_t out_sz, Ordering ordering = Ordering::VERTEX_ID); // NUMA-aware API
+    static StaticView* create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction, Ordering ordering = Ordering::VERTEX_ID); // old API, only used for tests
+    static StaticView* create_undirected(uint64_t num_vertices, ItemUndirected* degree_vector); // old API used for tests, the degree vector is released
+
+    // Create a view on each NUMA node from a previous view and the changes committed after it, sorted by transaction ID.
+    // The new view retains the ordering policy of the previous view
+    static void create_undirected(const StaticView* previous, const std::vector<Change>& changes, StaticView** out, uint64_t out_sz);
+
+    // Initialise the slots in [start, end) of the dictionary. Invoked by the runtime workers while building the view
+    void hashmap_init(uint64_t start, uint64_t end);
+
+    // Insert the vertices with logical IDs in [start, end) into the dictionary. With `concurrent', the slots are
+    // acquired with a CAS, as other workers may be inserting the remaining vertices at the same time
+    void hashmap_insert(uint64_t start, uint64_t end, bool concurrent);
 
     // Dump the content of the view to stdout, for debugging purposes
     void dump() const;
@@ -108,44 +181,57 @@ public:
 
 inline
 uint64_t StaticView::hash(uint64_t vertex_id) const noexcept {
-    return (vertex_id & m_hash_const) *2;
+    return vertex_id & m_hash_const;
 }
 
-// This method is so critical in scans, that it could be beneficial to have it inline altogether
-inline
-uint64_t StaticView::logical_id(uint64_t vertex_id) const noexcept  {
+template<typename T>
+uint64_t StaticView::lookup(uint64_t vertex_id) const noexcept {
+    constexpr T EMPTY = std::numeric_limits<T>::max();
+    const T* __restrict A = hash_table<T>();
+
     if(m_hash_direct){
-        if(vertex_id >= m_hash_capacity){
+        if(vertex_id >= m_hash_capacity || A[vertex_id] == EMPTY){
             return aux::NOT_FOUND;
         } else {
-            return hash_table()[vertex_id];
+            return A[vertex_id];
         }
     } else {
-        const uint64_t* __restrict A = hash_table();
         uint64_t slot = hash(vertex_id);
 
-        while(A[slot] != aux::NOT_FOUND){
-            // first key is the key vertex_id, the second the value logical_id
-            if( A[slot] == vertex_id ){
-                return A[slot +1];
+        while(A[slot] != EMPTY){
+            // the slot only stores the logical ID, the key is retrieved from the column of the vertex IDs
+            if( m_vertex_ids[A[slot]] == vertex_id ){
+                return A[slot];
             }
 
-            slot += 2;
-            if(slot >= m_hash_capacity){ slot = 0; }
+            slot = (slot +1) & m_hash_const;
         }
 
         return aux::NOT_FOUND;
     }
 }
 
+// This method is so critical in scans, that it could be beneficial to have it inline altogether
 inline
-uint64_t* StaticView::hash_table(){
-    return reinterpret_cast<uint64_t*>(this +1);
+uint64_t StaticView::logical_id(uint64_t vertex_id) const noexcept  {
+    if(m_vertex_ids == nullptr){ // implicit mapping
+        uint64_t logical_id = vertex_id - m_first_vertex_id; // wraps around when vertex_id < m_first_vertex_id
+        return logical_id < m_num_vertices ? logical_id : aux::NOT_FOUND;
+    } else if(m_hash_narrow){
+        return lookup<uint32_t>(vertex_id);
+    } else {
+        return lookup<uint64_t>(vertex_id);
+    }
 }
 
-inline
-const uint64_t* StaticView::hash_table() const {
-    return reinterpret_cast<const uint64_t*>(this +1);
+template<typename T>
+T* StaticView::hash_table(){
+    return reinterpret_cast<T*>(this +1);
+}
+
+template<typename T>
+const T* StaticView::hash_table() const {
+    return reinterpret_cast<const T*>(this +1);
 }
 
 
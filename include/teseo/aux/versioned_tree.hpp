@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "teseo/aux/change.hpp"
+#include "teseo/aux/counting_tree.hpp"
+#include "teseo/util/latch.hpp"
+
+namespace teseo::aux {
+
+class DynamicView; // forward declaration
+
+/**
+ * A counting tree shared by the read-write transactions, with the vertices and the degrees of the last committed
+ * state of the graph. It is kept up to date by the aux cache, as the writers commit.
+ *
+ * Together with the tree, the net effect of each committed transaction on the vertices is retained, as long as
+ * there are active transactions that cannot see it. A transaction translates the vertex IDs, the logical IDs
+ * and the degrees to its own snapshot by reverting the effects of the transactions committed after it, and
+ * adding its own local changes. See DynamicView.
+ *
+ * This class is thread safe.
+ */
+class VersionedTree {
+    friend class DynamicView;
+    VersionedTree(const VersionedTree&) = delete;
+    VersionedTree& operator=(const VersionedTree&) = delete;
+
+public:
+    // The net effect of a committed transaction on a single vertex
+    struct Delta {
+        uint64_t m_transaction_id; // the commit ID of the transaction
+        uint64_t m_vertex_id; // the vertex altered
+        int64_t m_presence; // +1 if the vertex has been inserted, -1 if it has been removed, 0 otherwise
+        int64_t m_degree; // the difference of its degree, a vertex that does not exist has degree 0
+    };
+
+private:
+    CountingTree* m_tree; // the vertices and their degrees, in the last committed state, nullptr until initialised
+    std::vector<Delta> m_deltas; // the effects of the transactions applied to the tree, sorted by commit ID
+    uint64_t m_deltas_offset; // total number of deltas pruned so far from the start of m_deltas
+    std::vector<Change> m_pending; // changes committed while the tree is being initialised
+    uint64_t m_last_commit_id; // the ID of the last writer committed before the changes have started to be recorded
+    uint64_t m_transaction_id; // the tree can only be used by transactions with a read ID >= m_transaction_id
+    bool m_ready; // whether the tree has been initialised
+    mutable util::Latch m_latch; // to provide thread safety
+    std::atomic<int> m_ref_count; // number of incoming pointers to the instance
+
+    // Apply the given changes, all committed by the same transaction, to the tree, and record their effects
+    void apply(const Change* changes, uint64_t num_changes);
+
+    // Destructor, it must be implicitly invoked by #decr_ref_count
+    ~VersionedTree();
+
+public:
+    // Create an instance not ready yet. The changes from the writers committed after the given ID are recorded
+    // until the tree is initialised with #init
+    VersionedTree(uint64_t last_commit_id);
+
+    // Record the changes committed by a writer. Invoked by the aux cache, in commit order. The caller must hold the
+    // latch in write mode since before drawing the commit ID, so that a reader with a greater ID cannot miss the changes.
+    // @return true if the retained deltas have outgrown the tree, and it is cheaper to rebuild it
+    bool commit(const std::vector<Change>& changes);
+
+    // Initialise the content of the tree with the snapshot of the given read ID
+    void init(CountingTree&& tree, uint64_t transaction_id);
+
+    // Discard the effects of the transactions committed before the given ID
+    void prune(uint64_t transaction_id);
+
+    // Check whether the tree can be used
+    bool is_ready() const;
+
+    // Retrieve the min read ID of the transactions that can use the tree
+    uint64_t transaction_id() const;
+
+    // Retrieve the number of retained deltas
+    uint64_t num_deltas() const;
+
+    // Retrieve the number of vertices in the last committed state
+    uint64_t num_vertices() const;
+
+    // Retrieve the latch protecting the instance
+    util::Latch& latch() const;
+
+    // Manage the number of incoming pointers to the instance
+    void incr_ref_count() noexcept;
+    void decr_ref_count() noexcept;
+
+    // Retrieve a string representation of the instance, for debugging purposes
+    std::string to_string() const;
+
+    // Dump the content of the instance to stdout, for debugging purposes
+    void dump() const;
+};
+
+// Print to the output stream a string representation of the instance, for debugging purposes
+std::ostream& operator<<(std::ostream& out, const VersionedTree& tree);
+
+} // namespace
@@ -71,6 +71,7 @@ public:
     // Manage the number of incoming pointers to the class
     void incr_ref_count() noexcept;
     void decr_ref_count() noexcept;
+    int ref_count() const noexcept;
 };
 
 } // namespace
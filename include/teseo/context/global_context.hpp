@@ -20,12 +20,15 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <string>
 
+#include "teseo/aux/ordering.hpp"
 #include "teseo/context/property_snapshot.hpp"
 #include "teseo/context/tc_list.hpp"
 #include "teseo/util/latch.hpp"
 
 namespace teseo::aux { class Cache; } // forward declaration
+namespace teseo::aux { class CostModel; } // forward declaration
 namespace teseo::aux { class View; } // forward declaration
 namespace teseo::context { class ThreadContext; } // forward declaration
 namespace teseo::gc { class GarbageCollector; } // forward declaration
@@ -35,6 +38,7 @@ namespace teseo::profiler { class GlobalRebalanceList; } // forward declaration
 namespace teseo::profiler { class DirectAccessCounters; } // forward declaration
 namespace teseo::runtime { class Runtime; } // forward declaration
 namespace teseo::transaction{ class MemoryPoolList; } // forward declaration
+namespace teseo::transaction{ class RedoLog; } // forward declaration
 namespace teseo::transaction{ class TransactionImpl; } // forward declaration
 namespace teseo::transaction{ class TransactionSequence; } // forward declaration
 
@@ -57,7 +61,12 @@ class GlobalContext {
     profiler::GlobalRebalanceList* m_profiler_rebalances {nullptr}; // record of all rebalances performed
     profiler::DirectAccessCounters* m_profiler_direct_access {nullptr}; // internal profiler to check the effectiveness of the vertex table
     aux::Cache* m_aux_cache { nullptr }; // cache the last created auxiliary view
+    aux::CostModel* m_aux_cost_model { nullptr }; // to decide when the degree queries should be answered by the auxiliary view
+    transaction::RedoLog* m_redo_log { nullptr }; // if enabled, the log where committed transactions are recorded
     bool m_aux_degree_enabled; // whether queries for the degree can be answered with the auxiliary view
+    uint64_t m_aux_cache_memory_budget; // max amount of memory, in bytes, for the views retained by the aux cache
+    std::atomic<uint64_t> m_merger_memory_target; // memory footprint of the leaves, in bytes, above which the merger compacts the sparse array
+    aux::Ordering m_aux_ordering; // the policy to assign the logical IDs in the static views
 
 public:
     /**
@@ -183,6 +192,55 @@ public:
     void disable_aux_cache() noexcept;
     bool is_aux_cache_enabled() const noexcept;
 
+    /**
+     * Retrieve the cache of the auxiliary views, if enabled, or nullptr otherwise
+     */
+    aux::Cache* aux_cache() const noexcept;
+
+    /**
+     * Retrieve the cost model to decide whether the degree queries should be answered by the auxiliary view
+     */
+    aux::CostModel* aux_cost_model() const noexcept;
+
+    /**
+     * Set/retrieve the max amount of memory, in bytes, that the aux cache can use to retain the views of
+     * multiple snapshots. The views of the most recent snapshot are always retained.
+     */
+    void set_aux_cache_memory_budget(uint64_t bytes) noexcept;
+    uint64_t aux_cache_memory_budget() const noexcept;
+
+    /**
+     * Set/retrieve the memory footprint of the leaves, in bytes, above which the periodic passes of the merger
+     * also compact the sparse array. A value of 0 disables the automatic compaction.
+     */
+    void set_merger_memory_target(uint64_t bytes) noexcept;
+    uint64_t merger_memory_target() const noexcept;
+
+    /**
+     * Set/retrieve the policy to assign the logical IDs in the static views, used by read-only transactions.
+     * Altering the policy discards the views already cached. Read-write transactions always assign the
+     * logical IDs in the order of the vertex IDs.
+     */
+    void set_aux_ordering(aux::Ordering ordering) noexcept;
+    aux::Ordering aux_ordering() const noexcept;
+
+    /**
+     * Replay the redo log at the given path, if it exists, and from now on record all committed
+     * transactions in the same log. It must not be invoked while other transactions are active.
+     */
+    void enable_redo_log(const std::string& path);
+
+    /**
+     * Stop recording the committed transactions in the redo log. It must not be invoked while other
+     * transactions are active.
+     */
+    void disable_redo_log();
+
+    /**
+     * Retrieve the redo log, if enabled, or nullptr otherwise
+     */
+    transaction::RedoLog* redo_log() const noexcept;
+
     /**
      * Enable or disable debugger breaks
      */
@@ -29,7 +29,9 @@
 namespace teseo::context { class GlobalContext; } // forward declaration
 namespace teseo::profiler { class EventThread; } // forward declaration
 namespace teseo::profiler { class RebalanceList; } // forward declaration
+namespace teseo::rebalance { class ScratchPad; } // forward declaration
 namespace teseo::transaction { class MemoryPool; } // forward declaration
+namespace teseo::transaction { class MemoryPoolList; } // forward declaration
 namespace teseo::transaction { class TransactionImpl; } // forward declaration
 namespace teseo::transaction { class TransactionSequence; } // forward declaration
 
@@ -48,10 +50,13 @@ class ThreadContext {
     transaction::TransactionList m_tx_list; // sorted list of active transactions
     transaction::TransactionSequence* m_tx_seq; // the sequence of all active transactions
     transaction::MemoryPool* m_tx_pool; // internal memory pool to allocate new transaction
+    transaction::MemoryPoolList* m_undo_cache; // where to acquire the undo buffers for the transactions executed by this thread
     gc::TcQueue m_gc_queue; // internal garbage collector
     PropertySnapshotList m_prop_list; // list of the global alterations performed to the graph (vertex count/edge count)
     profiler::EventThread* m_profiler_events; // profiler events, local to this thread
     profiler::RebalanceList* m_profiler_rebalances; // list of all rebalances done so far inside this thread context
+    rebalance::ScratchPad* m_scratchpad; // working area for the rebalances and merges executed by this thread, reused among them
+    uint64_t* m_segment_buffer; // buffer with the capacity of a sparse segment, used by the removals of vertices
     mutable int m_cache_numa_thread; // the numa node where the underlying thread runs
     int m_num_reader_latches; // total number of segment latches, in `READ` mode, held by the current thread
 
@@ -147,6 +152,17 @@ public:
      */
     profiler::RebalanceList* profiler_rebalances();
 
+    /**
+     * Retrieve the scratchpad for the rebalances and merges executed by this thread. It is allocated on first use and
+     * it keeps the capacity of the largest rebalance performed so far, to avoid reallocating it every time.
+     */
+    rebalance::ScratchPad& scratchpad();
+
+    /**
+     * Retrieve a buffer with the capacity of a sparse segment, in qwords, allocated on first use
+     */
+    uint64_t* segment_buffer();
+
     /**
      * Mark the object for deletion
      */
@@ -163,6 +179,11 @@ public:
      */
     transaction::MemoryPool* transaction_pool();
 
+    /**
+     * Retrieve the list where to acquire & recycle the undo buffers for the transactions executed by this thread
+     */
+    transaction::MemoryPoolList* undo_buffer_cache();
+
     /**
      * Increase the ThreadContext reference count by 1
      */
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <cinttypes>
 #include <vector>
 
 #include "teseo/util/latch.hpp"
@@ -31,7 +33,9 @@ class SimpleQueue; // forward declaration
 /**
  * An instance of the garbage collector. Each Async/Worker thread owns an instance of
  * a garbage collector, to periodically release from memory unused objects. This
- * implementation is epoch based.
+ * implementation is epoch based. The delay between two passes depends on the backlog
+ * left by the previous pass: the passes are delayed while the GC is idle and anticipated
+ * when its queues keep growing.
  *
  * This class is thread safe.
  */
@@ -42,12 +46,17 @@ class GarbageCollector {
     std::vector<SimpleQueue*> m_private_queues; // queues released by the thread contexts
     util::Latch m_latch; // better safe than sorry
     profiler::EventThread* m_profiler; // record the GC usage
+    uint64_t m_backlog; // number of items left in the queues after the last pass
+    std::chrono::milliseconds m_delay; // the delay before the next pass
 
     // Remove all objects in the given queue
     void remove_all(SimpleQueue* queue);
 
-    // Perform a GC pass over the given queue
-    void perform_gc_pass(uint64_t epoch, SimpleQueue* queue);
+    // Perform a GC pass over the given queue. Return the number of items released.
+    uint64_t perform_gc_pass(uint64_t epoch, SimpleQueue* queue, profiler::EventThread* event_thread);
+
+    // Compute the delay before the next pass
+    void update_delay(uint64_t num_items_released);
 
 public:
     /**
@@ -62,8 +71,20 @@ public:
 
     /**
      * Execute a single pass of the garbage collector
+     * @param record_profile whether to record the pass in the profiler of the owner. It must be false when the pass
+     *        is not executed by the thread owning this instance.
+     */
+    void execute(bool record_profile = true);
+
+    /**
+     * Retrieve the delay before the next pass of the garbage collector
+     */
+    std::chrono::milliseconds delay() const;
+
+    /**
+     * Retrieve the number of items that were still present in the queues at the end of the last pass
      */
-    void execute();
+    uint64_t backlog() const;
 
     /**
      * Create a new queue shared between this garbage collector and a thread context
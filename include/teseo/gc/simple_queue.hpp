@@ -59,6 +59,9 @@ public:
     // Retrieve the cardinality of the queue
     uint64_t size() const;
 
+    // Retrieve the max number of elements that can be stored in the queue, before resizing it
+    uint64_t capacity() const;
+
     // Append a single entry in the queue
     bool push(const Item& item);
 
@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+#include "teseo/context/property_snapshot.hpp"
+#include "teseo/memstore/data_item.hpp"
+#include "teseo/memstore/key.hpp"
+#include "teseo/rebalance/weighted_edge.hpp"
+
+namespace teseo::context { class GlobalContext; } // forward declaration
+namespace teseo::rebalance { class ScratchPad; } // forward declaration
+namespace teseo::transaction { class TransactionImpl; } // forward declaration
+
+namespace teseo::memstore {
+
+class Leaf; // forward declaration
+class Memstore; // forward declaration
+
+/**
+ * A binary snapshot of the content of the memstore, stored in a local file.
+ *
+ * The file consists of a header followed by the sequence of vertices and edges visible to a read-only
+ * transaction, sorted by key, in the same format of the elements of a rebalancer's scratchpad: each vertex is
+ * followed by its outgoing edges. The snapshot does not contain versions, thus it can be copied
+ * as it is into the segments of the leaves when restored.
+ */
+class Checkpoint {
+    Checkpoint() = delete; // static methods only
+
+    // The header of the file
+    struct Header {
+        uint64_t m_magic; // to recognise a valid, complete, checkpoint
+        uint64_t m_is_directed; // whether the graph is directed
+        uint64_t m_num_elements; // total number of vertices & edges stored in the file
+        context::GraphProperty m_properties; // number of vertices & edges in the graph
+    };
+
+    // A vertex or an edge stored in the file
+    union Element {
+        Vertex m_vertex;
+        rebalance::WeightedEdge m_edge;
+    };
+
+    // The portion of the checkpoint restored in a single leaf
+    struct LeafRange {
+        uint64_t m_start; // the first element, inclusive
+        uint64_t m_end; // the last element, exclusive
+        uint64_t m_vertex; // the vertex owning the first element, equal to m_start if the range starts with a vertex
+        uint64_t m_space; // total amount of space required, in qwords
+    };
+
+    constexpr static uint64_t MAGIC = 0x7E5E0C4EC4B01;
+
+    // Scan the vertices & edges in the interval [vertex_start, vertex_end) visible to the given transaction
+    static void save(Memstore* memstore, transaction::TransactionImpl* transaction, uint64_t vertex_start, uint64_t vertex_end, std::vector<Element>& out_elements);
+
+    // Split the content of the checkpoint into leaves
+    static std::vector<LeafRange> partition(const Element* elements, uint64_t num_elements);
+
+    // Restore the given range of elements into the given leaf
+    static void restore(Memstore* memstore, Leaf* leaf, const Element* elements, const LeafRange* range, const LeafRange* next, rebalance::ScratchPad& scratchpad);
+
+    // Retrieve the minimum key stored in the given range
+    static Key get_minimum(const Element* elements, const LeafRange* range);
+
+public:
+    /**
+     * Write a snapshot of the current content of the database into the given file. The content of the leaves
+     * is scanned in parallel, by a read-only transaction, and then appended to the file in key order.
+     */
+    static void save(context::GlobalContext* global_context, const std::string& path);
+
+    /**
+     * Load the checkpoint at the given path into the memstore. The database must be empty. The file
+     * is mapped in memory and its content copied in parallel into new leaves, together with their
+     * entries in the index and in the vertex table.
+     */
+    static void restore(context::GlobalContext* global_context, const std::string& path);
+};
+
+} // namespace
@@ -20,6 +20,7 @@
 #include <atomic>
 #include <cassert>
 #include <future>
+#include <limits>
 
 #include "teseo/context/static_configuration.hpp"
 #include "teseo/memstore/key.hpp"
@@ -65,6 +66,8 @@ class Leaf {
 
     util::Latch m_latch; // acquired when a thread needs to rebalance more segments than those contained in a single gate
     bool m_active = false; // true if a rebalancer is currently exploring multiple gates
+    uint8_t m_numa_node = 0; // the NUMA node where the leaf has been allocated
+    uint16_t m_num_tail_rebalances = 0; // number of consecutive rebalances started from the tail of the leaf
     const uint32_t m_num_segments; // number of segments in this leaf
     util::CircularArray<std::promise<void>*> m_queue; // additional rebalancers requesting access to the chunk
     Key m_fence_key; // the max fence key for this leaf
@@ -90,6 +93,22 @@ public:
     static uint64_t data_size_bytes(uint64_t num_segments); // in terms of bytes
     static uint64_t data_size_qwords(uint64_t num_segments); // in terms of qwords (8 bytes)
 
+    /**
+     * Get the size of the allocation for a leaf with the given number of segments, in bytes
+     */
+    static uint64_t allocation_size(uint64_t num_segments);
+
+    /**
+     * Retrieve the total amount of memory, in bytes, currently allocated for the leaves, in all instances of
+     * the memstore
+     */
+    static uint64_t memory_footprint();
+
+    /**
+     * Retrieve the NUMA node where the memory of the leaf resides
+     */
+    int numa_node() const;
+
     /**
      * Retrieve the min fence key for this leaf
      */
@@ -135,6 +154,17 @@ public:
      */
     bool is_active() const;
 
+    /**
+     * Record whether the last rebalance started from the tail of the leaf, that is from its last non empty segment.
+     * Only invoked by the rebalancer currently active on the leaf.
+     */
+    void set_tail_rebalance(bool value);
+
+    /**
+     * Retrieve the number of consecutive rebalances started from the tail of the leaf
+     */
+    uint64_t num_tail_rebalances() const;
+
     /**
      * Check whether this is the first leaf in the fat tree
      */
@@ -189,6 +219,11 @@ uint64_t Leaf::num_segments() const {
     return m_num_segments;
 }
 
+inline
+int Leaf::numa_node() const {
+    return m_numa_node;
+}
+
 inline
 uint64_t Leaf::data_size_bytes(uint64_t num_segments) {
     constexpr uint64_t segment_size = context::StaticConfiguration::memstore_segment_size * sizeof(uint64_t);
@@ -200,6 +235,11 @@ uint64_t Leaf::data_size_qwords(uint64_t num_segments) {
     return data_size_bytes(num_segments) / sizeof(uint64_t);
 }
 
+inline
+uint64_t Leaf::allocation_size(uint64_t num_segments) {
+    return sizeof(Leaf) + data_size_bytes(num_segments) * 2 /* x2 = vertices/edges + weights */;
+}
+
 inline
 void Leaf::lock(){
     m_latch.lock_write();
@@ -220,6 +260,20 @@ bool Leaf::is_active() const {
     return m_active;
 }
 
+inline
+void Leaf::set_tail_rebalance(bool value){
+    if(!value){
+        m_num_tail_rebalances = 0;
+    } else if(m_num_tail_rebalances < std::numeric_limits<decltype(m_num_tail_rebalances)>::max()){
+        m_num_tail_rebalances++;
+    }
+}
+
+inline
+uint64_t Leaf::num_tail_rebalances() const {
+    return m_num_tail_rebalances;
+}
+
 inline
 void Leaf::wait(std::promise<void>* producer){
     m_queue.append(producer);
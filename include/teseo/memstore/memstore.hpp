@@ -134,6 +134,12 @@ public:
     void remove_edge(transaction::TransactionImpl* transaction, uint64_t source, uint64_t destination);
     void remove_edge(transaction::TransactionImpl* transaction, uint64_t source, uint64_t destination, bool directed_only);
 
+    /**
+     * Replay an update recovered from the redo log. No consistency checks are performed, the
+     * update is applied exactly as it was originally stored.
+     */
+    void redo(transaction::TransactionImpl* transaction, const Update& update);
+
     /**
      * Check whether the semantic of edge updates tailors directed graphs
      */
@@ -37,7 +37,7 @@ class RemoveVertex {
     const uint64_t m_vertex_id; // the vertex to remove
     std::vector<uint64_t>* m_outgoing_edges; // the list of outgoing edges removed
     bool m_owns_outgoing_edges; // whether the memory of `m_outgoing_edges' has been allocated by this instance
-    uint64_t* m_scratchpad; // Temporary scratchpad, used to copy & move the versions in a sparse file
+    uint64_t* m_scratchpad; // Temporary scratchpad, used to copy & move the versions in a sparse file, owned by the thread context
 public:
     bool m_unlock_required = false; // Whether we need a further step to unlock the vertices
     uint64_t m_num_items_removed = 0; // Number of items removed so far
@@ -17,10 +17,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cinttypes>
 #include <future>
+#include <limits>
 
 #include "teseo/context/static_configuration.hpp"
 #include "teseo/memstore/key.hpp"
@@ -70,8 +72,10 @@ private:
     static constexpr uint16_t FLAG_FILE_TYPE = 0x1; // is this a dense or sparse file?
     static constexpr uint16_t FLAG_REBAL_REQUESTED = 0x2; // whether a request to rebalance was already sent before?
     static constexpr uint16_t FLAG_VERTEX_TABLE = 0x4; // the Merger s.t. should rebuild the vertex table for the segment
+    static constexpr uint16_t FLAG_PRUNE_REQUESTED = 0x8; // whether a request to prune the versions was already sent before?
 
     uint8_t m_flags; // internal flags
+    std::atomic<uint16_t> m_num_removals; // number of removals since the last pass of the merger, saturated at its max value
     std::atomic<int32_t> m_used_space; // amount of space occupied in the segment, in terms of qwords
 
 public:
@@ -119,9 +123,15 @@ private:
     // Send a request for rebalance
     static void request_async_rebalance(Context& context);
 
+    // Send a request to prune the old versions of the segment, if its versions area is above the threshold
+    static void request_async_prune(Context& context);
+
     // Validate an update against the scratchpad
     static void validate_update(Context& context, rebalance::ScratchPad& scratchpad, const Update* update);
 
+    // Record a removal in the segment. Invoked by the writers while holding the latch
+    void incr_num_removals() noexcept;
+
 public:
     // Retrieve the low fence key of the context's segment
     static Key get_lfkey(const Context& context);
@@ -182,6 +192,9 @@ public:
     // Cancel a previously made request of rebalance
     void cancel_rebalance_request();
 
+    // Check whether a request to prune the versions of this segment was issued
+    bool has_requested_prune() const;
+
     // Check whether it is necessary to perform an async rebalance to this segment
     bool need_async_rebalance() const;
     bool need_async_rebalance(Key lfkey) const;
@@ -287,6 +300,12 @@ public:
     // Request the vertex table to be rebuilt
     void request_rebuild_vertex_table();
 
+    // Retrieve the number of removals performed in the segment since the last pass of the merger
+    uint64_t num_removals() const noexcept;
+
+    // Reset the counter of the removals. Invoked by the merger before pruning the segment
+    void reset_num_removals() noexcept;
+
     // Set the flag `rebal_requested'. Only used for debugging and testing purposes.
     void set_flag_rebal_requested();
 
@@ -364,5 +383,24 @@ void Segment::request_rebuild_vertex_table() {
     set_flag(FLAG_VERTEX_TABLE, 1);
 }
 
+inline
+void Segment::incr_num_removals() noexcept {
+    // single writer, no need for an atomic increment
+    uint16_t value = m_num_removals.load(std::memory_order_relaxed);
+    if(value < std::numeric_limits<uint16_t>::max()){
+        m_num_removals.store(value +1, std::memory_order_relaxed);
+    }
+}
+
+inline
+uint64_t Segment::num_removals() const noexcept {
+    return m_num_removals.load(std::memory_order_relaxed);
+}
+
+inline
+void Segment::reset_num_removals() noexcept {
+    m_num_removals.store(0, std::memory_order_relaxed);
+}
+
 } // namespace
 
@@ -75,8 +75,11 @@ class SparseFile {
     // Overwrite the file attemping to save `target_budget' qwords from the buffer
     void fill(Context& context, rebalance::ScratchPad& buffer, bool is_lhs, int64_t& pos_next_vertex, int64_t& pos_next_element, int64_t target_budget, int64_t* out_budget);
 
-    // Decide how many elements to save in the sparse file
-    std::pair</* elts */ int64_t, /* versions */ int64_t> get_num_elts_to_store(Context& context, const rebalance::ScratchPad& buffer, bool is_lhs, int64_t pos_next_vertex, int64_t pos_next_element, int64_t target_budget, int64_t* out_budget);
+    // Decide how many elements to save in the sparse file. The positions are moved past the elements to save
+    static std::pair</* elts */ int64_t, /* versions */ int64_t> get_num_elts_to_store(Context& context, const rebalance::ScratchPad& buffer, bool is_lhs, int64_t& pos_next_vertex, int64_t& pos_next_element, int64_t target_budget, int64_t* out_budget);
+
+    // The amount of qwords to save in the lhs of the file, out of the whole `target_budget'
+    static int64_t get_target_budget_lhs(int64_t target_budget);
 
     // Copy `num_elements' from the scratchpad to the sparse file
     void save_elements(Context& context, const rebalance::ScratchPad& buffer, bool is_lhs, int64_t& pos_next_vertex, int64_t& pos_next_element, int64_t num_elts);
@@ -223,6 +226,12 @@ public:
      */
     void save(Context& context, rebalance::ScratchPad& buffer, int64_t& pos_next_vertex, int64_t& pos_next_element, int64_t target_budget, int64_t* out_budget_achieved);
 
+    /**
+     * Compute the positions in the buffer and the qwords achieved by #save(), with the same arguments,
+     * without altering the content of any file
+     */
+    static void save_dry_run(Context& context, const rebalance::ScratchPad& buffer, int64_t& pos_next_vertex, int64_t& pos_next_element, int64_t target_budget, int64_t* out_budget_achieved);
+
     /**
      * Remove inaccessible undo records in the history and compact the file
      */
@@ -307,6 +316,11 @@ public:
      */
     uint64_t used_space() const;
 
+    /**
+     * Retrieve the amount of space, in qwords, occupied by the versions area of the file
+     */
+    uint64_t versions_space() const;
+
     /**
      * Check whether the segment is empty
      */
@@ -402,6 +416,11 @@ bool SparseFile::is_rhs_empty() const {
     return m_empty2_start == max_num_qwords();
 }
 
+inline
+uint64_t SparseFile::versions_space() const {
+    return (m_empty1_start - m_versions1_start) + (m_versions2_start - m_empty2_start);
+}
+
 inline
 bool SparseFile::is_dirty() const {
     return is_dirty(true) || is_dirty(false);
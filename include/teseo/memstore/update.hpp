@@ -165,6 +165,16 @@ public:
 
 std::ostream& operator<<(std::ostream& out, const Update& update);
 
+/**
+ * Payload of the undo records for the insertion of an edge. The storage replaces the weight in the (inverse)
+ * update with the previous weight of the record, to restore it on rollback. The weight inserted is retained
+ * separately, to be serialised in the redo log at commit.
+ */
+struct UndoEdgeInsertion {
+    Update m_update; // the inverse of the update performed, must be the first member
+    double m_weight; // the weight of the edge inserted
+};
+
 /*****************************************************************************
  *                                                                           *
  *   Implementation details                                                  *
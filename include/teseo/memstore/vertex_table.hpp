@@ -24,6 +24,7 @@
 #include "teseo/context/static_configuration.hpp"
 #include "teseo/memstore/direct_pointer.hpp"
 #include "teseo/util/circular_array.hpp"
+#include "teseo/util/latch.hpp"
 
 namespace teseo::memstore {
 
@@ -56,6 +57,7 @@ class VertexTable {
     int64_t m_num_elts; // number of elements inserted by the merger
     std::atomic<int64_t> m_num_tombstones; // number of elements removed since the last migration (grow)
     uint64_t m_latch; // mutual protection on grow/migration
+    util::SpinLock m_writer_latch; // serialise the insertions, as the leaves can be pruned by multiple workers concurrently
     util::CircularArray<std::promise<void>*> m_queue; // waiting list
     void* m_allocations[context::StaticConfiguration::numa_num_nodes]; // one per NUMA node, aligned to whatever numa::alloc() returns
     mutable CompressedDirectPointer m_vertex1 alignas(16); // special entry to store the vertex with ID == 1. We use the same ID for the tombstones
@@ -77,6 +79,9 @@ class VertexTable {
     void resize();
     void do_resize();
 
+    // The capacity, in terms of entries, to store the elements currently in the hash table
+    uint64_t num_entries_required() const;
+
     // Acquire an xlock to the latch
     void xlock();
 
@@ -132,7 +137,7 @@ public:
 
     /**
      * Insert (or update) the given entry in the hash table. This method can only be
-     * invoked by the Merger thread
+     * invoked by the workers pruning the segments, either for the merger or asynchronously
      */
     void upsert(uint64_t vertex_id, const DirectPointer& pointer) noexcept;
 
@@ -157,6 +162,17 @@ public:
      */
     DirectPointer get(uint64_t vertex_id, uint64_t numa_node) const noexcept;
 
+    /**
+     * Rehash the table into a smaller capacity, if most of its slots are either empty or tombstones, e.g. after
+     * many vertices have been removed. This method should only be invoked by the merger service, it is serialised with #upsert.
+     */
+    void compact();
+
+    /**
+     * Retrieve the number of entries in the hash table, for debugging purposes
+     */
+    uint64_t capacity() const;
+
     /**
      * Explicitly remove all elements of the vertex table
      */
@@ -113,6 +113,7 @@ enum EventName {
     DF_LOAD,
     /* asynchronous rebalancer */
     ARS_HANDLE_REQUEST,
+    ARS_HANDLE_PRUNE,
     /* crawler */
     CRAWLER_MAKE_PLAN,
     CRAWLER_LOCK2MERGE,
@@ -122,6 +123,7 @@ enum EventName {
     MERGER_MERGE,
     /* runtime */
     RUNTIME_SCHEDULE_REBALANCE,
+    RUNTIME_SCHEDULE_PRUNE,
     /* garbage collector */
     GC_EXECUTE,
     GC_PERFORM_GC_PASS,
@@ -134,6 +136,7 @@ enum EventName {
     /* auxiliary view */
     AUX_STATIC_CREATE,
     AUX_STATIC_BUILD_HASHMAP,
+    AUX_STATIC_UPDATE,
     AUX_DYNAMIC_CREATE,
 };
 
@@ -60,6 +60,9 @@ class Crawler {
     // Get the minimum and maximum amount of space allowed by the density thresholds in the calibrator tree
     std::pair<int64_t, int64_t> get_thresholds(int window_height, uint64_t num_segments_leaf) const;
 
+    // Check whether the given segment is the last non empty segment of the last leaf
+    bool is_tail(uint64_t segment_id) const;
+
 public:
     /**
      * Constructor used by the mergers
@@ -17,19 +17,60 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <vector>
+
 #include "teseo/memstore/context.hpp"
+#include "teseo/memstore/key.hpp"
 
 namespace teseo::rebalance {
 
+class Plan; // forward decl.
 class ScratchPad; // forward decl.
 
+/**
+ * The budget of a single pass of the merger, shared among the operators executing in parallel. The pass stops
+ * once either its time is elapsed or the amount of data pruned exceeds the given number of bytes.
+ */
+class MergeBudget {
+    const std::chrono::steady_clock::time_point m_deadline; // when the pass should stop
+    std::atomic<int64_t> m_qwords; // the remaining amount of data that can be pruned, in qwords
+
+public:
+    /**
+     * Create a new budget, starting from now
+     */
+    MergeBudget(std::chrono::milliseconds time, uint64_t bytes);
+
+    /**
+     * Account for the given amount of data pruned, in qwords
+     */
+    void consume(uint64_t qwords);
+
+    /**
+     * Check whether the pass should stop
+     */
+    bool exhausted() const;
+};
+
 /**
  * This class traverses the leaves in a sparse array, pruning obsolete records
  * and merging together consecutive leaves, where possible.
+ *
+ * The operator only visits the leaves whose low fence key falls in a given key range, so that
+ * multiple operators can sweep disjoint ranges of the sparse array in parallel. The segments without
+ * removals since the last pass are not pruned, as they could not have shrunk in the meanwhile.
+ *
+ * In compact mode, the operator also moves the content of the sparse leaves into smaller leaves, and the
+ * leaves merged together are stored in a leaf as small as possible, rather than reusing the first one.
  */
 class MergeOperator {
     memstore::Context m_context; // ptr to the path memstore -> leaf -> segment
-    ScratchPad* m_scratchpad; // working area, used to merge leaves together
+    ScratchPad* m_scratchpad; // working area, used to merge leaves together, owned by the thread context
+    MergeBudget* m_budget; // the budget of the current pass, nullptr if unlimited
+    const bool m_compact; // whether to shrink the sparse leaves
 
     /**
      * Visit the current leaf, prune all the old records and return and estimate of the
@@ -42,11 +83,27 @@ class MergeOperator {
      */
     std::pair</* last leaf */ memstore::Leaf*, /* space used */ uint64_t> merge(memstore::Leaf* previous, memstore::Leaf* current, uint64_t cardinality, uint64_t used_space);
 
+    /**
+     * Move the content of the given leaf into a smaller leaf, if it is still sparse once locked
+     */
+    std::pair</* new leaf */ memstore::Leaf*, /* space used */ uint64_t> shrink(memstore::Leaf* leaf);
+
+    /**
+     * Execute the given plan, on the leaves already locked
+     */
+    std::pair</* last leaf */ memstore::Leaf*, /* space used */ uint64_t> spread(Plan& plan);
+
+    /**
+     * Check whether the elements of the given leaf, occupying `used_space' qwords, could be stored into a
+     * leaf with at least a quarter fewer segments
+     */
+    static bool is_sparse(const memstore::Leaf* leaf, uint64_t used_space);
+
 public:
     /**
      * Create a new instance of the operator
      */
-    MergeOperator(const memstore::Context& context);
+    MergeOperator(const memstore::Context& context, MergeBudget* budget = nullptr, bool compact = false);
 
     /**
      * Destructor
@@ -54,9 +111,42 @@ public:
     ~MergeOperator();
 
     /**
-     * Execute the operator!
+     * Execute the operator over the leaves with a low fence key in [from, to). Return the key where the
+     * visit stopped because the budget was exhausted, or a key >= `to' if the whole range has been visited.
+     */
+    memstore::Key execute(memstore::Key from, memstore::Key to);
+};
+
+/**
+ * A single pass of the merger, shared among the runtime workers. Each worker repeatedly picks the next
+ * key range to visit, until either all ranges have been visited or the budget has been exhausted.
+ */
+class MergePass {
+    MergePass(const MergePass&) = delete;
+    MergePass& operator=(const MergePass&) = delete;
+
+    memstore::Memstore* const m_memstore; // the sparse array to visit
+    std::vector<std::pair<memstore::Key, memstore::Key>>& m_ranges; // the key ranges [from, to) to visit
+    std::atomic<uint64_t> m_next; // the next range to pick
+    MergeBudget* const m_budget; // nullptr if unlimited
+    const bool m_compact; // whether to shrink the sparse leaves
+
+public:
+    /**
+     * Create a new pass over the given ranges. On completion, the low key of each range is
+     * updated to the key where its visit stopped.
+     */
+    MergePass(memstore::Memstore* memstore, std::vector<std::pair<memstore::Key, memstore::Key>>& ranges, MergeBudget* budget, bool compact = false);
+
+    /**
+     * Visit the ranges until none is left or the budget has been exhausted. Invoked by each worker.
      */
     void execute();
+
+    /**
+     * Retrieve the number of key ranges to visit
+     */
+    uint64_t num_ranges() const;
 };
 
 }
@@ -19,6 +19,10 @@
 
 #include <chrono>
 #include <thread>
+#include <utility>
+#include <vector>
+
+#include "teseo/memstore/key.hpp"
 
 struct event; // libevent forward decl.
 struct event_base; // libevent forward decl.
@@ -26,17 +30,23 @@ namespace teseo::memstore { class Memstore; } // forward declaration
 
 namespace teseo::rebalance {
 
+class MergeBudget; // forward declaration
+
 /**
  * This is a service attached to a single sparse array. It periodically runs
  * on a background thread. It prunes obsolete version/undo records from the
  * sparse array and, where possible, merges two smaller chunks into a single
  * large chunk.
+ *
+ * A sweep of the sparse array is split into key ranges, visited in parallel by the workers of the
+ * runtime. Each periodic pass is bounded by a budget, the next pass resumes the ranges left behind.
  */
 class MergerService {
     struct event_base* m_queue; // libevent's queue
     std::thread m_background_thread; // handle to the background thread
     bool m_eventloop_exec; // true when the service thread is running the event loop
     memstore::Memstore* const m_memstore; // the attached sparse array instance
+    std::vector<std::pair<memstore::Key, memstore::Key>> m_ranges; // the key ranges still to visit in the current sweep, only accessed by the service thread
 
     // Method executed by the background thread, it runs the event loop
     void main_thread();
@@ -47,6 +57,18 @@ class MergerService {
     // Trampoline to invoke the actual Merger routine
     static void callback_execute(int fd, short flags, void* /* MergerCallbackData */ event_argument);
 
+    // Execute a pass of the merger, resuming the current sweep. A nullptr budget is unlimited
+    void execute(MergeBudget* budget, bool compact);
+
+    // Execute a whole sweep of the merger and wait for its completion
+    void execute_sync(bool compact);
+
+    // Check whether the memory footprint of the leaves exceeds the target set in the global context
+    bool above_memory_target() const;
+
+    // Split the key space into the ranges of a new sweep
+    std::vector<std::pair<memstore::Key, memstore::Key>> partition() const;
+
 public:
     /**
      * Create a new instance of the service
@@ -73,6 +95,13 @@ public:
      * Invoke the service synchronously, for debugging purposes
      */
     void execute_now();
+
+    /**
+     * Compact the sparse array synchronously: prune the leaves, merge the consecutive sparse leaves, move the
+     * content of the remaining sparse leaves into smaller leaves and rehash the vertex table down. The memory
+     * released is returned to the OS.
+     */
+    void compact_now();
 };
 
 } // namespace
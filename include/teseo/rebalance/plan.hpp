@@ -43,6 +43,8 @@ class Plan {
     int32_t m_window_end; // the last segment in m_leaf1 to rebalance (exclusive)
     int32_t m_num_output_segments; // total number of segment in the output
     bool m_is_resize; // whether to create a new leaf (or leaves) where to store the output
+    bool m_is_append; // whether the elements are being appended at the end of the leaf to split
+    bool m_is_compact; // whether the output must be stored in leaves as small as possible, rather than reusing a larger first leaf
     uint64_t m_cardinality; // the total number of elements to be copied
 
     // Helper method, fusing the logic of #create_split and #create_merge
@@ -67,6 +69,24 @@ public:
      */
     static Plan create_split(uint64_t cardinality, uint64_t used_space, memstore::Leaf* leaf);
 
+    /**
+     * Factory method, create a new plan to split the last leaf of the fat tree, when the new elements are being
+     * appended in increasing order. Rather than spreading the elements evenly among the output segments, the
+     * existing leaf is filled up to the brim and the rest is moved to a new leaf, with room for the next appends.
+     * @param cardinality an upper bound on the total number of elements to be copied
+     * @param used_space total amount of space occupied by the leaf, in qwords
+     * @param leaf the leaf to split
+     */
+    static Plan create_append(uint64_t cardinality, uint64_t used_space, memstore::Leaf* leaf);
+
+    /**
+     * Factory method, create a new plan to move the elements of a sparse leaf into a new, smaller, leaf
+     * @param cardinality an upper bound on the total number of elements to be copied
+     * @param used_space total amount of space occupied by the leaf, in qwords
+     * @param leaf the leaf to shrink
+     */
+    static Plan create_shrink(uint64_t cardinality, uint64_t used_space, memstore::Leaf* leaf);
+
     /**
      * Factory method, create a `spread' plan
      * @param cardinality an upper bound on the total number of elements to be copied
@@ -91,6 +111,8 @@ public:
     bool is_rebalance() const; // spread the elements in the window of leaf1
     bool is_resize() const; // load the elements from the leaf (or leaves) into a new leaf
     bool is_merge() const; // whether we are merging multiple leaves in the sequence [leaf1, leaf2]
+    bool is_append() const; // whether to split the leaf for the elements appended at its end
+    bool is_compact() const; // whether the first leaf can only be reused when it has exactly the size required
 
     /**
      * Retrieve the first segment of the window to rebalance, inclusive
@@ -144,6 +166,16 @@ public:
      */
     void set_resize(bool value);
 
+    /**
+     * Do we still split the leaf for the appends?
+     */
+    void set_append(bool value);
+
+    /**
+     * Set whether the output should be stored in leaves as small as possible
+     */
+    void set_compact(bool value);
+
     /**
      * Get a string representation of this plan, for debugging purposes
      */
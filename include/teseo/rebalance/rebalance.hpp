@@ -30,5 +30,10 @@ namespace teseo::rebalance {
  */
 void handle_rebalance(memstore::Memstore* memstore, memstore::Key& key);
 
+/**
+ * Handle a request to prune the old versions of the segment with the given fence key
+ */
+void handle_prune(memstore::Memstore* memstore, memstore::Key& key);
+
 
 } // namespace
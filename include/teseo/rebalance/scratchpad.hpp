@@ -42,6 +42,10 @@ class ScratchPad {
     }* m_elements = nullptr;
     memstore::Version* m_versions = nullptr; // array with the versions loaded
 
+    // Allocate & release the underlying buffers
+    static void* allocate(uint64_t size);
+    static void deallocate(void* buffer, uint64_t size);
+
 public:
     /**
      * Create an empty scratchpad, with no capacity.
@@ -113,6 +117,12 @@ public:
      */
     bool has_last_vertex() const;
 
+    /**
+     * Retrieve or reset the position of the last vertex loaded
+     */
+    uint64_t get_last_vertex_position() const;
+    void set_last_vertex_position(uint64_t position);
+
     /**
      * Load a vertex into the scratchpad
      */
@@ -123,6 +133,17 @@ public:
      */
     void load_edge(uint64_t destination, double weight, const memstore::Version* version);
 
+    /**
+     * Append a sequence of vertices & edges, without versions, stored in the same format of the scratchpad
+     */
+    void load(const void* elements, uint64_t num_elements);
+
+    /**
+     * Copy the elements in [start, end) of the given scratchpad, together with their versions, at the given
+     * position. The size of this scratchpad is not altered, see #set_size().
+     */
+    void copy(uint64_t position, const ScratchPad& source, uint64_t start, uint64_t end);
+
     /**
      * Unload the last vertex
      */
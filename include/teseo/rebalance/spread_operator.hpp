@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <vector>
 #include <utility>
 
@@ -26,12 +28,44 @@
 #include "teseo/rebalance/rebalanced_leaf.hpp"
 
 namespace teseo::memstore { class Leaf; } // Forward declarations
+namespace teseo::memstore { class Segment; } // Forward declarations
 
 namespace teseo::rebalance {
 
 // Forward declarations
 class ScratchPad;
 
+/**
+ * A batch of independent items of a spread operation, such as the segments to load or to save, processed
+ * together by the rebalancer and by the runtime workers that happen to be idle. The rebalancer never waits
+ * for a worker to pick up an item: the items still unclaimed are eventually processed by the rebalancer itself.
+ */
+class SpreadJob {
+    SpreadJob(const SpreadJob&) = delete;
+    SpreadJob& operator=(const SpreadJob&) = delete;
+
+    const uint64_t m_num_items; // total number of items to process
+    const std::function<void(uint64_t)> m_callback; // the routine to process a single item
+    std::atomic<uint64_t> m_next; // the next item to claim
+    std::atomic<uint64_t> m_num_done; // the number of items processed so far
+
+public:
+    /**
+     * Create a new job, consisting of the items [0, num_items)
+     */
+    SpreadJob(uint64_t num_items, std::function<void(uint64_t)> callback);
+
+    /**
+     * Process the items not claimed yet. Invoked by both the rebalancer and the helping workers.
+     */
+    void execute();
+
+    /**
+     * Wait for all items to be processed
+     */
+    void wait();
+};
+
 /**
  * Spread the content in the sparse array
  */
@@ -46,11 +80,24 @@ class SpreadOperator {
 
     uint64_t m_space_required = 0; // total amount of space required, in qwords
 
+    // A segment to save, with the positions in the scratchpad computed in advance by a dry run
+    struct SaveItem {
+        memstore::Leaf* m_leaf; // the leaf of the segment
+        memstore::Segment* m_segment; // the segment to fill
+        int64_t m_pos_vertex; // the position of the first vertex to save
+        int64_t m_pos_element; // the position of the first element to save
+        int64_t m_target_budget; // the amount of qwords to fill
+        int64_t m_budget_achieved; // the amount of qwords filled, as computed by the dry run
+    };
+
     // Load the elements from the involved segments into the scratch pad
     void load();
     void load(memstore::Leaf* leaf);
     void load(memstore::Leaf* leaf, uint64_t window_start, uint64_t window_end);
 
+    // Load the content of the rebalanced leaves in batches of segments, in parallel, and concatenate them into the scratchpad
+    void load_parallel();
+
     // Prune the undo records for the elements loaded in the scratch pad
     void prune();
 
@@ -59,7 +106,20 @@ class SpreadOperator {
 
     // Save the elements from the scratchpad back to the segments
     void save();
-    void save(memstore::Leaf* leaf, int64_t window_start, int64_t window_end, uint64_t num_filled_segments, uint64_t& num_segments_saved, uint64_t& budget_achieved, int64_t& pos_vertex, int64_t& pos_element);
+    void save(memstore::Leaf* leaf, int64_t window_start, int64_t window_end, uint64_t num_filled_segments, uint64_t& num_segments_saved, uint64_t& budget_achieved, int64_t& pos_vertex, int64_t& pos_element, std::vector<SaveItem>* deferred);
+    int64_t save(memstore::Leaf* leaf, memstore::Segment* segment, int64_t target_budget, int64_t& pos_vertex, int64_t& pos_element, std::vector<SaveItem>* deferred);
+
+    // Split of the last leaf for the appends: fill the existing leaf up to the brim and move the rest into a new leaf
+    void save_append(uint64_t& budget_achieved, int64_t& pos_vertex, int64_t& pos_element, std::vector<SaveItem>* deferred);
+
+    // The amount of space to store in the existing leaf and the number of segments to fill in the new leaf, in a split for the appends
+    std::pair<int64_t, int64_t> append_layout() const;
+
+    // Save the elements of the deferred segments, in parallel
+    void save_parallel(const std::vector<SaveItem>& items);
+
+    // Process the given items with the help of the idle runtime workers, and wait for all of them to complete
+    void execute(uint64_t num_items, std::function<void(uint64_t)> callback);
 
     // Resolve the fence keys and search keys in the index for the interval rebalanced
     void update_fence_keys();
@@ -0,0 +1,98 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <vector>
+
+#include "teseo/runtime/task.hpp"
+
+namespace teseo::runtime {
+
+/**
+ * A Chase-Lev work-stealing deque of tasks. Only the owner of the deque can push and take the tasks from its bottom,
+ * while any other thread can steal the tasks from its top.
+ *
+ * See N. M. Le, A. Pop, A. Cohen, F. Zappa Nardelli, Correct and Efficient Work-Stealing for Weak Memory Models,
+ * PPoPP 2013.
+ */
+class Deque {
+    Deque(const Deque&) = delete;
+    Deque& operator=(const Deque&) = delete;
+
+    // The underlying storage, a circular array whose capacity is a power of 2
+    struct Array {
+        const int64_t m_capacity;
+        std::atomic<Task>* m_tasks;
+
+        Array(int64_t capacity);
+        ~Array();
+        Task get(int64_t index) const;
+        void put(int64_t index, Task task);
+    };
+
+    alignas(64) std::atomic<int64_t> m_top; // the next task to steal
+    alignas(64) std::atomic<int64_t> m_bottom; // the next free position for the owner
+    std::atomic<Array*> m_array; // the current storage
+    std::vector<Array*> m_retired; // the previous storages, thieves may still read from them, released by the destructor
+
+    // Double the capacity of the storage
+    Array* resize(Array* array, int64_t top, int64_t bottom);
+
+public:
+    /**
+     * Create a new deque with the given initial capacity
+     */
+    Deque(uint64_t capacity = 64);
+
+    /**
+     * Destructor
+     */
+    ~Deque();
+
+    /**
+     * Append a task at the bottom of the deque. Only the owner can invoke this method.
+     */
+    void push(Task task);
+
+    /**
+     * Remove the last task from the bottom of the deque. Only the owner can invoke this method.
+     * Return false if the deque is empty.
+     */
+    bool take(Task* out_task);
+
+    /**
+     * Remove the first task from the top of the deque. Any thread can invoke this method.
+     * Return false if the deque is empty or the task has been removed by another thread in the meanwhile.
+     */
+    bool steal(Task* out_task);
+
+    /**
+     * Retrieve the number of tasks in the deque. The value is only an estimate, unless invoked by the owner
+     * while no other thread is accessing the deque.
+     */
+    uint64_t size() const;
+
+    /**
+     * Check whether the deque is empty. The same considerations of size() apply.
+     */
+    bool empty() const;
+};
+
+} // namespace
@@ -19,12 +19,16 @@
 
 #include "task.hpp"
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 
 #include "teseo/context/static_configuration.hpp"
+#include "teseo/runtime/deque.hpp"
 #include "teseo/runtime/task.hpp"
 #include "teseo/util/circular_array.hpp"
+#include "teseo/util/latch.hpp"
 
 // forward declarations
 namespace teseo::context { class GlobalContext; }
@@ -34,23 +38,75 @@ namespace teseo::runtime { class Worker; }
 
 namespace teseo::runtime {
 
+/**
+ * The task queues of the workers. The tasks bound to a specific worker, such as the GC passes or the registration of
+ * the thread contexts, are always executed by the worker they have been submitted to. The other tasks can be stolen
+ * by the idle workers: those spawned by a worker are pushed in its own work-stealing deque, those submitted by
+ * the other threads in a shared inbox of the target worker. Idle workers spin for a while, then park their thread
+ * until a new task arrives.
+ *
+ * The workers are pinned to the physical cores of the machine and grouped by NUMA node. Idle workers steal first
+ * from the workers on their same node.
+ */
 class Queue {
     const int m_num_workers; // total number of workers
     struct WState {
         Worker* m_worker;
+        int m_cpu_id = -1; // the CPU the worker is pinned to, or -1 if not pinned
+        int m_numa_node = 0; // the NUMA node of the worker
+        Deque m_deque; // stealable tasks spawned by the worker itself
+        util::SpinLock m_latch; // sync the access to the inboxes
+        util::CircularArray<Task> m_pinned; // tasks that must be executed by this worker
+        util::CircularArray<Task> m_shared; // tasks submitted by other threads, they can be stolen
+        std::atomic<uint64_t> m_num_pinned = 0; // number of tasks in m_pinned, read without acquiring the latch
+        std::atomic<uint64_t> m_num_shared = 0; // number of tasks in m_shared, read without acquiring the latch
+        std::atomic<bool> m_can_steal = false; // whether the worker can execute the tasks of the other workers
+        std::atomic<bool> m_parked = false; // whether the worker is, or is about to, wait on the condition variable
+        bool m_signalled = false; // protected by m_mutex, whether the worker has been woken up
         std::mutex m_mutex;
         std::condition_variable m_condvar;
-        util::CircularArray<Task> m_queue;
     };
     WState* m_workers; // The pointer & the queue associated to each worker
+    std::atomic<int> m_num_parked; // number of workers currently parked
+    std::vector<std::vector<int>> m_node_workers; // the workers on each NUMA node
     runtime::Runtime* const m_runtime; // Pointer to the owner of this instance
 
+    // Assign the CPUs and the NUMA nodes to the workers
+    void init_topology();
+
     // Start all the workers
     void start_workers();
 
     // Send a request to terminate all workers, wait for their threads to terminate
     void stop_workers();
 
+    // Check whether the given type of task can be executed by any worker
+    static bool is_stealable(TaskType type);
+
+    // Try to retrieve the next task for the given worker, without waiting
+    bool try_fetch(int worker_id, bool can_steal, Task* out_task);
+
+    // Try to steal a task from the other workers
+    bool steal(int worker_id, Task* out_task);
+
+    // Remove the next pinned task of the given worker
+    bool pop_pinned(WState& winfo, Task* out_task);
+
+    // Remove the next task from the shared inbox of the given worker
+    bool pop_shared(WState& winfo, Task* out_task);
+
+    // Check whether there is a task the given worker could fetch
+    bool has_work(int worker_id, bool can_steal) const;
+
+    // Wait for a new task
+    void park(int worker_id, bool can_steal);
+
+    // Wake up the given worker, if parked
+    void wake(WState& winfo);
+
+    // Wake up a parked worker that can steal tasks, if any
+    void wake_any();
+
 public:
     // Constructor, start the workers
     Queue(runtime::Runtime* runtime);
@@ -79,8 +135,18 @@ public:
     // Total number of workers
     int num_workers() const;
 
-    // Fetch the next task to process. This method is invoked by workers.
-    Task fetch(int worker_id);
+    // The CPU the given worker is pinned to, or -1 if the worker is not pinned
+    int cpu_id(int worker_id) const;
+
+    // The NUMA node of the given worker
+    int numa_node(int worker_id) const;
+
+    // The workers on the given NUMA node. If no worker has been assigned to the node, all workers are returned.
+    const std::vector<int>& workers_on_node(int numa_node) const;
+
+    // Fetch the next task to process. This method is invoked by workers. If `can_steal' is true, the worker
+    // can also fetch the tasks submitted to the other workers.
+    Task fetch(int worker_id, bool can_steal);
 };
 
 /*****************************************************************************
@@ -93,4 +159,14 @@ int Queue::num_workers() const {
     return m_num_workers;
 }
 
+inline
+int Queue::cpu_id(int worker_id) const {
+    return m_workers[worker_id].m_cpu_id;
+}
+
+inline
+int Queue::numa_node(int worker_id) const {
+    return m_workers[worker_id].m_numa_node;
+}
+
 } // namespace
@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "teseo/memstore/key.hpp"
+
+namespace teseo::memstore { class Context; } // forward declaration
+namespace teseo::memstore { class Leaf; } // forward declaration
+namespace teseo::memstore { class Memstore; } // forward declaration
+
+namespace teseo::runtime {
+
+/**
+ * Collect the requests of the writers to rebalance their segments. The requests for the segments of the
+ * same leaf are coalesced into a single task, which is always assigned to the same worker, and the tasks
+ * ready to be processed are picked in order of urgency, that is by the space filled in their segments and
+ * whether other threads are waiting to access them.
+ *
+ * This class is thread-safe.
+ */
+class RebalanceScheduler {
+public:
+    /**
+     * The pending requests for the segments of a single leaf
+     */
+    struct Request {
+        memstore::Memstore* m_memstore; // the sparse array the leaf belongs to
+        const memstore::Leaf* m_leaf; // only used to coalesce the requests, it may have been deleted in the meanwhile
+        std::vector<std::pair<memstore::Key, uint64_t>> m_keys; // the fence keys of the segments to rebalance, with their urgency
+        uint64_t m_urgency; // the total urgency of the request
+        std::chrono::steady_clock::time_point m_deadline; // when the request can be processed
+        int m_worker_id; // the worker handling the request
+
+        // Retrieve the fence keys of the segments to rebalance, most urgent first
+        std::vector<memstore::Key> keys() const;
+    };
+
+private:
+    RebalanceScheduler(const RebalanceScheduler&) = delete;
+    RebalanceScheduler& operator=(const RebalanceScheduler&) = delete;
+
+    std::mutex m_mutex; // sync the access to the pending requests
+    std::unordered_map<const memstore::Leaf*, Request*> m_requests; // the pending requests, by leaf
+
+    // The worker assigned to the given leaf, among the candidates
+    static int worker_id(const memstore::Leaf* leaf, const std::vector<int>& workers);
+
+    // The urgency of the rebalance for the segment in the given context
+    static uint64_t urgency(const memstore::Context& context);
+
+public:
+    /**
+     * Constructor
+     */
+    RebalanceScheduler();
+
+    /**
+     * Destructor. Discard the pending requests.
+     */
+    ~RebalanceScheduler();
+
+    /**
+     * Register a request to rebalance the segment in the given context, with the given fence key. Return true if
+     * this is the first pending request for its leaf, with `out_worker_id' set to the worker that should be
+     * notified, once the given delay has elapsed, to handle it. The worker is chosen among the given candidates,
+     * that is the workers on the NUMA node of the leaf.
+     */
+    bool request(const memstore::Context& context, const memstore::Key& key, const std::vector<int>& workers, std::chrono::milliseconds delay, int* out_worker_id);
+
+    /**
+     * Remove the most urgent request, among those assigned to the given worker and ready to be processed.
+     * The caller is responsible to delete the returned object. Return nullptr if there are no
+     * requests for the given worker.
+     */
+    Request* fetch(int worker_id);
+
+    /**
+     * Retrieve the number of pending requests
+     */
+    uint64_t size();
+};
+
+} // namespace
@@ -17,13 +17,17 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include "teseo/runtime/queue.hpp"
+#include "teseo/runtime/rebalance_scheduler.hpp"
 #include "teseo/runtime/task.hpp"
+#include "teseo/runtime/thread_pool.hpp"
 #include "teseo/runtime/timer_service.hpp"
 
 namespace teseo::aux { class PartialResult; }
+namespace teseo::aux { class StaticView; }
 namespace teseo::context { class GlobalContext; }
 namespace teseo::context { class ThreadContext; }
 namespace teseo::gc { class GarbageCollector; }
@@ -31,6 +35,8 @@ namespace teseo::memstore { class Context; }
 namespace teseo::memstore { class Key; }
 namespace teseo::memstore { class Leaf; }
 namespace teseo::memstore { class Segment; }
+namespace teseo::rebalance { class MergePass; }
+namespace teseo::rebalance { class SpreadJob; }
 namespace teseo::transaction { class MemoryPoolList; }
 
 namespace teseo::runtime {
@@ -42,14 +48,19 @@ namespace teseo::runtime {
  */
 class Runtime {
     context::GlobalContext* m_global_context; // pointer to the owner of this instance
+    RebalanceScheduler m_rebalance_scheduler; // pending requests to rebalance, it must outlive the workers
     Queue m_queue; // workers' queues
     TimerService m_timer_service; // schedule tasks in the future
+    ThreadPool m_thread_pool; // execute the parallel closures of the users
     std::atomic<uint64_t> m_gc_next_counter = 0; // counter to return the next GC
     std::atomic<uint64_t> m_rr_next_counter = 0; // counter to return the next worker in a round robin fashion
 
     // Submit a synchronous task to all workers, wait for its completion before resuming
     void execute_sync(TaskType task_type);
 
+    // Submit a pass of the GC to each worker, to be executed immediately
+    void start_gc();
+
 public:
     // Constructor
     Runtime(context::GlobalContext* global_context);
@@ -66,6 +77,12 @@ public:
     // Retrieve the next worker ID to process a task, in round robin fashion
     int next_worker_id();
 
+    // Retrieve the next worker ID on the given NUMA node, in round robin fashion
+    int next_worker_id(int numa_node);
+
+    // Retrieve the total number of workers
+    int num_workers() const;
+
     // Retrieve a random transaction pool
     transaction::MemoryPoolList* transaction_pool();
 
@@ -77,15 +94,34 @@ public:
     void rebalance_first_leaf(memstore::Memstore* memstore, uint64_t segment_id);
     void rebalance_segment_sync(memstore::Memstore* memstore, const memstore::Key& key);
 
-    // Compute a partial result for the auxiliary view
-    void aux_partial_result(const memstore::Context& context, aux::PartialResult* partial_result);
+    // Compute a partial result for the auxiliary view, preferably by a worker on the given NUMA node
+    void aux_partial_result(const memstore::Context& context, aux::PartialResult* partial_result, int numa_node);
+
+    // Split the interval [0, size) among the workers to either initialise the dictionary of the static view or
+    // to insert its vertices into it, and wait for all of them to complete
+    void aux_build_hashmap(aux::StaticView* view, bool init, uint64_t size);
+
+    // Execute the given pass of the merger on the workers, and wait for all of them to complete
+    void merge_leaves(rebalance::MergePass* pass);
 
-    // Schedule a rebalance
-    void schedule_rebalance(memstore::Memstore* memstore, const memstore::Key& key);
+    // Ask up to `num_workers' workers to help with the items of the given spread job, without waiting for them
+    void spread_job(std::shared_ptr<rebalance::SpreadJob> job, int num_workers);
+
+    // Schedule a rebalance for the segment in the given context. The requests for the same leaf are coalesced.
     void schedule_rebalance(const memstore::Context& context, const memstore::Key& key);
 
-    // Schedule a pass of the GC
-    void schedule_gc_pass(int worker_id);
+    // Retrieve the pending requests to rebalance the segments
+    RebalanceScheduler* rebalance_scheduler();
+
+    // Retrieve the pool of threads executing the parallel closures of the users
+    ThreadPool* thread_pool();
+
+    // Schedule the pruning of the old versions in the segment with the given fence key
+    void schedule_prune(memstore::Memstore* memstore, const memstore::Key& key);
+    void schedule_prune(const memstore::Context& context, const memstore::Key& key);
+
+    // Schedule the next pass of the GC owned by the given worker, after the given delay
+    void schedule_gc_pass(int worker_id, std::chrono::milliseconds delay);
 
     // Schedule a maintenance pass of the cached memory pools, to rebuild their free lists
     void schedule_txnpool_pass(int worker_id);
@@ -19,12 +19,16 @@
 
 #include <cinttypes>
 #include <future>
+#include <memory>
 #include <ostream>
 #include <string>
 
 #include "teseo/memstore/context.hpp"
 
 namespace teseo::aux { class PartialResult; } // forward declaration
+namespace teseo::aux { class StaticView; } // forward declaration
+namespace teseo::rebalance { class MergePass; } // forward declaration
+namespace teseo::rebalance { class SpreadJob; } // forward declaration
 
 namespace teseo::runtime {
 
@@ -37,7 +41,7 @@ enum class TaskType : uint8_t {
     REGISTER_THREAD_CONTEXT, // payload => future
     UNREGISTER_THREAD_CONTEXT, // payload => future
     // Execute a single pass of the garbage collector
-    GC_RUN, // payload => nullptr
+    GC_RUN, // payload => id of the worker owning the GC, the pass can be executed by any worker
     GC_STOP, // payload => future
     GC_TERMINATE, // payload => future
     // Rebuild the free list of the transaction pools
@@ -45,11 +49,14 @@ enum class TaskType : uint8_t {
     // Rebalance
     MEMSTORE_ENABLE_REBALANCE, // payload => nullptr
     MEMSTORE_DISABLE_REBALANCE, // payload => nullptr
-    MEMSTORE_REBALANCE, // payload => ptr TaskRebalance
+    MEMSTORE_REBALANCE, // payload => worker id, the requests assigned to the worker are fetched from the RebalanceScheduler
     MEMSTORE_REBALANCE_SYNC, // payload => ptr SyncTaskRebalance
-    //MEMSTORE_MERGE_LEAVES, // payload, ptr to the memstore
+    MEMSTORE_PRUNE, // payload => ptr TaskRebalance, the key is the fence key of the segment to prune
+    MEMSTORE_MERGE_LEAVES, // payload => ptr to TaskMergeLeaves
+    MEMSTORE_SPREAD_JOB, // payload => ptr to TaskSpreadJob
     // Auxiliary view
     AUX_PARTIAL_RESULT, // payload => ptr to TaskAuxPartialResult
+    AUX_BUILD_HASHMAP, // payload => ptr to TaskAuxBuildHashMap
     // Terminate the worker
     TERMINATE // payload => nullptr
 
@@ -98,6 +105,19 @@ struct SyncTaskRebalance {
     SyncTaskRebalance(std::promise<void>* producer, memstore::Memstore* memstore, const memstore::Key& key);
 };
 
+struct TaskMergeLeaves {
+    std::promise<void>* m_producer;
+    rebalance::MergePass* m_pass;
+
+    TaskMergeLeaves(std::promise<void>* producer, rebalance::MergePass* pass);
+};
+
+struct TaskSpreadJob {
+    std::shared_ptr<rebalance::SpreadJob> m_job; // the job may outlive the rebalancer that created it
+
+    TaskSpreadJob(std::shared_ptr<rebalance::SpreadJob> job);
+};
+
 struct TaskAuxPartialResult {
     memstore::Context m_context;
     aux::PartialResult* m_partial_result;
@@ -105,6 +125,16 @@ struct TaskAuxPartialResult {
     TaskAuxPartialResult(const memstore::Context& context, aux::PartialResult* partial_result);
 };
 
+struct TaskAuxBuildHashMap {
+    std::promise<void>* m_producer;
+    aux::StaticView* m_view;
+    bool m_init; // true => initialise the slots of the dictionary, false => insert the vertices
+    uint64_t m_start; // inclusive
+    uint64_t m_end; // exclusive
+
+    TaskAuxBuildHashMap(std::promise<void>* producer, aux::StaticView* view, bool init, uint64_t start, uint64_t end);
+};
+
 /*****************************************************************************
  *                                                                           *
  *   Implementation details                                                  *
@@ -138,9 +168,25 @@ SyncTaskRebalance::SyncTaskRebalance(std::promise<void>* producer, memstore::Mem
 
 }
 
+inline
+TaskMergeLeaves::TaskMergeLeaves(std::promise<void>* producer, rebalance::MergePass* pass) : m_producer(producer), m_pass(pass) {
+
+}
+
+inline
+TaskSpreadJob::TaskSpreadJob(std::shared_ptr<rebalance::SpreadJob> job) : m_job(job) {
+
+}
+
 inline
 TaskAuxPartialResult::TaskAuxPartialResult(const memstore::Context& context, aux::PartialResult* partial_result) : m_context(context), m_partial_result(partial_result) {
 
 }
 
+inline
+TaskAuxBuildHashMap::TaskAuxBuildHashMap(std::promise<void>* producer, aux::StaticView* view, bool init, uint64_t start, uint64_t end) :
+        m_producer(producer), m_view(view), m_init(init), m_start(start), m_end(end) {
+
+}
+
 } // namespace
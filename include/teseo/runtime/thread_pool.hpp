@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cinttypes>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace teseo::context { class GlobalContext; } // forward declaration
+
+namespace teseo::runtime {
+
+/**
+ * An elastic pool of threads to execute the closures of the users in parallel, e.g. for the graph analytics. The
+ * threads are already registered to the global context, so that they can operate on the transactions & iterators
+ * without paying the cost of registering themselves every time. Threads are spawned on demand, up to
+ * `runtime_pool_max_threads', and terminate after being idle for `runtime_pool_idle_timeout'.
+ *
+ * The pool is distinct from the workers of the runtime: the closures of the users may wait for the tasks
+ * processed by the workers, e.g. to build an auxiliary view, and they must not take their place.
+ *
+ * This class is thread-safe.
+ */
+class ThreadPool {
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    context::GlobalContext* const m_global_context; // the instance the threads are registered to
+    const uint64_t m_max_threads; // max number of threads in the pool
+    std::mutex m_mutex; // sync the access to the queue & the state of the threads
+    std::condition_variable m_condvar; // notify the idle threads
+    std::deque<std::function<void()>> m_queue; // pending jobs
+    std::unordered_map<uint64_t, std::thread> m_threads; // the threads of the pool, by their ID
+    std::vector<uint64_t> m_exited; // the threads that terminated due to the idle timeout, still to be joined
+    uint64_t m_next_thread_id = 0; // the ID for the next thread spawned
+    uint64_t m_num_active = 0; // number of threads still processing jobs
+    uint64_t m_num_idle = 0; // number of threads waiting for a new job
+    bool m_terminate = false; // whether the pool has been stopped
+
+    // Event loop for the threads of the pool
+    void main_thread(uint64_t thread_id);
+
+    // Join the threads that have already terminated. It assumes the caller holds m_mutex.
+    void reap_exited_threads();
+
+public:
+    /**
+     * Constructor. The threads are only spawned once the first jobs are submitted.
+     */
+    ThreadPool(context::GlobalContext* global_context);
+
+    /**
+     * Destructor. Stop the pool.
+     */
+    ~ThreadPool();
+
+    /**
+     * Append a job to execute
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * Split the interval [begin, end) in chunks of `grain' indices and process them in parallel, by the calling thread
+     * and the threads of the pool. Every participating thread invokes `make_body' once, before its first chunk, to
+     * obtain its own function to process the single indices, e.g. with its own copy of a transaction. The method
+     * returns once all indices have been processed and all bodies have been released. If any body raises an
+     * exception, the remaining chunks are skipped and the first exception is rethrown to the caller.
+     */
+    void parallel_for(uint64_t begin, uint64_t end, uint64_t grain, const std::function<std::function<void(uint64_t)>()>& make_body);
+
+    /**
+     * Terminate all threads, discarding the jobs still pending
+     */
+    void stop();
+
+    /**
+     * The maximum number of threads in the pool
+     */
+    uint64_t max_threads() const;
+
+    /**
+     * The number of threads currently alive in the pool
+     */
+    uint64_t num_threads();
+};
+
+/**
+ * A group of closures executed by the threads of the pool, that can be waited for as a whole.
+ *
+ * This class is thread-safe.
+ */
+class TaskGroup {
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    struct State {
+        std::mutex m_mutex; // sync the access to the pending closures
+        std::condition_variable m_condvar; // notify the waiters
+        std::deque<std::function<void()>> m_pending; // closures not started yet
+        uint64_t m_num_running = 0; // number of closures being executed
+        std::exception_ptr m_error; // first exception raised by the closures
+
+        // Execute the next pending closure, if any. Return true if a closure has been executed.
+        bool execute_next();
+    };
+
+    ThreadPool* const m_pool; // the pool executing the closures
+    std::shared_ptr<State> m_state; // shared with the jobs in the pool, which may start after this group has been released
+
+public:
+    /**
+     * Create a new group, whose closures will be executed by the given pool
+     */
+    TaskGroup(ThreadPool* pool);
+
+    /**
+     * Destructor. Wait for the closures still pending, ignoring their errors.
+     */
+    ~TaskGroup();
+
+    /**
+     * Execute the given closure asynchronously
+     */
+    void run(std::function<void()> closure);
+
+    /**
+     * Wait for all closures to complete. The calling thread also executes the closures not started yet.
+     * Rethrow the first exception raised by the closures, if any.
+     */
+    void wait();
+};
+
+} // namespace
@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <cinttypes>
+
+#include "teseo/context/static_configuration.hpp"
 #include "teseo/util/circular_array.hpp"
 #include "teseo/util/latch.hpp"
 
@@ -25,9 +28,12 @@ namespace teseo::profiler { class EventThread; } // forward declaration
 namespace teseo::transaction {
 
 class MemoryPool; // forward declaration
+class UndoBuffer; // forward declaration
 
 /**
- * A cache to reuse "almost empty" memory pools to create new transactions.
+ * A cache to reuse "almost empty" memory pools to create new transactions. It also retains the
+ * undo buffers released by the terminated transactions, so that they can be recycled by the next
+ * transactions rather than going through malloc again.
  *
  * This class is thread safe.
  */
@@ -40,6 +46,15 @@ class MemoryPoolList {
     util::CircularArray<MemoryPool*> m_idle; // memory pools that are still filled
     profiler::EventThread* m_profiler; // internal profiler
 
+    // Undo buffers are recycled only when their size is a power of two multiple of transaction_undo_buffer_size
+    constexpr static uint64_t m_undo_num_classes = __builtin_ctzll(context::StaticConfiguration::transaction_undo_buffer_max_size / context::StaticConfiguration::transaction_undo_buffer_size) +1;
+    util::SpinLock m_undo_latch; // to protect the free lists of undo buffers
+    UndoBuffer* m_undo_free_lists[m_undo_num_classes]; // released undo buffers, one free list for each size class
+    uint64_t m_undo_cached_bytes; // total amount of space, in bytes, retained by the free lists
+
+    // Retrieve the size class for the given buffer size, or -1 if the buffer cannot be recycled
+    static int undo_size_class(uint32_t buffer_sz);
+
     // Helper
     void dump_queue(const char* name, const util::CircularArray<MemoryPool*>& queue) const;
 
@@ -74,6 +89,22 @@ public:
      */
     void cleanup();
 
+    /**
+     * Acquire an undo buffer with the given capacity, in bytes. It recycles a previously released
+     * buffer if one of the same size is available.
+     */
+    UndoBuffer* acquire_undo_buffer(uint32_t buffer_sz);
+
+    /**
+     * Return the given undo buffer to the free lists, or deallocate it if it cannot be retained
+     */
+    void release_undo_buffer(UndoBuffer* undo_buffer);
+
+    /**
+     * Retrieve the amount of space, in bytes, currently retained in the free lists of undo buffers
+     */
+    uint64_t undo_cached_bytes() const;
+
     /**
      * Reset the internal profiler
      */
@@ -0,0 +1,143 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "teseo/context/property_snapshot.hpp"
+#include "teseo/util/latch.hpp"
+
+namespace teseo::context { class GlobalContext; } // forward declaration
+
+namespace teseo::transaction {
+
+class TransactionImpl; // forward declaration
+
+/**
+ * An append-only redo log of the committed transactions, stored in a local file.
+ *
+ * At commit, a read-write transaction serialises the updates recorded in its undo buffers into
+ * one of the partitions of the log, chosen by the thread ID, and then waits for its record to become
+ * durable. A background flusher writes the content of all partitions to the file and syncs them
+ * with a single fdatasync, so that all transactions that committed in the meanwhile share the
+ * same flush (group commit).
+ *
+ * The log can be replayed with #recover, in parallel by ranges of source vertices.
+ */
+class RedoLog {
+    RedoLog(const RedoLog&) = delete;
+    RedoLog& operator=(const RedoLog&) = delete;
+
+    // Header of each transaction stored in the log
+    struct TxnHeader {
+        uint32_t m_magic; // to recognise a truncated or corrupted tail of the log
+        uint32_t m_num_updates; // number of updates following the header
+        uint64_t m_transaction_id; // the commit time of the transaction
+        context::GraphProperty m_changes; // changes to the number of vertices & edges in the graph
+    };
+
+    // A single update stored in the log
+    struct TxnUpdate {
+        uint64_t m_source; // the source vertex
+        uint64_t m_destination; // the destination vertex, 0 for vertices
+        double m_weight; // the weight of the edge
+        uint32_t m_flags; // FLAG_VERTEX, FLAG_INSERT
+        uint32_t m_unused; // padding
+    };
+
+    constexpr static uint32_t MAGIC = 0x7E5E0106;
+    constexpr static uint32_t FLAG_VERTEX = 0x1;
+    constexpr static uint32_t FLAG_INSERT = 0x2;
+
+    // Buffer where the committers append their records
+    struct Partition {
+        util::SpinLock m_latch; // to protect the buffer
+        std::vector<uint8_t> m_buffer; // records not flushed yet
+    };
+
+    const std::string m_path; // path to the log file
+    int m_fd; // file descriptor of the log file
+    const uint64_t m_num_partitions; // number of partitions
+    Partition* m_partitions; // the buffers where committers append their records
+    std::atomic<uint64_t> m_lsn_appended = 0; // number of records appended to the log so far
+    uint64_t m_lsn_durable = 0; // the records appended up to this number have been synced to the file
+    int m_error = 0; // the errno of the last write or sync failed, if any
+    bool m_terminate = false; // request the flusher to stop
+    std::mutex m_mutex; // to sync the flusher and the committers
+    std::condition_variable m_condvar_flusher; // to wake up the flusher
+    std::condition_variable m_condvar_durable; // to wake up the committers waiting for their record to be synced
+    std::thread m_flusher; // the background thread writing the log to the file
+
+    // Main loop of the flusher
+    void main_flusher();
+
+    // Write all records appended up to this point to the file and sync it
+    // @param buffer scratch space to collect the records from all partitions
+    // @param out_lsn the last lsn synced
+    // @return 0 on success, otherwise the errno of the failed operation
+    int flush(std::vector<uint8_t>& buffer, uint64_t* out_lsn);
+
+    // Replay the given sequence of updates, sorted by source and commit time, in the storage
+    struct RecoveredUpdate;
+    static void replay(context::GlobalContext* global_context, const RecoveredUpdate* updates, uint64_t num_updates);
+
+public:
+    /**
+     * Open (or create) the log at the given path, in append mode
+     */
+    RedoLog(const std::string& path);
+
+    /**
+     * Flush the pending records & close the log
+     */
+    ~RedoLog();
+
+    /**
+     * Append the updates performed by the given transaction to the log.
+     * @param transaction the transaction being committed
+     * @param transaction_id the commit time of the transaction
+     * @return the lsn to wait for, to ensure the changes are durable, or 0 if the transaction did not alter the graph
+     */
+    uint64_t append(const TransactionImpl* transaction, uint64_t transaction_id);
+
+    /**
+     * Wait for the record with the given lsn to be synced to the file
+     */
+    void wait(uint64_t lsn);
+
+    /**
+     * Retrieve the path to the log file
+     */
+    const std::string& path() const noexcept;
+
+    /**
+     * Replay the log at the given path in the storage of the given database. Missing files are
+     * considered as empty logs. A truncated record at the end of the log is ignored.
+     * @return the number of transactions replayed
+     */
+    static uint64_t recover(context::GlobalContext* global_context, const std::string& path);
+};
+
+} // namespace
@@ -31,6 +31,7 @@
  *                                                                           *
  *****************************************************************************/
 namespace teseo::aux {
+    class Cache;
     class View;
 }
 namespace teseo::context {
@@ -42,6 +43,7 @@ namespace teseo::memstore {
     class Segment;
 }
 namespace teseo::transaction {
+    class RedoLog;
     class RollbackInterface;
     class TransactionWriteLatch;
     class UndoBuffer;
@@ -60,6 +62,8 @@ namespace teseo::transaction {
  * The actual implementation of a user transaction
  */
 class TransactionImpl {
+    friend class aux::Cache;
+    friend class RedoLog;
     friend class TransactionWriteLatch;
     friend class Undo;
 
@@ -86,6 +90,7 @@ class TransactionImpl {
     const bool m_read_only; // true if the transaction has flagged as read only upon creation
     mutable void* m_aux_view {nullptr}; // one or more materialised views, one per numa node, with the degrees of all vertices.
     mutable uint32_t m_aux_degree = 0; // number of queries for the degree
+    uint64_t m_aux_degree_hint = 0; // number of queries for the degree expected by the user, 0 if unknown
 
     // Mark the transaction as unreachable from the user.
     void mark_user_unreachable();
@@ -195,7 +200,13 @@ public:
     aux::View* aux_view(bool numa_aware = false) const;
 
     // Check whether we are allowed to use the aux view to answer a request for the degree
-    bool aux_use_for_degree() const noexcept;
+    bool aux_use_for_degree() const;
+
+    // Check whether the cost of the last request for the degree, answered by the memstore, should be sampled for the cost model
+    bool aux_sample_degree() const noexcept;
+
+    // Set the number of requests for the degree expected by the user
+    void aux_degree_hint(uint64_t num_queries) noexcept;
 
     // Retrieve the degree for the given vertex from the auxiliary view
     uint64_t aux_degree(uint64_t vertex_id, bool logical) const;
@@ -31,24 +31,50 @@ class TransactionImpl; // forward decl.
  * An ordered list of the active transactions. Each thread context owns an instance of a list
  * for the transactions that were created inside that context.
  *
+ * The list is a chain of fixed-size segments. A new segment is appended when all slots in the
+ * existing segments are taken, so that there is no limit on the number of transactions that can
+ * be active inside a thread. Segments are never moved or released until the list is destroyed, so
+ * that the slots can always be accessed by concurrent readers and by #remove.
+ *
+ * The list also keeps track of the minimum transaction ID among its active transactions. As the IDs
+ * are assigned in increasing order, the minimum only needs to be recomputed when its transaction is
+ * removed, so that #high_water_mark does not need to scan the list.
+ *
  * To guarantee thread-safety we have a bit of protocol to follow:
- * - Only the local thread can invoke #insert, so there is only one writer
+ * - Only the local thread can invoke #insert
  * - The field `m_version' acts as a latch, if mod 2 == 0 => free, mod 2 = 1 => busy
- * - Only #insert can modify the field m_transaction_sz
- * - The method #remove can be invoked by any thread, it sets the related cell to nullptr
- * - snapshot & high_water_mark can be invoked by any thread, the field m_version will operate like an
+ * - Only #insert can modify the fields m_transaction_sz, m_transactions_capacity and the chain of segments
+ * - The method #remove can be invoked by any thread, it sets the related cell to nullptr. Both #insert
+ *   and #remove acquire the latch in exclusive mode
+ * - snapshot can be invoked by any thread, the field m_version will operate like an
  *   optimistic latch on the field m_version
+ * - high_water_mark can be invoked by any thread, it only reads the field m_high_water_mark
  */
 class TransactionList {
     // This class is non copyable.
     TransactionList(const TransactionList&) = delete;
     TransactionList& operator=(const TransactionList&);
 
+    constexpr static uint64_t m_segment_capacity = 32; // Number of transactions that can be stored in each segment
+    struct Segment {
+        TransactionImpl* m_transactions[m_segment_capacity]; // The actual list of active transactions
+        Segment* m_next; // The next segment in the chain
+    };
+
     std::atomic<uint64_t> m_version = 0; // To ensure thread safety
-    constexpr static uint64_t m_transactions_capacity = 32; // Max number of transactions that can be active inside a thread
-    uint64_t m_transactions_sz = 0; // Number of transactions present in the list so far
-    TransactionImpl* m_transactions[m_transactions_capacity]; // The actual list of active transactions
+    uint64_t m_transactions_sz = 0; // Number of slots used in the list so far, across all segments
+    uint64_t m_transactions_capacity = m_segment_capacity; // Number of slots available in the allocated segments
+    Segment m_head; // The first segment is embedded in the list
+    Segment* m_tail; // The last segment in the chain
     volatile uint64_t m_highest_writer_id = 0; // The max transaction ID among the writers registered in this list
+    std::atomic<uint64_t> m_high_water_mark; // The min transaction ID among the active transactions in the list
+
+    // Acquire/release the latch in exclusive mode
+    void writer_lock();
+    void writer_unlock();
+
+    // Recompute the min transaction ID among the active transactions. It assumes the latch has already been acquired
+    void recompute_high_water_mark();
 
 public:
     /**
@@ -79,7 +105,8 @@ public:
     TransactionSequence snapshot(uint64_t max_transaction_id) const;
 
     /**
-     * Retrieve the minimum transaction ID stored in the list
+     * Retrieve the minimum transaction ID stored in the list, or std::numeric_limits<uint64_t>::max() if the
+     * list is empty
      */
     uint64_t high_water_mark() const;
 
@@ -53,6 +53,9 @@ public:
     // The id associated to this update
     uint64_t transaction_id() const;
 
+    // The data structure where the update has been performed
+    const RollbackInterface* data_structure() const;
+
     // Pointer to the payload associated to this undo entry
     void* payload() const;
 
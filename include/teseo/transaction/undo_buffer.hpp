@@ -22,6 +22,7 @@
 namespace teseo::transaction {
 
 class MemoryPool; // forward decl.
+class MemoryPoolList; // forward decl.
 
 /**
  * Memory space for multiple undo records
@@ -41,6 +42,7 @@ public:
     uint32_t m_space_left; // amount of space left in the buffer, in bytes
     const uint32_t m_space_total; // total amount of space in the buffer, in bytes
     UndoBuffer* m_next {nullptr}; // pointer to the next undo log in the chain
+    MemoryPoolList* m_cache {nullptr}; // where to return this buffer once released, if any
 
     // Access the underlying buffer
     const uint8_t* buffer() const;
@@ -54,6 +56,9 @@ public:
 
     // Deallocate the given buffer
     static void deallocate(UndoBuffer* undobuffer);
+
+    // Return the given buffer to the cache it was acquired from, or deallocate it if it does not have one
+    static void recycle(UndoBuffer* undobuffer);
 };
 
 /*****************************************************************************
@@ -27,6 +27,9 @@ namespace teseo::util {
 struct System {
     // Retrieve the host name of the underlying machine
     static std::string hostname();
+
+    // Return the free memory retained by the allocator back to the OS, where supported
+    static void release_memory();
 };
 
 } // namespace
@@ -19,6 +19,7 @@
 
 #include <cinttypes>
 #include <string>
+#include <vector>
 
 namespace teseo::util {
 
@@ -42,6 +43,16 @@ static int get_cpu_id();
  */
 static int get_numa_id();
 
+/**
+ * Get the list of the CPUs where the current thread is allowed to run
+ */
+static std::vector<int> get_affinity();
+
+/**
+ * Pin the current thread to the given CPU
+ */
+static void set_affinity(int cpu_id);
+
 /**
  * Get the process ID associated to this process
  */
@@ -16,7 +16,9 @@
  */
 #include "teseo/aux/builder.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <thread>
 
 #if defined(HAVE_NUMA)
 #include <numa.h>
@@ -36,47 +38,63 @@ using namespace std;
 
 namespace teseo::aux {
 
-Builder::Builder() : m_num_partial_results(0), m_num_collected_results(0) {
+Builder::Builder() : m_num_collected_results(0), m_waiting(false), m_num_active_producers(0) {
 
 }
 
 Builder::~Builder(){
+    // remove all partial results not consumed yet, the workers may still be computing them
+    for(uint64_t i = m_num_collected_results; i < m_slots.size(); i++){
+        wait(m_slots[i]);
+        delete m_slots[i];
+    }
 
-    // remove all partial results still in the queue
-    auto deleter = [](uint64_t key, PartialResult* partial_result){
-        delete partial_result;
-        return true;
-    };
-    m_queue.scan(0, numeric_limits<uint64_t>::max(), deleter);
+    // a worker may still be notifying the consumer
+    while(m_num_active_producers > 0){ this_thread::yield(); }
 }
 
 PartialResult* Builder::issue(const memstore::Key& from, const memstore::Key& to) {
-    PartialResult* partial_result = new PartialResult(this, m_num_partial_results, from, to);
-    m_num_partial_results++;
+    PartialResult* partial_result = new PartialResult(this, m_slots.size(), from, to);
+    try {
+        m_slots.push_back(partial_result);
+    } catch(...){
+        delete partial_result;
+        throw;
+    }
     return partial_result;
 }
 
 void Builder::collect(PartialResult* partial_result){
     assert(partial_result != nullptr && "Null pointer");
-    { // restrict the scope
+    m_num_active_producers++; // before the consumer can observe the flag
+    partial_result->set_ready();
+
+    // wake up the consumer only if it is sleeping. If the consumer starts waiting concurrently, either it observes
+    // the flag set above, or we observe m_waiting == true
+    if(m_waiting){
         scoped_lock<mutex> xlock(m_mutex);
-        uint64_t id = partial_result->id();
-        m_queue.insert(id, partial_result);
+        m_condvar.notify_one();
     }
-    m_condvar.notify_one();
+
+    m_num_active_producers--;
 }
 
-PartialResult* Builder::next(){
-    auto& queue = m_queue;
+void Builder::wait(PartialResult* partial_result){
+    if(partial_result->is_ready()) return; // fast path
 
     unique_lock<mutex> xlock(m_mutex);
-    PartialResult* partial_result = nullptr;
-    uint64_t next = m_num_collected_results;
-    if(next == m_num_partial_results) return nullptr;
-    m_condvar.wait(xlock, [&queue, &partial_result, next](){
-        return queue.remove(next, &partial_result);
-    });
+    m_waiting = true;
+    m_condvar.wait(xlock, [partial_result](){ return partial_result->is_ready(); });
+    m_waiting = false;
+}
+
+PartialResult* Builder::next(){
+    if(m_num_collected_results == m_slots.size()) return nullptr;
+
+    PartialResult* partial_result = m_slots[m_num_collected_results];
+    wait(partial_result);
     m_num_collected_results++;
+
     return partial_result;
 }
 
@@ -93,21 +111,18 @@ ItemUndirected* Builder::create_dv_undirected(uint64_t num_vertices){
                 pos++;
             }
 
-            for(uint64_t i = 0, end = partial_result->size(); i < end; i++){
-                assert(pos >= 0 && "Underflow");
-                assert(pos < (int64_t) num_vertices && "Overflow");
+            // the first vertex may have been already been started by the previous partial result
+            uint64_t size = partial_result->size();
+            assert(pos >= 0 && "Underflow");
+            assert(pos + size <= num_vertices && "Overflow");
+            COUT_DEBUG("[" << partial_result << " (id: " << partial_result->id() <<")] size: " << size << ", pos: " << pos);
+            array[pos].m_vertex_id = partial_result->at(0).m_vertex_id;
+            array[pos].m_degree += partial_result->at(0).m_degree;
 
-                auto item = partial_result->at(i);
-
-                COUT_DEBUG("[" << partial_result << " (id: " << partial_result->id() <<") @ " << i << "] " << item << ", pos: " << pos);
-                array[pos].m_vertex_id = item.m_vertex_id;
-                array[pos].m_degree += item.m_degree;
-
-                // next iteration
-                pos++;
-            }
+            // copy the rest as a single block
+            std::copy(&(partial_result->at(0)) +1, &(partial_result->at(0)) + size, array + pos +1);
 
-            pos--; // for the next partial result
+            pos += size -1; // for the next partial result
         }
 
         // next iteration
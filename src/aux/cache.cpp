@@ -16,82 +16,495 @@
  */
 #include "teseo/aux/cache.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
+#include <optional>
 #include <sstream>
 
+#include "teseo/aux/builder.hpp"
+#include "teseo/aux/counting_tree.hpp"
+#include "teseo/aux/dynamic_view.hpp"
 #include "teseo/aux/static_view.hpp"
+#include "teseo/aux/versioned_tree.hpp"
+#include "teseo/context/global_context.hpp"
+#include "teseo/context/scoped_epoch.hpp"
+#include "teseo/context/thread_context.hpp"
+#include "teseo/memstore/memstore.hpp"
+#include "teseo/memstore/update.hpp"
+#include "teseo/transaction/rollback_interface.hpp"
+#include "teseo/transaction/transaction_impl.hpp"
+#include "teseo/transaction/undo.hpp"
+#include "teseo/transaction/undo_buffer.hpp"
 #include "teseo/util/latch.hpp"
 
 using namespace std;
+using namespace teseo::transaction;
 
 namespace teseo::aux {
 
-Cache::Cache() : m_transaction_id(0) {
-    for(uint64_t i = 0; i < NUM_NODES; i++){
-        m_views[i] = nullptr;
-    }
+Cache::Cache(uint64_t memory_budget, Ordering ordering) : m_entry(nullptr), m_changes_lbound(numeric_limits<uint64_t>::max()), m_memory_footprint(0), m_memory_budget(memory_budget),
+        m_changes_start(0), m_build_in_progress(false), m_build_transaction_id(0), m_build_generation(0), m_ordering(ordering),
+        m_dynamic(nullptr), m_last_commit_id(numeric_limits<uint64_t>::max()) {
+
 }
 
 Cache::~Cache() {
-    unset();
+    for(Entry* entry : m_versions){
+        delete_entry(entry);
+    }
+
+    if(m_dynamic != nullptr){
+        m_dynamic->decr_ref_count(); m_dynamic = nullptr;
+    }
 }
 
-bool Cache::get(uint64_t transaction_id, uint64_t highest_txn_rw_id, aux::StaticView** output){
-    util::WriteLatch xlock(m_latch);
+void Cache::get(memstore::Memstore* memstore, TransactionImpl* transaction, aux::StaticView** output){
+    const uint64_t transaction_id = transaction->ts_read();
+    if(get_if_cached(transaction_id, output)) return; // fast path
+
+    // single flight, wait for the views being built by an older transaction, they may be suitable as well
+    unique_lock<mutex> lock(m_build_mutex);
+    while(m_build_in_progress && m_build_transaction_id <= transaction_id){
+        uint64_t generation = m_build_generation;
+        m_build_condvar.wait(lock, [this, generation](){ return m_build_generation != generation; });
+
+        lock.unlock();
+        if(get_if_cached(transaction_id, output)) return;
+        lock.lock();
+    }
+
+    // otherwise, the views in progress are for a newer transaction and not suitable, build our own
+    bool is_builder = !m_build_in_progress;
+    if(is_builder){
+        m_build_in_progress = true;
+        m_build_transaction_id = transaction_id;
+    }
+    lock.unlock();
+
+    try {
+        build(memstore, transaction, output);
+    } catch(...){
+        if(is_builder){
+            lock.lock();
+            m_build_in_progress = false;
+            m_build_generation++;
+            lock.unlock();
+            m_build_condvar.notify_all();
+        }
+        throw;
+    }
+
+    if(is_builder){
+        lock.lock();
+        m_build_in_progress = false;
+        m_build_generation++;
+        lock.unlock();
+        m_build_condvar.notify_all();
+    }
+}
+
+bool Cache::has_view(uint64_t transaction_id) const {
+    context::ScopedEpoch epoch; // protect the entry from the garbage collector
+
+    // same logic of #get_if_cached
+    uint64_t changes_lbound = m_changes_lbound.load();
+    Entry* entry = m_entry.load();
+    return entry != nullptr && entry->m_transaction_id <= transaction_id && transaction_id < changes_lbound;
+}
+
+bool Cache::has_dynamic(uint64_t transaction_id) const {
+    util::ReadLatch slock(m_latch);
+    return m_dynamic != nullptr && m_dynamic->is_ready() && m_dynamic->transaction_id() <= transaction_id;
+}
+
+DynamicView* Cache::get_dynamic(memstore::Memstore* memstore, TransactionImpl* transaction){
+    uint64_t high_water_mark = 0; // the min transaction ID among the active transactions
+    { // without holding the latch
+        context::ScopedEpoch epoch; // the thread must be inside an epoch to retrieve the high water mark
+        high_water_mark = context::global_context()->high_water_mark();
+    }
+
+    VersionedTree* tree = acquire_dynamic();
+    if(tree == nullptr){ // single flight
+        scoped_lock<mutex> lock(m_dynamic_mutex);
+        tree = acquire_dynamic(); // built by another transaction in the meanwhile?
+        if(tree == nullptr){ tree = build_dynamic(memstore); }
+    }
+
+    tree->prune(high_water_mark);
+    DynamicView* view = nullptr;
+    try {
+        view = DynamicView::create_undirected(tree, transaction);
+    } catch(...){
+        tree->decr_ref_count();
+        throw;
+    }
+    tree->decr_ref_count();
+
+    return view;
+}
+
+VersionedTree* Cache::acquire_dynamic(){
+    util::ReadLatch slock(m_latch);
+    if(m_dynamic == nullptr || !m_dynamic->is_ready()) return nullptr;
+    m_dynamic->incr_ref_count();
+    return m_dynamic;
+}
+
+VersionedTree* Cache::build_dynamic(memstore::Memstore* memstore){
+    VersionedTree* tree = nullptr;
+    { // start recording the changes of the writers
+        util::WriteLatch xlock(m_latch);
+        if(m_dynamic != nullptr){ // not initialised yet, or dropped while being initialised
+            m_dynamic->decr_ref_count();
+        }
+        m_dynamic = tree = new VersionedTree(m_last_commit_id);
+        tree->incr_ref_count(); // one reference for the cache, one for the caller
+    }
+
+    // scan the memstore with a new read-only transaction
+    TransactionImpl* transaction = context::thread_context()->create_transaction(/* read only ? */ true);
+    try {
+        Builder builder;
+        memstore->aux_view(transaction, &builder);
+        CountingTree* ct = builder.create_ct_undirected();
+        tree->init(move(*ct), transaction->ts_read());
+        delete ct; ct = nullptr;
+
+        transaction->commit();
+        transaction->decr_user_count();
+    } catch(...){
+        transaction->commit();
+        transaction->decr_user_count();
+
+        util::WriteLatch xlock(m_latch);
+        if(m_dynamic == tree){
+            m_dynamic->decr_ref_count();
+            m_dynamic = nullptr;
+        }
+        tree->decr_ref_count();
+        throw;
+    }
+
+    return tree;
+}
+
+bool Cache::get_if_cached(uint64_t transaction_id, aux::StaticView** output){
+    context::ScopedEpoch epoch; // protect the entry from the garbage collector
 
-    if(m_views[0] == nullptr){ // the cache is empty
+    // the bound must be read before the entry, see #set and #commit
+    uint64_t changes_lbound = m_changes_lbound.load();
+    Entry* entry = m_entry.load();
+
+    if(entry == nullptr){ // the cache is empty
+        return false;
+    } else if(transaction_id < entry->m_transaction_id){ // the cached view is too recent
         return false;
-    } else if(highest_txn_rw_id > m_transaction_id){ // the cache became invalid
-        unset();
+    } else if(changes_lbound <= transaction_id){ // some changes may be visible to the transaction
         return false;
-    } else if(transaction_id >= m_transaction_id){
+    } else {
         for(uint64_t i = 0; i < NUM_NODES; i++){
-            m_views[i]->incr_ref_count();
-            output[i] = m_views[i];
+            entry->m_views[i]->incr_ref_count();
+            output[i] = entry->m_views[i];
         }
-
         return true;
-    } else { // transaction_id < m_transaction_id
-        return false;
     }
 }
 
+void Cache::build(memstore::Memstore* memstore, TransactionImpl* transaction, aux::StaticView** output){
+    const uint64_t transaction_id = transaction->ts_read();
+
+    if(!derive(transaction_id, output)){
+        StaticView::create_undirected(memstore, transaction, output, NUM_NODES, m_ordering);
+        set(output, transaction_id);
+    }
+}
+
+bool Cache::derive(uint64_t transaction_id, aux::StaticView** output){
+    StaticView* previous[NUM_NODES];
+    vector<Change> changes;
+
+    { // critical section
+        util::WriteLatch xlock(m_latch);
+        if(transaction_id < m_changes_start){ return false; } // the changes before the transaction have not been recorded
+
+        // search for a snapshot with the same content
+        for(auto it = m_versions.rbegin(); it != m_versions.rend(); it++){
+            Entry* entry = *it;
+            if(is_valid(entry, transaction_id)){
+                for(uint64_t i = 0; i < NUM_NODES; i++){
+                    entry->m_views[i]->incr_ref_count();
+                    output[i] = entry->m_views[i];
+                }
+                return true;
+            }
+        }
+
+        // otherwise, derive the views from the most recent snapshot older than the transaction
+        auto it = upper_bound(begin(m_versions), end(m_versions), transaction_id, [](uint64_t transaction_id, const Entry* entry){
+            return transaction_id < entry->m_transaction_id;
+        });
+        if(it == begin(m_versions)){ return false; } // all cached views are more recent
+        Entry* entry = *(it -1);
+
+        for(uint64_t i = 0; i < NUM_NODES; i++){
+            entry->m_views[i]->incr_ref_count();
+            previous[i] = entry->m_views[i];
+        }
+
+        // the changes visible to the transaction, that is with a commit ID < transaction_id
+        changes.assign(begin(m_changes) + changes_lower_bound(entry->m_transaction_id), begin(m_changes) + changes_lower_bound(transaction_id));
+    }
+
+    // derive the new views outside the critical section, to not stall the committers
+    try {
+        StaticView::create_undirected(previous[0], changes, output, NUM_NODES);
+    } catch(...){
+        for(uint64_t i = 0; i < NUM_NODES; i++){ previous[i]->decr_ref_count(); }
+        throw;
+    }
+    for(uint64_t i = 0; i < NUM_NODES; i++){ previous[i]->decr_ref_count(); }
+
+    set(output, transaction_id);
+
+    return true;
+}
+
+uint64_t Cache::changes_lower_bound(uint64_t transaction_id) const {
+    auto it = lower_bound(begin(m_changes), end(m_changes), transaction_id, [](const Change& change, uint64_t transaction_id){
+        return change.m_transaction_id < transaction_id;
+    });
+    return it - begin(m_changes);
+}
+
+bool Cache::is_valid(const Entry* entry, uint64_t transaction_id) const {
+    uint64_t from = min(entry->m_transaction_id, transaction_id);
+    uint64_t to = max(entry->m_transaction_id, transaction_id);
+    if(from < m_changes_start) return false; // we cannot tell
+
+    // no changes committed between the two snapshots
+    uint64_t pos = changes_lower_bound(from);
+    return pos == m_changes.size() || m_changes[pos].m_transaction_id >= to;
+}
+
 void Cache::set(aux::StaticView** views, uint64_t transaction_id){
+    uint64_t high_water_mark = 0; // the min transaction ID among the active transactions
+    { // without holding the latch
+        context::ScopedEpoch epoch; // the thread must be inside an epoch to retrieve the high water mark
+        high_water_mark = context::global_context()->high_water_mark();
+    }
+
     util::WriteLatch xlock(m_latch);
+    if(transaction_id < m_changes_start) return; // some changes after the views may have not been recorded
 
-    if(transaction_id > m_transaction_id){
-        unset();
+    auto it = lower_bound(begin(m_versions), end(m_versions), transaction_id, [](const Entry* entry, uint64_t transaction_id){
+        return entry->m_transaction_id < transaction_id;
+    });
+    if(it != end(m_versions) && (*it)->m_transaction_id == transaction_id) return; // already cached
 
-        for(uint64_t i = 0; i < NUM_NODES; i++){
-            views[i]->incr_ref_count();
-            m_views[i] = views[i];
+    Entry* entry = new Entry();
+    entry->m_transaction_id = transaction_id;
+    entry->m_memory_footprint = 0;
+    for(uint64_t i = 0; i < NUM_NODES; i++){
+        views[i]->incr_ref_count();
+        entry->m_views[i] = views[i];
+        entry->m_memory_footprint += views[i]->memory_footprint();
+    }
+    m_versions.insert(it, entry);
+    m_memory_footprint += entry->m_memory_footprint;
+
+    if(entry == m_versions.back()){ // most recent snapshot, publish it to the readers without a latch
+        m_entry = entry;
+
+        // the bound must be updated after the entry has been published, see #get_if_cached
+        uint64_t pos = changes_lower_bound(transaction_id);
+        m_changes_lbound = pos < m_changes.size() ? m_changes[pos].m_transaction_id : numeric_limits<uint64_t>::max();
+    }
+
+    evict(high_water_mark);
+}
+
+void Cache::evict(uint64_t high_water_mark){
+    // the views that are not the most recent ones for any active or future transaction, that is all transactions
+    // with an ID >= high_water_mark, cannot be used anymore, neither as they are, nor to derive newer views
+    uint64_t i = 0;
+    while(i +1 < m_versions.size()){
+        if(m_versions[i +1]->m_transaction_id <= high_water_mark){
+            unset(i);
+        } else {
+            i++;
+        }
+    }
+
+    // memory budget, evict first the views not referenced by any transaction, from the oldest
+    for(int pass = 0; pass < 2 && m_memory_footprint > m_memory_budget; pass++){
+        i = 0;
+        while(i +1 < m_versions.size() && m_memory_footprint > m_memory_budget){
+            if(pass == 1 || m_versions[i]->m_views[0]->ref_count() == 1 /* only the cache */){
+                unset(i);
+            } else {
+                i++;
+            }
         }
+    }
 
-        m_transaction_id = transaction_id;
+    // the changes before the oldest view and all active transactions are not needed anymore
+    uint64_t changes_start = high_water_mark;
+    if(!m_versions.empty()){ changes_start = min(changes_start, m_versions[0]->m_transaction_id); }
+    if(changes_start > m_changes_start){
+        m_changes.erase(begin(m_changes), begin(m_changes) + changes_lower_bound(changes_start));
+        m_changes_start = changes_start;
     }
 }
 
-void Cache::unset(){
-    if(m_views[0] != nullptr){
-        for(uint64_t i = 0; i < NUM_NODES; i++){
-            m_views[i]->decr_ref_count();
-            m_views[i] = nullptr;
+void Cache::unset(uint64_t position){
+    assert(position < m_versions.size());
+    assert(m_versions[position] != m_entry && "The most recent views are only removed by #unset_all");
+    Entry* entry = m_versions[position];
+    m_versions.erase(begin(m_versions) + position);
+    m_memory_footprint -= entry->m_memory_footprint;
+    context::thread_context()->gc_mark(entry, delete_entry);
+}
+
+void Cache::unset_all(){
+    m_entry = nullptr;
+    for(Entry* entry : m_versions){
+        context::thread_context()->gc_mark(entry, delete_entry);
+    }
+    m_versions.clear();
+    m_memory_footprint = 0;
+}
+
+void Cache::delete_entry(void* pointer){
+    Entry* entry = reinterpret_cast<Entry*>(pointer);
+    for(uint64_t i = 0; i < NUM_NODES; i++){
+        entry->m_views[i]->decr_ref_count();
+    }
+    delete entry;
+}
+
+uint64_t Cache::commit(TransactionImpl* transaction){
+    context::GlobalContext* global_context = transaction->m_global_context;
+    vector<Change> changes = Cache::changes(transaction); // outside the critical section
+    if(changes.empty()){ return global_context->next_transaction_id(); }
+
+    // the commit ID must be drawn in the critical section, so that a reader with a greater ID cannot fetch
+    // the log before the changes of this transaction have been appended
+    util::WriteLatch xlock(m_latch);
+    std::optional<util::WriteLatch> xlock_dynamic; // the readers of the shared tree cannot miss the changes either
+    if(m_dynamic != nullptr){ xlock_dynamic.emplace(m_dynamic->latch()); }
+
+    if(m_versions.empty()){ // there is no view to update, do not record the changes
+        uint64_t transaction_id = global_context->next_transaction_id();
+        m_changes_start = transaction_id +1;
+        commit_dynamic(changes, transaction_id, xlock_dynamic);
+        return transaction_id;
+    }
+
+    // the readers without a latch must observe a change as soon as they can draw a greater ID, thus lower the
+    // bound before drawing the commit ID
+    bool is_first_change = m_changes_lbound == numeric_limits<uint64_t>::max();
+    if(is_first_change){ m_changes_lbound = m_versions.back()->m_transaction_id; }
+    uint64_t transaction_id = global_context->next_transaction_id();
+
+    for(auto& change: changes){
+        change.m_transaction_id = transaction_id;
+        m_changes.push_back(change);
+    }
+    if(is_first_change){ m_changes_lbound = transaction_id; }
+
+    // applying the changes is not cheaper anymore than rebuilding the view from scratch
+    if(m_changes.size() > max(m_versions.back()->m_views[0]->num_vertices(), context::StaticConfiguration::aux_cache_changes_min_capacity)){
+        unset_all();
+        m_changes.clear();
+        m_changes_lbound = numeric_limits<uint64_t>::max();
+        m_changes_start = transaction_id +1;
+    }
+
+    commit_dynamic(changes, transaction_id, xlock_dynamic);
+
+    return transaction_id;
+}
+
+void Cache::commit_dynamic(vector<Change>& changes, uint64_t transaction_id, std::optional<util::WriteLatch>& xlock_dynamic){
+    m_last_commit_id = transaction_id;
+    if(m_dynamic == nullptr) return;
+
+    for(auto& change : changes){ change.m_transaction_id = transaction_id; }
+    bool outgrown = m_dynamic->commit(changes);
+
+    // applying the changes is not cheaper anymore than rebuilding the tree from scratch
+    if(outgrown){
+        xlock_dynamic.reset();
+        m_dynamic->decr_ref_count();
+        m_dynamic = nullptr;
+    }
+}
+
+void Cache::set_memory_budget(uint64_t bytes){
+    m_memory_budget = bytes;
+}
+
+uint64_t Cache::num_versions() const {
+    util::WriteLatch xlock(m_latch);
+    return m_versions.size();
+}
+
+vector<Change> Cache::changes(const TransactionImpl* transaction) {
+    const RollbackInterface* memstore = transaction->m_global_context->memstore();
+
+    // The undo records are stored from the newest to the oldest. Reverse the order, to record the changes as they were performed.
+    vector<const memstore::Update*> updates;
+    for(const UndoBuffer* undo_buffer = transaction->m_undo_last; undo_buffer != nullptr; undo_buffer = undo_buffer->m_next){
+        uint64_t offset = undo_buffer->m_space_left;
+        while(offset < undo_buffer->m_space_total){
+            const Undo* undo = reinterpret_cast<const Undo*>(undo_buffer->buffer() + offset);
+            if(undo->is_active() && undo->data_structure() == memstore){
+                const memstore::Update* update = reinterpret_cast<const memstore::Update*>(undo->payload());
+                if(!update->is_empty()){ updates.push_back(update); }
+            }
+            offset += undo->length();
+        }
+    }
+
+    vector<Change> changes;
+    changes.reserve(updates.size());
+    for(auto it = updates.rbegin(); it != updates.rend(); it++){
+        const memstore::Update* undo = *it; // the undo stores the inverse of the update performed
+        Change change;
+        change.m_transaction_id = 0; // set at commit
+        change.m_vertex_id = undo->source();
+        if(undo->is_vertex()){
+            change.m_type = undo->is_remove() ? Change::INSERT_VERTEX : Change::REMOVE_VERTEX;
+        } else {
+            change.m_type = undo->is_remove() ? Change::INCR_DEGREE : Change::DECR_DEGREE;
         }
+        changes.push_back(change);
     }
+
+    return changes;
 }
 
 string Cache::to_string() const {
     stringstream ss;
     util::WriteLatch xlock(m_latch);
 
-    ss << "transaction_id: " << m_transaction_id << ", views: [";
-    for(uint64_t i = 0; i < NUM_NODES; i++){
+    ss << "versions: [";
+    for(uint64_t i = 0; i < m_versions.size(); i++){
         if(i > 0) ss << ", ";
-        ss << m_views[i];
+        ss << "{transaction_id: " << m_versions[i]->m_transaction_id << ", views: [";
+        for(uint64_t j = 0; j < NUM_NODES; j++){
+            if(j > 0) ss << ", ";
+            ss << m_versions[i]->m_views[j];
+        }
+        ss << "]}";
     }
-    ss << "]";
-
+    ss << "], memory footprint: " << m_memory_footprint << "/" << m_memory_budget << " bytes";
+    ss << ", changes: " << m_changes.size() << ", changes start: " << m_changes_start;
+    ss << ", shared tree: ";
+    if(m_dynamic != nullptr){ ss << "{" << m_dynamic->to_string() << "}"; } else { ss << "none"; }
 
     return ss.str();
 }
@@ -0,0 +1,44 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "teseo/aux/change.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace teseo::aux {
+
+string Change::to_string() const {
+    stringstream ss;
+    ss << "transaction id: " << m_transaction_id << ", vertex id: " << m_vertex_id << ", type: ";
+    switch(m_type){
+    case INSERT_VERTEX: ss << "insert vertex"; break;
+    case REMOVE_VERTEX: ss << "remove vertex"; break;
+    case INCR_DEGREE: ss << "degree +1"; break;
+    case DECR_DEGREE: ss << "degree -1"; break;
+    }
+    return ss.str();
+}
+
+ostream& operator<<(ostream& out, const Change& change){
+    out << change.to_string();
+    return out;
+}
+
+} // namespace
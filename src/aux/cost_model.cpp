@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "teseo/aux/cost_model.hpp"
+
+#include <sstream>
+
+#include "teseo/context/static_configuration.hpp"
+
+using namespace std;
+
+namespace teseo::aux {
+
+CostModel::CostModel() : m_cost_lookup(context::StaticConfiguration::aux_cost_lookup), m_cost_build(context::StaticConfiguration::aux_cost_build) {
+
+}
+
+void CostModel::update(atomic<double>& average, double sample){
+    // exponential moving average. Concurrent updates may get lost, we don't need to be precise here
+    double previous = average.load(memory_order_relaxed);
+    average.store(previous + (sample - previous) / 8.0, memory_order_relaxed);
+}
+
+void CostModel::record_lookup(uint64_t nanosecs){
+    update(m_cost_lookup, static_cast<double>(nanosecs));
+}
+
+void CostModel::record_build(uint64_t num_elements, uint64_t nanosecs){
+    if(num_elements == 0) return; // too small to be relevant
+    update(m_cost_build, static_cast<double>(nanosecs) / num_elements);
+}
+
+double CostModel::lookup_cost() const {
+    return m_cost_lookup.load(memory_order_relaxed);
+}
+
+double CostModel::build_cost(uint64_t num_elements) const {
+    return m_cost_build.load(memory_order_relaxed) * num_elements;
+}
+
+bool CostModel::use_aux_view(uint64_t num_lookups, uint64_t expected_lookups, uint64_t num_elements, bool is_cached) const {
+    if(is_cached) return true; // no need to build the view
+
+    uint64_t remaining_lookups = expected_lookups > num_lookups ? expected_lookups - num_lookups : num_lookups;
+    return remaining_lookups * lookup_cost() > build_cost(num_elements);
+}
+
+string CostModel::to_string() const {
+    stringstream ss;
+    ss << "lookup cost: " << lookup_cost() << " ns, build cost: " << m_cost_build.load(memory_order_relaxed) << " ns per vertex/edge";
+    return ss.str();
+}
+
+ostream& operator<<(ostream& out, const CostModel& model){
+    out << model.to_string();
+    return out;
+}
+
+} // namespace
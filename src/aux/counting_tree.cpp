@@ -714,6 +714,31 @@ pair<const ItemUndirected*, uint64_t> CountingTree::get_by_vertex_id(uint64_t ve
     return const_cast<CountingTree*>(this)->get_by_vertex_id(vertex_id); // C++ bloatware
 }
 
+uint64_t CountingTree::rank(uint64_t vertex_id) const {
+    const Node* node = m_root; // start from the root
+    assert(node != nullptr);
+
+    uint64_t cumulative_sum = 0;
+    for(int depth = 0, l = m_height -1; depth < l; depth++){
+        const InternalNode* inode = reinterpret_cast<const InternalNode*>(node);
+        uint64_t i = 0, N = inode->N -1;
+        assert(N > 0 && N <= m_inode_B);
+        const uint64_t* __restrict keys = KEYS(inode);
+        const uint64_t* __restrict ranks = RANKS(inode);
+        while(i < N && keys[i] <= vertex_id) {
+            cumulative_sum += ranks[i];
+            i++;
+        }
+        node = CHILDREN(inode)[i];
+    }
+
+    const Leaf* leaf = reinterpret_cast<const Leaf*>(node);
+    uint64_t i = 0, N = leaf->N;
+    const ItemUndirected* __restrict elts = ELEMENTS(leaf);
+    while(i < N && elts[i].m_vertex_id < vertex_id) i++;
+    return cumulative_sum + i;
+}
+
 bool CountingTree::get_by_vertex_id_optimistic(uint64_t vertex_id, util::OptimisticLatch<0>& latch, uint64_t version, ItemUndirected* output_item, uint64_t* output_rank) const {
     assert(context::thread_context()->epoch() != std::numeric_limits<uint64_t>::max() && "Usage of optimistic latches => Need to be inside an epoch to protect yourself from the G.C.");
 
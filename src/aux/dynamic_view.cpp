@@ -17,10 +17,17 @@
 
 #include "teseo/aux/dynamic_view.hpp"
 
+#include <algorithm>
+#include <iostream>
 #include <limits>
 #include <mutex>
+#include <vector>
 
 #include "teseo/aux/builder.hpp"
+#include "teseo/aux/cache.hpp"
+#include "teseo/aux/change.hpp"
+#include "teseo/aux/cost_model.hpp"
+#include "teseo/aux/versioned_tree.hpp"
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/scoped_epoch.hpp"
 #include "teseo/context/static_configuration.hpp"
@@ -30,6 +37,7 @@
 #include "teseo/util/error.hpp"
 #include "teseo/util/numa.hpp"
 #include "teseo/util/thread.hpp"
+#include "teseo/util/timer.hpp"
 
 using namespace std;
 using namespace teseo::util;
@@ -38,18 +46,29 @@ using scoped_lock_t = std::lock_guard<OptimisticLatch<0>>;
 
 namespace teseo::aux {
 
-DynamicView::DynamicView(CountingTree&& tree) : View(/* is static ? */ false), m_tree(move(tree)) {
+DynamicView::DynamicView(CountingTree&& tree) : View(/* is static ? */ false), m_tree(move(tree)),
+        m_shared(nullptr), m_transaction_id(0), m_shared_position(0), m_diffs_num_vertices(0) {
 
 }
 
-DynamicView::~DynamicView(){
+DynamicView::DynamicView(VersionedTree* shared, uint64_t transaction_id) : View(/* is static ? */ false),
+        m_shared(shared), m_transaction_id(transaction_id), m_shared_position(0), m_diffs_num_vertices(0) {
+    m_shared->incr_ref_count();
+}
 
+DynamicView::~DynamicView(){
+    if(m_shared != nullptr){
+        m_shared->decr_ref_count(); m_shared = nullptr;
+    }
 }
 
 DynamicView* DynamicView::create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction) {
     profiler::ScopedTimer profiler { profiler::AUX_DYNAMIC_CREATE };
     assert(!transaction->is_read_only() && "Expected a read-write transaction");
 
+    util::Timer timer;
+    timer.start();
+
     Builder builder;
     memstore->aux_view(transaction, &builder);
     CountingTree* ct = builder.create_ct_undirected();
@@ -60,10 +79,177 @@ DynamicView* DynamicView::create_undirected(memstore::Memstore* memstore, transa
 
     delete ct; ct = nullptr;
 
+    // sample the cost to build a view from scratch
+    timer.stop();
+    context::ScopedEpoch epoch; // to retrieve the graph properties
+    context::GraphProperty properties = transaction->graph_properties();
+    context::global_context()->aux_cost_model()->record_build(properties.m_vertex_count + properties.m_edge_count, timer.nanoseconds());
+
+    return view;
+}
+
+DynamicView* DynamicView::create_undirected(VersionedTree* shared, transaction::TransactionImpl* transaction) {
+    profiler::ScopedTimer profiler { profiler::AUX_DYNAMIC_CREATE };
+    assert(!transaction->is_read_only() && "Expected a read-write transaction");
+
+    // the changes already performed by the transaction, in the order they were executed
+    vector<Change> changes = Cache::changes(transaction);
+    stable_sort(begin(changes), end(changes), [](const Change& c1, const Change& c2){ return c1.m_vertex_id < c2.m_vertex_id; });
+
+    util::ReadLatch slock(shared->m_latch);
+    if(!shared->m_ready || transaction->ts_read() < shared->m_transaction_id) return nullptr;
+
+    void* heap = util::NUMA::malloc(sizeof(DynamicView));
+    DynamicView* view = new (heap) DynamicView{ shared, transaction->ts_read() };
+    scoped_lock_t xlock(view->m_latch);
+    view->m_shared_position = shared->m_deltas_offset;
+    view->shared_sync();
+
+    // add the local changes of the transaction
+    for(uint64_t i = 0, sz = changes.size(); i < sz; ){
+        const uint64_t vertex_id = changes[i].m_vertex_id;
+        uint64_t degree_before = 0;
+        const bool existed = view->shared_get(vertex_id, &degree_before);
+        bool exists = existed;
+        int64_t degree = existed ? degree_before : 0;
+
+        while(i < sz && changes[i].m_vertex_id == vertex_id){
+            switch(changes[i].m_type){
+            case Change::INSERT_VERTEX: exists = true; degree = 0; break;
+            case Change::REMOVE_VERTEX: exists = false; break;
+            case Change::INCR_DEGREE: degree++; break;
+            case Change::DECR_DEGREE: degree--; break;
+            }
+            i++;
+        }
+        if(!exists){ degree = 0; }
+        assert(degree >= 0 && "Negative degree");
+
+        view->shared_add_diff(vertex_id, static_cast<int64_t>(exists) - static_cast<int64_t>(existed), degree - static_cast<int64_t>(existed ? degree_before : 0));
+    }
+
     return view;
 }
 
+void DynamicView::shared_sync() const {
+    const vector<VersionedTree::Delta>& deltas = m_shared->m_deltas;
+    const uint64_t offset = m_shared->m_deltas_offset;
+
+    // the deltas already pruned were committed before all active transactions, they are visible to this transaction
+    for(uint64_t i = max(m_shared_position, offset) - offset, sz = deltas.size(); i < sz; i++){
+        const VersionedTree::Delta& delta = deltas[i];
+        if(delta.m_transaction_id >= m_transaction_id){ // not visible to the transaction, revert it
+            shared_add_diff(delta.m_vertex_id, -delta.m_presence, -delta.m_degree);
+        }
+    }
+
+    m_shared_position = offset + deltas.size();
+}
+
+void DynamicView::shared_add_diff(uint64_t vertex_id, int64_t presence, int64_t degree) const {
+    if(presence == 0 && degree == 0) return; // nop
+
+    Diff& diff = m_diffs[vertex_id];
+    diff.m_presence += presence;
+    diff.m_degree += degree;
+    assert(diff.m_presence >= -1 && diff.m_presence <= 1);
+    m_diffs_num_vertices += presence;
+
+    if(diff.m_presence == 0 && diff.m_degree == 0){
+        m_diffs.erase(vertex_id);
+    }
+}
+
+bool DynamicView::shared_get(uint64_t vertex_id, uint64_t* out_degree) const {
+    const ItemUndirected* item = m_shared->m_tree->get_by_vertex_id(vertex_id).first;
+    int64_t presence = item != nullptr ? 1 : 0;
+    int64_t degree = item != nullptr ? item->m_degree : 0;
+
+    auto it = m_diffs.find(vertex_id);
+    if(it != m_diffs.end()){
+        presence += it->second.m_presence;
+        degree += it->second.m_degree;
+    }
+    assert(presence == 0 || presence == 1);
+    assert(degree >= 0);
+
+    if(out_degree != nullptr){ *out_degree = degree; }
+    return presence > 0;
+}
+
+uint64_t DynamicView::shared_vertex_id(uint64_t logical_id) const {
+    if(logical_id >= shared_num_vertices()) return NOT_FOUND;
+    const CountingTree* tree = m_shared->m_tree;
+    const int64_t tree_size = tree->size();
+
+    // visit the vertices that are present only in the snapshot or only in the shared tree, in order. In between
+    // these vertices, the logical IDs of the snapshot are the ranks in the shared tree plus a constant offset
+    int64_t offset = 0;
+    bool has_previous = false;
+    uint64_t previous = 0;
+    for(const auto& entry : m_diffs){
+        const uint64_t vertex_id = entry.first;
+        const int64_t presence = entry.second.m_presence;
+        if(presence == 0) continue;
+
+        int64_t rank = static_cast<int64_t>(logical_id) - offset;
+        if(rank >= 0 && rank < tree_size){
+            uint64_t candidate = tree->get_by_rank(rank)->m_vertex_id;
+            if((!has_previous || candidate > previous) && candidate < vertex_id){ return candidate; }
+        }
+        if(presence > 0 && static_cast<int64_t>(tree->rank(vertex_id)) + offset == static_cast<int64_t>(logical_id)){
+            return vertex_id;
+        }
+
+        offset += presence;
+        has_previous = true;
+        previous = vertex_id;
+    }
+
+    int64_t rank = static_cast<int64_t>(logical_id) - offset;
+    if(rank >= 0 && rank < tree_size){
+        uint64_t candidate = tree->get_by_rank(rank)->m_vertex_id;
+        if(!has_previous || candidate > previous){ return candidate; }
+    }
+
+    return NOT_FOUND;
+}
+
+uint64_t DynamicView::shared_logical_id(uint64_t vertex_id) const {
+    if(!shared_get(vertex_id, nullptr)) return NOT_FOUND;
+
+    int64_t rank = m_shared->m_tree->rank(vertex_id);
+    for(auto it = m_diffs.begin(); it != m_diffs.end() && it->first < vertex_id; it++){
+        rank += it->second.m_presence;
+    }
+
+    return rank;
+}
+
+uint64_t DynamicView::shared_degree(uint64_t id, bool is_logical) const {
+    uint64_t vertex_id = is_logical ? shared_vertex_id(id) : id;
+    if(vertex_id == NOT_FOUND) return NOT_FOUND;
+
+    uint64_t degree = 0;
+    if(shared_get(vertex_id, &degree)){
+        return degree;
+    } else {
+        return NOT_FOUND;
+    }
+}
+
+uint64_t DynamicView::shared_num_vertices() const {
+    return static_cast<int64_t>(m_shared->m_tree->size()) + m_diffs_num_vertices;
+}
+
 uint64_t DynamicView::vertex_id(uint64_t logical_id) const noexcept {
+    if(m_shared != nullptr){
+        scoped_lock_t xlock(m_latch);
+        util::ReadLatch slock(m_shared->m_latch);
+        shared_sync();
+        return shared_vertex_id(logical_id);
+    }
+
     // avoid to mess up with an epoch previously set
     auto tcntxt = context::thread_context();
     const bool acquire_epoch = tcntxt->epoch() == numeric_limits<uint64_t>::max();
@@ -91,6 +277,13 @@ uint64_t DynamicView::vertex_id(uint64_t logical_id) const noexcept {
 }
 
 uint64_t DynamicView::logical_id(uint64_t vertex_id) const noexcept {
+    if(m_shared != nullptr){
+        scoped_lock_t xlock(m_latch);
+        util::ReadLatch slock(m_shared->m_latch);
+        shared_sync();
+        return shared_logical_id(vertex_id);
+    }
+
     // avoid to mess up with an epoch previously set
     auto tcntxt = context::thread_context();
     const bool acquire_epoch = tcntxt->epoch() == numeric_limits<uint64_t>::max();
@@ -118,6 +311,13 @@ uint64_t DynamicView::logical_id(uint64_t vertex_id) const noexcept {
 }
 
 uint64_t DynamicView::degree(uint64_t id, bool is_logical) const noexcept {
+    if(m_shared != nullptr){
+        scoped_lock_t xlock(m_latch);
+        util::ReadLatch slock(m_shared->m_latch);
+        shared_sync();
+        return shared_degree(id, is_logical);
+    }
+
     // avoid to mess up with an epoch previously set
     auto tcntxt = context::thread_context();
     const bool acquire_epoch = tcntxt->epoch() == numeric_limits<uint64_t>::max();
@@ -151,6 +351,13 @@ uint64_t DynamicView::degree(uint64_t id, bool is_logical) const noexcept {
 }
 
 uint64_t DynamicView::num_vertices() const noexcept {
+    if(m_shared != nullptr){
+        scoped_lock_t xlock(m_latch);
+        util::ReadLatch slock(m_shared->m_latch);
+        shared_sync();
+        return shared_num_vertices();
+    }
+
     while(true){
         try {
             uint64_t version = m_latch.read_version();
@@ -166,12 +373,28 @@ uint64_t DynamicView::num_vertices() const noexcept {
 void DynamicView::insert_vertex(uint64_t vertex_id){
     scoped_lock_t xlock(m_latch);
 
+    if(m_shared != nullptr){
+        shared_add_diff(vertex_id, +1, 0);
+        return;
+    }
+
     m_tree.insert(ItemUndirected{vertex_id, 0});
 }
 
 void DynamicView::remove_vertex(uint64_t vertex_id) {
     scoped_lock_t xlock(m_latch);
 
+    if(m_shared != nullptr){
+        util::ReadLatch slock(m_shared->m_latch);
+        shared_sync();
+        uint64_t degree = 0;
+        bool success = shared_get(vertex_id, &degree);
+        assert(success == true);
+        if(!success) RAISE(InternalError, "The vertex " << vertex_id << " does not exist");
+        shared_add_diff(vertex_id, -1, -static_cast<int64_t>(degree));
+        return;
+    }
+
     bool success = m_tree.remove(vertex_id);
     assert(success == true);
     if(!success) RAISE(InternalError, "The vertex " << vertex_id << " does not exist");
@@ -180,6 +403,11 @@ void DynamicView::remove_vertex(uint64_t vertex_id) {
 void DynamicView::change_degree(uint64_t vertex_id, int64_t diff){
     scoped_lock_t xlock(m_latch);
 
+    if(m_shared != nullptr){
+        shared_add_diff(vertex_id, 0, diff);
+        return;
+    }
+
     auto item = m_tree.get_by_vertex_id(vertex_id).first;
     assert(item != nullptr && "Vertex not found");
     if(!item) RAISE(InternalError, "The vertex " << vertex_id << " does not exist");
@@ -189,7 +417,15 @@ void DynamicView::change_degree(uint64_t vertex_id, int64_t diff){
 }
 
 void DynamicView::dump() const{
-    m_tree.dump();
+    if(m_shared != nullptr){
+        cout << "[DynamicView] transaction id: " << m_transaction_id << ", shared position: " << m_shared_position << ", diffs: " << m_diffs.size() << "\n";
+        for(const auto& entry : m_diffs){
+            cout << "vertex id: " << entry.first << ", presence: " << entry.second.m_presence << ", degree: " << entry.second.m_degree << "\n";
+        }
+        m_shared->dump();
+    } else {
+        m_tree.dump();
+    }
 }
 
 
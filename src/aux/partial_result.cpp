@@ -32,7 +32,7 @@ using namespace std;
 namespace teseo::aux {
 
 PartialResult::PartialResult(Builder* builder, uint64_t id, const memstore::Key& from, const memstore::Key& to) :
-    m_builder(builder), m_id(id), m_from(from), m_to(to), m_array(nullptr), m_last(-1), m_capacity(0)
+    m_builder(builder), m_id(id), m_from(from), m_to(to), m_array(nullptr), m_last(-1), m_capacity(0), m_ready(false)
         {
     static_assert(context::StaticConfiguration::aux_partial_init_capacity > 0);
     resize(context::StaticConfiguration::aux_partial_init_capacity);
@@ -68,6 +68,14 @@ void PartialResult::done(){
     m_builder->collect(this);
 }
 
+void PartialResult::set_ready() noexcept {
+    m_ready = true;
+}
+
+bool PartialResult::is_ready() const noexcept {
+    return m_ready;
+}
+
 uint64_t PartialResult::id() const noexcept {
     return m_id;
 }
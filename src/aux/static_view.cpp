@@ -16,26 +16,35 @@
  */
 #include "teseo/aux/static_view.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 #if defined(HAVE_NUMA)
 #include <numa.h>
 #endif
 
 #include "teseo/aux/builder.hpp"
+#include "teseo/aux/change.hpp"
+#include "teseo/aux/cost_model.hpp"
 #include "teseo/aux/item.hpp"
+#include "teseo/context/global_context.hpp"
 #include "teseo/context/property_snapshot.hpp"
 #include "teseo/context/static_configuration.hpp"
+#include "teseo/context/thread_context.hpp"
 #include "teseo/memstore/error.hpp"
 #include "teseo/memstore/key.hpp"
 #include "teseo/memstore/memstore.hpp"
 #include "teseo/profiler/scoped_timer.hpp"
+#include "teseo/runtime/runtime.hpp"
 #include "teseo/transaction/transaction_impl.hpp"
 #include "teseo/util/error.hpp"
 #include "teseo/util/numa.hpp"
+#include "teseo/util/timer.hpp"
 
 #include "teseo/util/debug.hpp"
 
@@ -43,18 +52,43 @@ using namespace std;
 
 namespace teseo::aux {
 
-StaticView::StaticView(uint64_t num_vertices, const ItemUndirected* degree_vector, const HashParams& hash) :
+namespace {
+// Size of the chunk of memory with the columns of a static view, in bytes
+uint64_t columns_size(uint64_t num_vertices, uint64_t num_overflow, bool implicit){
+    return (implicit ? 0 : num_vertices * sizeof(uint64_t)) + num_overflow * 2 * sizeof(uint64_t) + num_vertices * sizeof(uint32_t);
+}
+} // anon namespace
+
+StaticView::StaticView(uint64_t num_vertices, void* columns, uint64_t num_overflow, const HashParams& hash, Ordering ordering) :
         View(/* is static ? */ true),
-        m_num_vertices(num_vertices), m_degree_vector(degree_vector), m_hash_direct(hash.m_direct), m_hash_capacity(hash.m_capacity), m_hash_const(hash.m_const) {
+        m_num_vertices(num_vertices), m_columns(columns),
+        m_vertex_ids(hash.m_implicit ? nullptr : reinterpret_cast<const uint64_t*>(columns)), m_first_vertex_id(hash.m_first_vertex_id),
+        m_overflow(reinterpret_cast<const Overflow*>(reinterpret_cast<char*>(columns) + (hash.m_implicit ? 0 : num_vertices * sizeof(uint64_t)))),
+        m_num_overflow(num_overflow), m_degrees(reinterpret_cast<const uint32_t*>(m_overflow + num_overflow)),
+        m_hash_direct(hash.m_direct), m_hash_narrow(hash.m_narrow), m_hash_capacity(hash.m_capacity), m_hash_const(hash.m_const), m_ordering(ordering) {
 
     if(!hash.m_initialised){
         create_vertex_id_mapping();
     }
 }
 
-StaticView::HashParams::HashParams(uint64_t max_vertex_id, uint64_t num_vertices) {
+StaticView::HashParams::HashParams(const ItemUndirected* degree_vector, uint64_t num_vertices, Ordering ordering) {
+    uint64_t max_vertex_id = num_vertices > 0 ? degree_vector[num_vertices -1].m_vertex_id : numeric_limits<uint64_t>::max();
+    m_narrow = num_vertices < numeric_limits<uint32_t>::max(); // the max value is reserved to mark the empty slots
+    m_first_vertex_id = num_vertices > 0 ? degree_vector[0].m_vertex_id : 0;
+    m_initialised = false;
+
+    // contiguous vertex IDs, the logical ID is simply the offset from the first vertex
+    m_implicit = context::StaticConfiguration::aux_direct_table_enabled &&
+            (num_vertices == 0 || (ordering == Ordering::VERTEX_ID && max_vertex_id - m_first_vertex_id == num_vertices -1));
+    if(m_implicit){
+        m_direct = false;
+        m_capacity = 0;
+        m_const = 0;
+        return;
+    }
 
-    uint64_t capacity0 = num_vertices * context::StaticConfiguration::aux_hash_multiplier;
+    uint64_t capacity0 = std::max<uint64_t>(1, num_vertices * context::StaticConfiguration::aux_hash_multiplier);
     // The hash function is a going to be the modulo over m_hash_const ("the division method"). However, that
     // is, theoretically, rather terrible as we purposedly want the capacity be a power of 2, so that the hash
     // can be computed quickly, with a mask on m_hash_const, and close value for the vertices end up in subsequent
@@ -62,43 +96,134 @@ StaticView::HashParams::HashParams(uint64_t max_vertex_id, uint64_t num_vertices
     // If, upon profiling, this approach does not work, we can readdress the hash function.
     // For the time being, let's compute the next power of 2:
     uint64_t power = ceil(log2(capacity0));
-    uint64_t capacity = (1<<power) *2 /* x2 as we store both the key and the value in the hash map */;
-    if(context::StaticConfiguration::aux_direct_table_enabled && capacity > max_vertex_id){
+    uint64_t capacity = (1ull<<power);
+    if(context::StaticConfiguration::aux_direct_table_enabled && capacity > max_vertex_id){ // a direct table never takes more space than the hash table
         m_direct = true;
         m_capacity = max_vertex_id +1;
         m_const = std::numeric_limits<uint64_t>::max(); // all 1
     } else {
         m_direct = false;
         m_capacity = capacity;
-        m_const = (m_capacity /2) -1;
+        m_const = m_capacity -1;
+    }
+}
+
+StaticView::HashParams::HashParams(const StaticView* view) :
+        m_implicit(view->m_vertex_ids == nullptr), m_direct(view->m_hash_direct), m_narrow(view->m_hash_narrow), m_capacity(view->m_hash_capacity),
+        m_const(view->m_hash_const), m_first_vertex_id(view->m_first_vertex_id), m_initialised(false) {
+
+}
+
+uint64_t StaticView::HashParams::size() const {
+    return m_capacity * (m_narrow ? sizeof(uint32_t) : sizeof(uint64_t));
+}
+
+void StaticView::sort(ItemUndirected* degree_vector, uint64_t num_vertices, Ordering ordering){
+    switch(ordering){
+    case Ordering::VERTEX_ID:
+        break; // nop, already sorted by vertex ID
+    case Ordering::DEGREE_DESC:
+        std::sort(degree_vector, degree_vector + num_vertices, [](const ItemUndirected& i1, const ItemUndirected& i2){
+            return i1.m_degree > i2.m_degree || (i1.m_degree == i2.m_degree && i1.m_vertex_id < i2.m_vertex_id);
+        });
+        break;
     }
-    m_initialised = false;
 }
 
 StaticView::~StaticView(){
-    util::NUMA::free((void*) m_degree_vector); m_degree_vector = nullptr;
+    util::NUMA::free(m_columns); m_columns = nullptr;
 }
 
+StaticView* StaticView::create(uint64_t num_vertices, ItemUndirected* degree_vector, HashParams hp, Ordering ordering, const StaticView* dictionary){
+    uint64_t num_overflow = 0;
+    for(uint64_t i = 0; i < num_vertices; i++){
+        num_overflow += (degree_vector[i].m_degree >= DEGREE_OVERFLOW);
+    }
+
+    // split the degree vector into the columns
+    void* columns = util::NUMA::malloc(columns_size(num_vertices, num_overflow, hp.m_implicit));
+    uint64_t* __restrict vertex_ids = reinterpret_cast<uint64_t*>(columns);
+    Overflow* __restrict overflow = reinterpret_cast<Overflow*>(reinterpret_cast<char*>(columns) + (hp.m_implicit ? 0 : num_vertices * sizeof(uint64_t)));
+    uint32_t* __restrict degrees = reinterpret_cast<uint32_t*>(overflow + num_overflow);
+    for(uint64_t i = 0, j = 0; i < num_vertices; i++){
+        if(!hp.m_implicit){ vertex_ids[i] = degree_vector[i].m_vertex_id; }
+        if(degree_vector[i].m_degree < DEGREE_OVERFLOW){
+            degrees[i] = degree_vector[i].m_degree;
+        } else {
+            degrees[i] = DEGREE_OVERFLOW;
+            overflow[j].m_logical_id = i;
+            overflow[j].m_degree = degree_vector[i].m_degree;
+            j++;
+        }
+    }
+    util::NUMA::free(degree_vector);
+
+    void* heap = util::NUMA::malloc(sizeof(StaticView) + hp.size());
+    if(dictionary != nullptr){ // reuse the dictionary of the previous view
+        assert(HashParams{ dictionary }.size() == hp.size());
+        memcpy(reinterpret_cast<char*>(heap) + sizeof(StaticView), dictionary->hash_table<char>(), hp.size());
+        hp.m_initialised = true;
+    }
+    return new (heap) StaticView{ num_vertices, columns, num_overflow, hp, ordering };
+}
 
 void StaticView::create_vertex_id_mapping(){
+    if(m_vertex_ids == nullptr) return; // implicit mapping, there is no dictionary
+
     profiler::ScopedTimer profiler { profiler::AUX_STATIC_BUILD_HASHMAP };
-    uint64_t* __restrict ht = hash_table();
-    memset(ht, /* 255 */ numeric_limits<uint8_t>::max(), sizeof(uint64_t) * m_hash_capacity);
+    context::ThreadContext* thread_context = context::thread_context_if_exists();
+
+    if(thread_context == nullptr || m_num_vertices <= context::StaticConfiguration::aux_hashmap_partition_size){
+        hashmap_init(0, m_hash_capacity);
+        hashmap_insert(0, m_num_vertices, /* concurrent ? */ false);
+    } else { // split the work among the runtime workers
+        runtime::Runtime* runtime = thread_context->global_context()->runtime();
+        runtime->aux_build_hashmap(this, /* init ? */ true, m_hash_capacity);
+        runtime->aux_build_hashmap(this, /* init ? */ false, m_num_vertices);
+    }
+}
 
-    for(uint64_t i = 0; i < m_num_vertices; i++){
-        uint64_t vertex_id = m_degree_vector[i].m_vertex_id;
+void StaticView::hashmap_init(uint64_t start, uint64_t end){
+    assert(start <= end && end <= m_hash_capacity);
+    const uint64_t slot_sz = m_hash_narrow ? sizeof(uint32_t) : sizeof(uint64_t);
+    memset(hash_table<char>() + start * slot_sz, /* 255 */ numeric_limits<uint8_t>::max(), slot_sz * (end - start));
+}
 
-        if(m_hash_direct){
+void StaticView::hashmap_insert(uint64_t start, uint64_t end, bool concurrent){
+    if(m_hash_narrow){
+        hashmap_insert0<uint32_t>(start, end, concurrent);
+    } else {
+        hashmap_insert0<uint64_t>(start, end, concurrent);
+    }
+}
+
+template<typename T>
+void StaticView::hashmap_insert0(uint64_t start, uint64_t end, bool concurrent){
+    assert(start <= end && end <= m_num_vertices);
+    assert(m_vertex_ids != nullptr && "Implicit mapping");
+    constexpr T EMPTY = numeric_limits<T>::max();
+    T* __restrict ht = hash_table<T>();
+
+    for(uint64_t i = start; i < end; i++){
+        uint64_t vertex_id = m_vertex_ids[i];
+
+        if(m_hash_direct){ // vertex IDs are unique, workers never write the same slot
             ht[vertex_id] = i;
         } else {
             uint64_t slot = hash(vertex_id);
-            while(ht[slot] != aux::NOT_FOUND){
-                slot += 2; // we store both the key and the value in the hash
-                if(slot == m_hash_capacity) slot = 0;
-            }
 
-            ht[slot] = vertex_id;
-            ht[slot+1] = i;
+            if(!concurrent){
+                while(ht[slot] != EMPTY){
+                    slot = (slot +1) & m_hash_const;
+                }
+                ht[slot] = i;
+            } else {
+                T expected = EMPTY;
+                while(__atomic_load_n(ht + slot, __ATOMIC_RELAXED) != EMPTY || !__atomic_compare_exchange_n(ht + slot, &expected, static_cast<T>(i), /* weak ? */ false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+                    expected = EMPTY;
+                    slot = (slot +1) & m_hash_const;
+                }
+            }
         }
     }
 }
@@ -106,8 +231,10 @@ void StaticView::create_vertex_id_mapping(){
 uint64_t StaticView::vertex_id(uint64_t logical_id) const noexcept {
     if(logical_id >= m_num_vertices){
         return NOT_FOUND;
+    } else if(m_vertex_ids == nullptr){ // implicit mapping
+        return m_first_vertex_id + logical_id;
     } else {
-        return m_degree_vector[logical_id].m_vertex_id;
+        return m_vertex_ids[logical_id];
     }
 }
 
@@ -116,8 +243,24 @@ uint64_t StaticView::degree(uint64_t id, bool is_logical_id) const noexcept {
 
     if(logical_id >= m_num_vertices){
         return NOT_FOUND;
-    } else {
-        return m_degree_vector[logical_id].m_degree;
+    } else if(m_degrees[logical_id] != DEGREE_OVERFLOW){
+        return m_degrees[logical_id];
+    } else { // fetch the degree from the overflow table
+        const Overflow* entry = std::lower_bound(m_overflow, m_overflow + m_num_overflow, logical_id, [](const Overflow& o, uint64_t key){
+            return o.m_logical_id < key;
+        });
+        assert(entry < m_overflow + m_num_overflow && entry->m_logical_id == logical_id);
+        return entry->m_degree;
+    }
+}
+
+void StaticView::copy_to(ItemUndirected* degree_vector) const {
+    for(uint64_t i = 0; i < m_num_vertices; i++){
+        degree_vector[i].m_vertex_id = m_vertex_ids != nullptr ? m_vertex_ids[i] : m_first_vertex_id + i;
+        degree_vector[i].m_degree = m_degrees[i];
+    }
+    for(uint64_t i = 0; i < m_num_overflow; i++){
+        degree_vector[m_overflow[i].m_logical_id].m_degree = m_overflow[i].m_degree;
     }
 }
 
@@ -125,58 +268,171 @@ uint64_t StaticView::num_vertices() const noexcept {
     return m_num_vertices;
 }
 
-const ItemUndirected* StaticView::degree_vector() const {
-    return m_degree_vector;
+Ordering StaticView::ordering() const noexcept {
+    return m_ordering;
 }
 
-void StaticView::create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction, StaticView** out_array, uint64_t out_sz){
+uint64_t StaticView::memory_footprint() const noexcept {
+    return sizeof(StaticView) + HashParams{ this }.size() + columns_size(m_num_vertices, m_num_overflow, is_implicit());
+}
+
+bool StaticView::is_implicit() const noexcept {
+    return m_vertex_ids == nullptr;
+}
+
+uint64_t StaticView::num_overflow() const noexcept {
+    return m_num_overflow;
+}
+
+void StaticView::create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction, StaticView** out_array, uint64_t out_sz, Ordering ordering){
     profiler::ScopedTimer profiler { profiler::AUX_STATIC_CREATE };
     assert(transaction->is_read_only() && "Expected a read-only transaction");
 
     if(out_sz < 1) RAISE(InternalError, "out_sz < 1");
     if(out_sz > context::StaticConfiguration::numa_num_nodes) RAISE(InternalError, "Invalid value for out_size: " << out_sz << ", number of NUMA nodes: " << context::StaticConfiguration::numa_num_nodes);
 
+    util::Timer timer;
+    timer.start();
+
     // first node
     Builder builder;
     memstore->aux_view(transaction, &builder);
-    uint64_t num_vertices = transaction->graph_properties().m_vertex_count;
+    context::GraphProperty properties = transaction->graph_properties();
+    uint64_t num_vertices = properties.m_vertex_count;
     ItemUndirected* degree_vector = builder.create_dv_undirected(num_vertices);
-    HashParams hp { num_vertices > 0 ? degree_vector[num_vertices -1].m_vertex_id : numeric_limits<uint64_t>::max(), num_vertices };
-    uint64_t size = sizeof(StaticView) + sizeof(uint64_t) * hp.m_capacity;
-    void* heap = util::NUMA::malloc(size);
-    out_array[0] = new (heap) StaticView{ num_vertices, degree_vector, hp };
+    HashParams hp { degree_vector, num_vertices, ordering };
+    sort(degree_vector, num_vertices, ordering);
+    out_array[0] = create(num_vertices, degree_vector, hp, ordering);
 
     // remaining nodes
+    replicate(out_array, out_sz, hp);
+
+    // sample the cost to build a view from scratch
+    timer.stop();
+    context::global_context()->aux_cost_model()->record_build(properties.m_vertex_count + properties.m_edge_count, timer.nanoseconds());
+}
+
+void StaticView::create_undirected(const StaticView* previous, const vector<Change>& changes_by_txn, StaticView** out_array, uint64_t out_sz){
+    profiler::ScopedTimer profiler { profiler::AUX_STATIC_UPDATE };
+    assert(previous != nullptr);
+    if(out_sz < 1) RAISE(InternalError, "out_sz < 1");
+    if(out_sz > context::StaticConfiguration::numa_num_nodes) RAISE(InternalError, "Invalid value for out_size: " << out_sz << ", number of NUMA nodes: " << context::StaticConfiguration::numa_num_nodes);
+
+    // group the changes by vertex, retaining the order of the commits for the same vertex
+    vector<Change> changes { changes_by_txn };
+    stable_sort(begin(changes), end(changes), [](const Change& c1, const Change& c2){ return c1.m_vertex_id < c2.m_vertex_id; });
+
+    // compute the final state of each altered vertex
+    struct Delta {
+        uint64_t m_vertex_id; // the vertex altered
+        uint64_t m_logical_id; // its logical ID in the previous view, or NOT_FOUND if it did not exist
+        bool m_exists; // whether the vertex exists in the new view
+        uint64_t m_degree; // the degree of the vertex in the new view
+    };
+    vector<Delta> deltas;
+    uint64_t num_vertices = previous->num_vertices();
+    bool vertices_changed = false; // whether any vertex has been inserted or removed
+    for(uint64_t i = 0, sz = changes.size(); i < sz; ){
+        Delta delta;
+        delta.m_vertex_id = changes[i].m_vertex_id;
+        delta.m_logical_id = previous->logical_id(delta.m_vertex_id);
+        delta.m_exists = delta.m_logical_id != NOT_FOUND;
+        int64_t degree = delta.m_exists ? previous->degree(delta.m_logical_id, /* logical ? */ true) : 0;
+
+        while(i < sz && changes[i].m_vertex_id == delta.m_vertex_id){
+            switch(changes[i].m_type){
+            case Change::INSERT_VERTEX: delta.m_exists = true; degree = 0; break;
+            case Change::REMOVE_VERTEX: delta.m_exists = false; break;
+            case Change::INCR_DEGREE: degree++; break;
+            case Change::DECR_DEGREE: degree--; break;
+            }
+            i++;
+        }
+        assert(degree >= 0 && "Negative degree");
+        delta.m_degree = degree;
+
+        if(delta.m_exists != (delta.m_logical_id != NOT_FOUND)){
+            vertices_changed = true;
+            if(delta.m_exists){ num_vertices++; } else { num_vertices--; }
+        }
+        deltas.push_back(delta);
+    }
+
+    // with an ordering policy other than the vertex ID, any change to the degrees can also alter the logical IDs
+    const Ordering ordering = previous->m_ordering;
+    const bool reuse_logical_ids = !vertices_changed && ordering == Ordering::VERTEX_ID;
+
+    ItemUndirected* degree_vector = (ItemUndirected*) util::NUMA::malloc(num_vertices * sizeof(ItemUndirected));
+    if(reuse_logical_ids){ // same logical IDs, copy the previous degree vector and only alter the degrees
+        previous->copy_to(degree_vector);
+        for(const auto& delta: deltas){
+            degree_vector[delta.m_logical_id].m_degree = delta.m_degree;
+        }
+    } else { // merge the previous degree vector with the altered vertices, the logical IDs need to be recomputed
+        uint64_t i = 0, j = 0, k = 0, previous_num_vertices = previous->num_vertices();
+        unique_ptr<ItemUndirected[]> ptr_dv_previous { new ItemUndirected[previous_num_vertices] };
+        previous->copy_to(ptr_dv_previous.get());
+        if(ordering != Ordering::VERTEX_ID){ // the merge requires the previous vertices sorted by vertex ID
+            std::sort(ptr_dv_previous.get(), ptr_dv_previous.get() + previous_num_vertices, [](const ItemUndirected& i1, const ItemUndirected& i2){
+                return i1.m_vertex_id < i2.m_vertex_id;
+            });
+        }
+        const ItemUndirected* __restrict dv_previous = ptr_dv_previous.get();
+        while(i < previous_num_vertices || j < deltas.size()){
+            if(j == deltas.size() || (i < previous_num_vertices && dv_previous[i].m_vertex_id < deltas[j].m_vertex_id)){
+                degree_vector[k++] = dv_previous[i++];
+            } else {
+                if(i < previous_num_vertices && dv_previous[i].m_vertex_id == deltas[j].m_vertex_id){ i++; } // replaced
+                if(deltas[j].m_exists){
+                    degree_vector[k].m_vertex_id = deltas[j].m_vertex_id;
+                    degree_vector[k].m_degree = deltas[j].m_degree;
+                    k++;
+                }
+                j++;
+            }
+        }
+        assert(k == num_vertices);
+    }
+
+    HashParams hp = reuse_logical_ids ? HashParams{ previous } : HashParams{ degree_vector, num_vertices, ordering };
+    if(!reuse_logical_ids){
+        sort(degree_vector, num_vertices, ordering);
+    }
+    out_array[0] = create(num_vertices, degree_vector, hp, ordering, /* reuse the previous dictionary ? */ reuse_logical_ids ? previous : nullptr);
+
+    // remaining nodes
+    replicate(out_array, out_sz, hp);
+}
+
+void StaticView::replicate(StaticView** out_array, uint64_t out_sz, HashParams hp){
     hp.m_initialised = true;
+    const StaticView* view = out_array[0];
     for(uint64_t i = 1; i < out_sz; i++){
-        ItemUndirected* copy_dv = (ItemUndirected*) util::NUMA::copy(degree_vector, i);
-
-        void* copy_view = util::NUMA::copy(heap, i);
-        out_array[i] = new (copy_view) StaticView{ num_vertices, copy_dv, hp };
+        void* copy_columns = util::NUMA::copy(view->m_columns, i);
 
+        void* copy_view = util::NUMA::copy((void*) view, i);
+        out_array[i] = new (copy_view) StaticView{ view->m_num_vertices, copy_columns, view->m_num_overflow, hp, view->m_ordering };
     }
 }
 
-StaticView* StaticView::create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction){ // old API
+StaticView* StaticView::create_undirected(memstore::Memstore* memstore, transaction::TransactionImpl* transaction, Ordering ordering){ // old API
     StaticView* res = {nullptr};
-    create_undirected(memstore, transaction, &res, 1);
+    create_undirected(memstore, transaction, &res, 1, ordering);
     return res;
 }
 
-StaticView* StaticView::create_undirected(uint64_t num_vertices, const ItemUndirected* degree_vector){ // old API
-    HashParams hp { num_vertices > 0 ? degree_vector[num_vertices -1].m_vertex_id : numeric_limits<uint64_t>::max(), num_vertices };
-    uint64_t size = sizeof(StaticView) + sizeof(uint64_t) * hp.m_capacity;
-    void* heap = util::NUMA::malloc(size);
-    return new (heap) StaticView{ num_vertices, degree_vector, hp };
+StaticView* StaticView::create_undirected(uint64_t num_vertices, ItemUndirected* degree_vector){ // old API
+    HashParams hp { degree_vector, num_vertices, Ordering::VERTEX_ID };
+    return create(num_vertices, degree_vector, hp, Ordering::VERTEX_ID);
 }
 
 void StaticView::dump() const {
-    cout << "num_vertices: " << m_num_vertices << ", size of the hashmap: " << m_hash_capacity << ", logical IDs:\n";
+    cout << "num_vertices: " << m_num_vertices << ", size of the hashmap: " << m_hash_capacity << (is_implicit() ? " (implicit)" : "") << ", overflow: " << m_num_overflow << ", logical IDs:\n";
     for(uint64_t i = 0; i < m_num_vertices; i++){
-        cout << "[" << i << "] " << m_degree_vector[i];
+        cout << "[" << i << "] " << ItemUndirected{ vertex_id(i), degree(i, /* logical ? */ true) };
 
         cout << ", hashmap match: ";
-        auto hashres = logical_id(m_degree_vector[i].m_vertex_id);
+        auto hashres = logical_id(vertex_id(i));
         if(hashres == aux::NOT_FOUND){
             cout << "not found";
         } else if(hashres != i){
@@ -0,0 +1,197 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "teseo/aux/versioned_tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include "teseo/aux/item.hpp"
+#include "teseo/context/static_configuration.hpp"
+#include "teseo/util/error.hpp"
+
+using namespace std;
+
+namespace teseo::aux {
+
+VersionedTree::VersionedTree(uint64_t last_commit_id) : m_tree(nullptr), m_deltas_offset(0), m_last_commit_id(last_commit_id),
+        m_transaction_id(numeric_limits<uint64_t>::max()), m_ready(false), m_ref_count(1) {
+
+}
+
+VersionedTree::~VersionedTree(){
+    delete m_tree; m_tree = nullptr;
+}
+
+bool VersionedTree::commit(const vector<Change>& changes){
+    // the caller must hold the latch in write mode, since before drawing the commit ID of the transaction
+    if(!changes.empty()){
+        if(!m_ready){ // the tree is being initialised
+            m_pending.insert(end(m_pending), begin(changes), end(changes));
+        } else {
+            apply(changes.data(), changes.size());
+        }
+    }
+
+    const uint64_t num_deltas = m_ready ? m_deltas.size() : m_pending.size();
+    const uint64_t num_vertices = m_ready ? m_tree->size() : 0;
+    return num_deltas > max(num_vertices, context::StaticConfiguration::aux_cache_changes_min_capacity);
+}
+
+void VersionedTree::apply(const Change* changes, uint64_t num_changes){
+    assert(num_changes > 0);
+    const uint64_t transaction_id = changes[0].m_transaction_id;
+
+    // group the changes by vertex, retaining the order of the changes for the same vertex
+    vector<Change> sorted { changes, changes + num_changes };
+    stable_sort(begin(sorted), end(sorted), [](const Change& c1, const Change& c2){ return c1.m_vertex_id < c2.m_vertex_id; });
+
+    for(uint64_t i = 0; i < num_changes; ){
+        const uint64_t vertex_id = sorted[i].m_vertex_id;
+        ItemUndirected* item = m_tree->get_by_vertex_id(vertex_id).first;
+        const bool existed = item != nullptr;
+        const int64_t degree_before = existed ? item->m_degree : 0;
+        bool exists = existed;
+        int64_t degree = degree_before;
+
+        while(i < num_changes && sorted[i].m_vertex_id == vertex_id){
+            assert(sorted[i].m_transaction_id == transaction_id && "Expected changes from a single transaction");
+            switch(sorted[i].m_type){
+            case Change::INSERT_VERTEX: exists = true; degree = 0; break;
+            case Change::REMOVE_VERTEX: exists = false; break;
+            case Change::INCR_DEGREE: degree++; break;
+            case Change::DECR_DEGREE: degree--; break;
+            }
+            i++;
+        }
+        if(!exists){ degree = 0; } // its edges have been removed as well
+        assert(degree >= 0 && "Negative degree");
+
+        if(existed && !exists){
+            m_tree->remove(vertex_id);
+        } else if(!existed && exists){
+            m_tree->insert(ItemUndirected{ vertex_id, static_cast<uint64_t>(degree) });
+        } else if(exists){
+            item->m_degree = degree;
+        }
+
+        if(exists != existed || degree != degree_before){
+            m_deltas.push_back(Delta{ transaction_id, vertex_id, static_cast<int64_t>(exists) - static_cast<int64_t>(existed), degree - degree_before });
+        }
+    }
+}
+
+void VersionedTree::init(CountingTree&& tree, uint64_t transaction_id){
+    util::WriteLatch xlock(m_latch);
+    assert(!m_ready && "Already initialised");
+    assert(m_last_commit_id == numeric_limits<uint64_t>::max() || m_last_commit_id < transaction_id);
+
+    m_tree = new CountingTree(move(tree));
+
+    // The snapshots in [m_transaction_id, transaction_id) are equal, no writer has committed in between. If we
+    // don't know when the last writer committed, the tree can only be used by the transactions starting from now.
+    m_transaction_id = m_last_commit_id == numeric_limits<uint64_t>::max() ? transaction_id : m_last_commit_id +1;
+
+    for(uint64_t i = 0, sz = m_pending.size(); i < sz; ){
+        uint64_t j = i +1;
+        while(j < sz && m_pending[j].m_transaction_id == m_pending[i].m_transaction_id) j++;
+
+        if(m_pending[i].m_transaction_id < transaction_id){ // already part of the given tree
+            m_transaction_id = max(m_transaction_id, m_pending[i].m_transaction_id +1);
+        } else {
+            apply(m_pending.data() + i, j - i);
+        }
+
+        i = j;
+    }
+    m_pending.clear();
+    m_pending.shrink_to_fit();
+
+    m_ready = true;
+}
+
+void VersionedTree::prune(uint64_t transaction_id){
+    util::WriteLatch xlock(m_latch);
+    auto it = lower_bound(begin(m_deltas), end(m_deltas), transaction_id, [](const Delta& delta, uint64_t transaction_id){
+        return delta.m_transaction_id < transaction_id;
+    });
+    m_deltas_offset += it - begin(m_deltas);
+    m_deltas.erase(begin(m_deltas), it);
+}
+
+bool VersionedTree::is_ready() const {
+    util::ReadLatch slock(m_latch);
+    return m_ready;
+}
+
+uint64_t VersionedTree::transaction_id() const {
+    util::ReadLatch slock(m_latch);
+    return m_transaction_id;
+}
+
+uint64_t VersionedTree::num_deltas() const {
+    util::ReadLatch slock(m_latch);
+    return m_ready ? m_deltas.size() : m_pending.size();
+}
+
+uint64_t VersionedTree::num_vertices() const {
+    util::ReadLatch slock(m_latch);
+    return m_ready ? m_tree->size() : 0;
+}
+
+util::Latch& VersionedTree::latch() const {
+    return m_latch;
+}
+
+void VersionedTree::incr_ref_count() noexcept {
+    m_ref_count++;
+}
+
+void VersionedTree::decr_ref_count() noexcept {
+    if(--m_ref_count == 0){
+        delete this;
+    }
+}
+
+string VersionedTree::to_string() const {
+    stringstream ss;
+    util::ReadLatch slock(m_latch);
+    ss << "ready: " << boolalpha << m_ready << ", min transaction id: " << m_transaction_id << ", vertices: " << (m_ready ? m_tree->size() : 0) <<
+            ", deltas: " << m_deltas.size() << " (pruned: " << m_deltas_offset << "), pending changes: " << m_pending.size();
+    return ss.str();
+}
+
+void VersionedTree::dump() const {
+    cout << "[VersionedTree] " << to_string() << "\n";
+    util::ReadLatch slock(m_latch);
+    for(uint64_t i = 0; i < m_deltas.size(); i++){
+        const Delta& delta = m_deltas[i];
+        cout << "[" << (m_deltas_offset + i) << "] transaction id: " << delta.m_transaction_id << ", vertex id: " << delta.m_vertex_id <<
+                ", presence: " << delta.m_presence << ", degree: " << delta.m_degree << "\n";
+    }
+    if(m_ready){ m_tree->dump(); }
+}
+
+ostream& operator<<(ostream& out, const VersionedTree& tree){
+    out << tree.to_string();
+    return out;
+}
+
+} // namespace
@@ -71,6 +71,10 @@ void View::incr_ref_count() noexcept {
     m_ref_count++;
 }
 
+int View::ref_count() const noexcept {
+    return m_ref_count;
+}
+
 void View::decr_ref_count() noexcept {
     if(--m_ref_count == 0){
         this->~View();
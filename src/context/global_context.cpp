@@ -23,6 +23,7 @@
 #include <queue>
 
 #include "teseo/aux/cache.hpp"
+#include "teseo/aux/cost_model.hpp"
 #include "teseo/aux/dynamic_view.hpp"
 #include "teseo/aux/static_view.hpp"
 #include "teseo/context/thread_context.hpp"
@@ -35,6 +36,7 @@
 #include "teseo/rebalance/merger_service.hpp"
 #include "teseo/runtime/runtime.hpp"
 #include "teseo/transaction/memory_pool_list.hpp"
+#include "teseo/transaction/redo_log.hpp"
 #include "teseo/transaction/transaction_impl.hpp"
 #include "teseo/transaction/transaction_sequence.hpp"
 #include "teseo/util/error.hpp"
@@ -56,7 +58,7 @@ static thread_local ThreadContext* g_thread_context {nullptr};
  *  Init                                                                     *
  *                                                                           *
  *****************************************************************************/
-GlobalContext::GlobalContext() : m_tc_list(this), m_aux_degree_enabled(StaticConfiguration::aux_degree_enabled) {
+GlobalContext::GlobalContext() : m_tc_list(this), m_aux_degree_enabled(StaticConfiguration::aux_degree_enabled), m_aux_cache_memory_budget(StaticConfiguration::aux_cache_memory_budget), m_merger_memory_target(StaticConfiguration::merger_memory_target), m_aux_ordering(aux::Ordering::VERTEX_ID) {
 #if defined(HAVE_PROFILER)
     m_profiler_events = new profiler::EventGlobal();
     m_profiler_rebalances = new profiler::GlobalRebalanceList();
@@ -75,7 +77,8 @@ GlobalContext::GlobalContext() : m_tc_list(this), m_aux_degree_enabled(StaticCon
     m_runtime->register_thread_contexts();
 
     // aux cache
-    m_aux_cache = StaticConfiguration::aux_cache_enabled ? new aux::Cache() : nullptr;
+    m_aux_cache = StaticConfiguration::aux_cache_enabled ? new aux::Cache(m_aux_cache_memory_budget, m_aux_ordering) : nullptr;
+    m_aux_cost_model = new aux::CostModel();
 
     // because the storage appends a default key to the index, we first need to have
     // a thread context alive before initialising it
@@ -86,6 +89,10 @@ GlobalContext::GlobalContext() : m_tc_list(this), m_aux_degree_enabled(StaticCon
 }
 
 GlobalContext::~GlobalContext(){
+    m_runtime->thread_pool()->stop(); // its threads are registered as thread contexts
+
+    disable_redo_log(); // sync the pending changes to the log
+
     m_memstore->merger()->stop(); // unsafe to run the merger as the GCs won't see its epoch anymore
 
     m_runtime->unregister_thread_contexts();
@@ -95,6 +102,7 @@ GlobalContext::~GlobalContext(){
     // list of active threads, as we are not going to perform any transaction
     register_thread(); // even if it's already present!
     m_memstore->clear();
+    delete m_aux_cache; m_aux_cache = nullptr; // the shared counting tree must be released inside a thread context
     unregister_thread(); // done
 
     // wait for all thread contexts to terminate ZzZ....
@@ -112,8 +120,8 @@ GlobalContext::~GlobalContext(){
     // remove the `global' property list
     delete m_prop_list; m_prop_list = nullptr;
 
-    // remove the auxiliary view cache
-    delete m_aux_cache; m_aux_cache = nullptr;
+    // remove the cost model of the auxiliary views
+    delete m_aux_cost_model; m_aux_cost_model = nullptr;
 
     // remove the runtime
     delete m_runtime; m_runtime = nullptr;
@@ -328,11 +336,14 @@ transaction::TransactionSequence* GlobalContext::active_transactions(){
             ThreadContext** __restrict list = m_tc_list.list();
             ThreadContext* tcntxt = list[0]; int i = 0;
             while(tcntxt != nullptr){
-                TransactionSequence seq = tcntxt->my_active_transactions(max_transaction_id);
-                if(seq.size() > 0){
-                    num_transactions += seq.size();
-                    queues.emplace_back( Queue{} );
-                    queues.back().m_sequence = move(seq);
+                // skip the thread contexts without any active transaction, their min is maintained incrementally
+                if(tcntxt->my_high_water_mark() < max_transaction_id){
+                    TransactionSequence seq = tcntxt->my_active_transactions(max_transaction_id);
+                    if(seq.size() > 0){
+                        num_transactions += seq.size();
+                        queues.emplace_back( Queue{} );
+                        queues.back().m_sequence = move(seq);
+                    }
                 }
 
                 // next iteration
@@ -514,24 +525,22 @@ void GlobalContext::aux_view(transaction::TransactionImpl* transaction, aux::Vie
     }
 
     if(!transaction->is_read_only()){ // read-write transaction -> DynamicView
-        out_views[0] = aux::DynamicView::create_undirected(memstore(), transaction);
+        aux::DynamicView* view = nullptr;
+        if(is_aux_cache_enabled()){ // backed by the tree shared among the read-write transactions
+            view = m_aux_cache->get_dynamic(memstore(), transaction);
+        }
+        if(view == nullptr){ // scan the whole memstore
+            view = aux::DynamicView::create_undirected(memstore(), transaction);
+        }
+        out_views[0] = view;
 
     } else { // read-only transactions -> StaticView
         aux::StaticView** out_static_views = reinterpret_cast<aux::StaticView**>(out_views);
 
-        if(is_aux_cache_enabled()){ // Check to cache
-
-            uint64_t max_writer_txn_id = highest_txn_rw_id();
-            bool cache_hit = m_aux_cache->get(transaction->ts_read(), max_writer_txn_id, out_static_views);
-
-            if(!cache_hit){ // we need to compute it
-                aux::StaticView::create_undirected(memstore(), transaction, out_static_views, NUM_NODES);
-                // update the cache ?
-                m_aux_cache->set(out_static_views, transaction->ts_read());
-            }
-
+        if(is_aux_cache_enabled()){ // retrieve it from the cache, or let the cache build it
+            m_aux_cache->get(memstore(), transaction, out_static_views);
         } else { // compute it anyway
-            aux::StaticView::create_undirected(memstore(), transaction, out_static_views, NUM_NODES);
+            aux::StaticView::create_undirected(memstore(), transaction, out_static_views, NUM_NODES, m_aux_ordering);
         }
 
     }
@@ -551,7 +560,7 @@ bool GlobalContext::is_aux_degree_enabled() const noexcept {
 
 void GlobalContext::enable_aux_cache() noexcept {
     if(m_aux_cache == nullptr){
-        m_aux_cache = new aux::Cache();
+        m_aux_cache = new aux::Cache(m_aux_cache_memory_budget, m_aux_ordering);
     }
 }
 
@@ -563,6 +572,66 @@ bool GlobalContext::is_aux_cache_enabled() const noexcept {
     return m_aux_cache != nullptr;
 }
 
+aux::Cache* GlobalContext::aux_cache() const noexcept {
+    return m_aux_cache;
+}
+
+aux::CostModel* GlobalContext::aux_cost_model() const noexcept {
+    return m_aux_cost_model;
+}
+
+void GlobalContext::set_aux_cache_memory_budget(uint64_t bytes) noexcept {
+    m_aux_cache_memory_budget = bytes;
+    if(m_aux_cache != nullptr){
+        m_aux_cache->set_memory_budget(bytes);
+    }
+}
+
+uint64_t GlobalContext::aux_cache_memory_budget() const noexcept {
+    return m_aux_cache_memory_budget;
+}
+
+void GlobalContext::set_merger_memory_target(uint64_t bytes) noexcept {
+    m_merger_memory_target = bytes;
+}
+
+uint64_t GlobalContext::merger_memory_target() const noexcept {
+    return m_merger_memory_target;
+}
+
+void GlobalContext::set_aux_ordering(aux::Ordering ordering) noexcept {
+    if(ordering == m_aux_ordering) return; // nop
+    m_aux_ordering = ordering;
+    if(m_aux_cache != nullptr){ // the cached views were built with the previous policy
+        disable_aux_cache();
+        enable_aux_cache();
+    }
+}
+
+aux::Ordering GlobalContext::aux_ordering() const noexcept {
+    return m_aux_ordering;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Redo log                                                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+void GlobalContext::enable_redo_log(const std::string& path){
+    disable_redo_log();
+    transaction::RedoLog::recover(this, path);
+    m_redo_log = new transaction::RedoLog(path);
+}
+
+void GlobalContext::disable_redo_log(){
+    delete m_redo_log; m_redo_log = nullptr;
+}
+
+transaction::RedoLog* GlobalContext::redo_log() const noexcept {
+    return m_redo_log;
+}
+
 void GlobalContext::set_break_into_debugger(bool value) {
 #if defined(MAYBE_BREAK_INTO_DEBUGGER_ENABLED)
       util::maybe_break_into_debugger_enabled = value;
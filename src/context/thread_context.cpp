@@ -24,8 +24,10 @@
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/property_snapshot.hpp"
 #include "teseo/gc/garbage_collector.hpp"
+#include "teseo/memstore/sparse_file.hpp"
 #include "teseo/profiler/event_thread.hpp"
 #include "teseo/profiler/rebal_list.hpp"
+#include "teseo/rebalance/scratchpad.hpp"
 #include "teseo/runtime/runtime.hpp"
 #include "teseo/transaction/memory_pool.hpp"
 #include "teseo/transaction/memory_pool_list.hpp"
@@ -50,8 +52,8 @@ namespace teseo::context {
 
 
 ThreadContext::ThreadContext(GlobalContext* global_context) : m_global_context(global_context),
-        m_ref_count(1), m_tx_seq(nullptr), m_tx_pool(nullptr), m_gc_queue(global_context->next_gc()),
-        m_profiler_events(nullptr), m_profiler_rebalances{nullptr},
+        m_ref_count(1), m_tx_seq(nullptr), m_tx_pool(nullptr), m_undo_cache(nullptr), m_gc_queue(global_context->next_gc()),
+        m_profiler_events(nullptr), m_profiler_rebalances{nullptr}, m_scratchpad(nullptr), m_segment_buffer(nullptr),
         m_cache_numa_thread(-1), m_num_reader_latches(0)
 #if !defined(NDEBUG)
     , m_thread_id(util::Thread::get_thread_id())
@@ -72,6 +74,8 @@ ThreadContext::ThreadContext(GlobalContext* global_context) : m_global_context(g
 ThreadContext::~ThreadContext() {
     delete m_profiler_events; m_profiler_events = nullptr;
     delete m_profiler_rebalances; m_profiler_rebalances = nullptr;
+    delete m_scratchpad; m_scratchpad = nullptr;
+    delete[] m_segment_buffer; m_segment_buffer = nullptr;
 
 #if !defined(NDEBUG)
     COUT_DEBUG("thread_context: " << (void*) this << ", thread id: " << m_thread_id << ", terminated");
@@ -168,6 +172,14 @@ transaction::TransactionImpl* ThreadContext::create_transaction(bool read_only){
     return tx;
 }
 
+transaction::MemoryPoolList* ThreadContext::undo_buffer_cache() {
+    // the list is owned by a worker of the runtime, which always outlives the thread contexts
+    if(m_undo_cache == nullptr){
+        m_undo_cache = m_global_context->transaction_pool();
+    }
+    return m_undo_cache;
+}
+
 /*****************************************************************************
  *                                                                           *
  *   Graph properties                                                        *
@@ -202,6 +214,28 @@ void ThreadContext::decr_ref_count(){
     }
 }
 
+/*****************************************************************************
+ *                                                                           *
+ *   Working buffers                                                         *
+ *                                                                           *
+ *****************************************************************************/
+
+rebalance::ScratchPad& ThreadContext::scratchpad(){
+    assert(m_thread_id == util::Thread::get_thread_id() && "Only the thread owning the context can use its buffers");
+    if(m_scratchpad == nullptr){
+        m_scratchpad = new rebalance::ScratchPad();
+    }
+    return *m_scratchpad;
+}
+
+uint64_t* ThreadContext::segment_buffer(){
+    assert(m_thread_id == util::Thread::get_thread_id() && "Only the thread owning the context can use its buffers");
+    if(m_segment_buffer == nullptr){
+        m_segment_buffer = new uint64_t[ memstore::SparseFile::max_num_qwords() ];
+    }
+    return m_segment_buffer;
+}
+
 /*****************************************************************************
  *                                                                           *
  *   Dump                                                                    *
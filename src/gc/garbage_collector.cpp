@@ -20,6 +20,7 @@
 #include <iostream>
 
 #include "teseo/context/global_context.hpp"
+#include "teseo/context/static_configuration.hpp"
 #include "teseo/gc/item.hpp"
 #include "teseo/gc/simple_queue.hpp"
 #include "teseo/profiler/event_thread.hpp"
@@ -32,7 +33,8 @@ using namespace std;
 
 namespace teseo::gc {
 
-GarbageCollector::GarbageCollector(context::GlobalContext* global_context) : m_global_context(global_context), m_local(new SimpleQueue()), m_profiler(nullptr){
+GarbageCollector::GarbageCollector(context::GlobalContext* global_context) : m_global_context(global_context), m_local(new SimpleQueue()), m_profiler(nullptr),
+        m_backlog(0), m_delay(context::StaticConfiguration::runtime_gc_frequency){
 
 }
 
@@ -80,11 +82,11 @@ void GarbageCollector::unregister(SimpleQueue* local, SimpleQueue* shared){
     }
 }
 
-void GarbageCollector::perform_gc_pass(uint64_t epoch, SimpleQueue* queue){
-    profiler::ScopedTimer profiler { profiler::GC_PERFORM_GC_PASS, m_profiler };
+uint64_t GarbageCollector::perform_gc_pass(uint64_t epoch, SimpleQueue* queue, profiler::EventThread* event_thread){
+    profiler::ScopedTimer profiler { profiler::GC_PERFORM_GC_PASS, event_thread };
 
     COUT_DEBUG("epoch: " << epoch << ", queue: " << queue);
-    if(queue->empty()) return;
+    if(queue->empty()) return 0;
 
     bool success = true;
     int num_elts_removed = 0;
@@ -94,40 +96,52 @@ void GarbageCollector::perform_gc_pass(uint64_t epoch, SimpleQueue* queue){
         num_elts_removed += success;
     }
     queue->pop(num_elts_removed);
+    m_backlog += size - num_elts_removed;
+
+    return num_elts_removed;
 }
 
-void GarbageCollector::execute(){
-    profiler::ScopedTimer profiler { profiler::GC_EXECUTE, m_profiler };
+void GarbageCollector::execute(bool record_profile){
+    profiler::EventThread* event_thread = record_profile ? m_profiler : nullptr; // the profiler of the owner is not thread safe
+    profiler::ScopedTimer profiler { profiler::GC_EXECUTE, event_thread };
 
     // current epoch
     auto epoch = m_global_context->min_epoch();
     COUT_DEBUG("epoch: " << epoch);
 
     util::WriteLatch lock(m_latch);
+    m_backlog = 0;
+    uint64_t num_items_released = 0;
 
     // let's start with our internal queue
     { // restrict the scope for the profiler
-        profiler::ScopedTimer profiler { profiler::GC_QUEUE_LOCAL, m_profiler };
-        perform_gc_pass(epoch, m_local);
+        profiler::ScopedTimer profiler { profiler::GC_QUEUE_LOCAL, event_thread };
+        num_items_released += perform_gc_pass(epoch, m_local, event_thread);
+
+        // after a burst, give the memory of the resized queue back
+        if(m_local->empty() && m_local->capacity() >= 2 * context::StaticConfiguration::gc_queue_initial_capacity){
+            delete m_local;
+            m_local = new SimpleQueue();
+        }
     }
 
     // shared queues
     { // restrict the scope for the profiler
-        profiler::ScopedTimer profiler { profiler::GC_QUEUE_SHARED, m_profiler };
+        profiler::ScopedTimer profiler { profiler::GC_QUEUE_SHARED, event_thread };
         for(uint64_t i =0, sz = m_shared_queues.size(); i < sz; i++){
             if(m_shared_queues[i]->full()){
                 m_shared_queues[i]->resize();
             }
-            perform_gc_pass(epoch, m_shared_queues[i]);
+            num_items_released += perform_gc_pass(epoch, m_shared_queues[i], event_thread);
         }
     }
 
     // local queues
     // we proceed backwards as we are could erase some of the queues
     { // restrict the scope for the profiler
-        profiler::ScopedTimer profiler { profiler::GC_QUEUE_PRIVATE, m_profiler };
+        profiler::ScopedTimer profiler { profiler::GC_QUEUE_PRIVATE, event_thread };
         for(int64_t i = static_cast<int64_t>(m_private_queues.size()) -1; i >= 0; i--){
-            perform_gc_pass(epoch, m_private_queues[i]);
+            num_items_released += perform_gc_pass(epoch, m_private_queues[i], event_thread);
             if(m_private_queues[i]->empty()){
                 delete m_private_queues[i];
                 m_private_queues[i] = nullptr;
@@ -135,6 +149,32 @@ void GarbageCollector::execute(){
             }
         }
     }
+
+    update_delay(num_items_released);
+}
+
+void GarbageCollector::update_delay(uint64_t num_items_released){
+    using namespace std::chrono;
+
+    if(m_backlog >= context::StaticConfiguration::gc_backlog_threshold && num_items_released > 0){
+        // the queues are growing faster than they are drained, but the epochs still allow to make progress
+        m_delay = context::StaticConfiguration::runtime_gc_min_delay;
+    } else if(m_backlog == 0 && num_items_released == 0){
+        // idle, back off
+        m_delay = min<milliseconds>(max<milliseconds>(m_delay, context::StaticConfiguration::runtime_gc_frequency) * 2, context::StaticConfiguration::runtime_gc_max_delay);
+    } else {
+        m_delay = context::StaticConfiguration::runtime_gc_frequency;
+    }
+
+    COUT_DEBUG("backlog: " << m_backlog << ", items released: " << num_items_released << ", next delay: " << m_delay.count() << " ms");
+}
+
+chrono::milliseconds GarbageCollector::delay() const {
+    return m_delay;
+}
+
+uint64_t GarbageCollector::backlog() const {
+    return m_backlog;
 }
 
 void GarbageCollector::mark(void* pointer, void (*deleter)(void*)){
@@ -92,6 +92,10 @@ uint64_t SimpleQueue::size() const {
         return end + (m_capacity - start -1);
 }
 
+uint64_t SimpleQueue::capacity() const {
+    return m_capacity -1; // one slot is always wasted
+}
+
 bool SimpleQueue::push(const Item& item){
     // Now, invoking full() may return true even when it is not. This occurs when the queue has been resized
     // in the meanwhile by the garbage collector. But that's fine, the thread context will insert the item
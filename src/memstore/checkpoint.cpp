@@ -0,0 +1,445 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "teseo/memstore/checkpoint.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "teseo/context/global_context.hpp"
+#include "teseo/context/scoped_epoch.hpp"
+#include "teseo/context/static_configuration.hpp"
+#include "teseo/context/thread_context.hpp"
+#include "teseo/memstore/context.hpp"
+#include "teseo/memstore/index.hpp"
+#include "teseo/memstore/index_entry.hpp"
+#include "teseo/memstore/leaf.hpp"
+#include "teseo/memstore/memstore.hpp"
+#include "teseo/memstore/scan.hpp"
+#include "teseo/memstore/segment.hpp"
+#include "teseo/memstore/sparse_file.hpp"
+#include "teseo/rebalance/merger_service.hpp"
+#include "teseo/rebalance/scratchpad.hpp"
+#include "teseo/transaction/transaction_impl.hpp"
+#include "teseo/util/error.hpp"
+
+//#define DEBUG
+#include "teseo/util/debug.hpp"
+
+using namespace std;
+
+namespace teseo::memstore {
+
+// Same fill factor of the leaves created by the rebalancer on a resize
+constexpr static double FILL_FACTOR = 0.75;
+
+// Extra space to account for dummy vertices, when the edges of a vertex span multiple segments
+static double extra_space_factor(){
+    return 1.0 + static_cast<double>(OFFSET_VERTEX + OFFSET_VERSION + OFFSET_EDGE) / SparseFile::max_num_qwords();
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   Save                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+void Checkpoint::save(context::GlobalContext* global_context, const string& path){
+    static_assert(sizeof(Element) == 2 * sizeof(uint64_t), "Same size of an element in the scratchpad");
+    Memstore* memstore = global_context->memstore();
+    COUT_DEBUG("path: " << path);
+
+    // Split the key space according to the current leaves, aligned to the vertex boundaries
+    vector<uint64_t> boundaries { 0 };
+    {
+        context::ScopedEpoch epoch; // index_find() requires being inside an epoch
+        Key key = KEY_MIN;
+        do {
+            IndexEntry entry = memstore->index()->find(key.source(), key.destination());
+            Key hfkey = entry.leaf()->get_hfkey();
+            if(hfkey <= key) break; // the leaf has been rebalanced in the meanwhile, the boundaries are only a hint anyway
+            key = hfkey;
+            if(key != KEY_MAX && key.source() > boundaries.back()){ boundaries.push_back(key.source()); }
+        } while(key != KEY_MAX);
+    }
+    boundaries.push_back(numeric_limits<uint64_t>::max());
+    const uint64_t num_blocks = boundaries.size() -1;
+
+    // The content of the checkpoint is the one visible to this transaction
+    transaction::TransactionImpl* transaction = context::thread_context()->create_transaction(/* read only ? */ true);
+
+    Header header;
+    header.m_magic = 0; // not valid until the whole file has been written
+    header.m_is_directed = memstore->is_directed();
+    header.m_num_elements = 0;
+    { // must be inside an epoch
+        context::ScopedEpoch epoch;
+        header.m_properties = transaction->graph_properties();
+    }
+
+    string path_tmp = path + ".tmp";
+    fstream file(path_tmp, ios::out | ios::binary | ios::trunc);
+    if(!file.good()){
+        transaction->commit();
+        transaction->decr_user_count();
+        RAISE_EXCEPTION(InternalError, "[Checkpoint] Cannot create the file `" << path_tmp << "'");
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Scan the blocks in parallel, while the file is written in key order by this thread
+    vector<vector<Element>> blocks(num_blocks);
+    vector<bool> block_done(num_blocks, false);
+    atomic<uint64_t> next_block = 0;
+    exception_ptr error;
+    mutex mutex_;
+    condition_variable condvar;
+    vector<thread> workers;
+    uint64_t num_workers = min<uint64_t>(max(1u, thread::hardware_concurrency()), num_blocks);
+    for(uint64_t i = 0; i < num_workers; i++){
+        workers.emplace_back([&](){
+            global_context->register_thread();
+            uint64_t block_id;
+            while((block_id = next_block++) < num_blocks){
+                vector<Element> elements;
+                try {
+                    save(memstore, transaction, boundaries[block_id], boundaries[block_id +1], elements);
+                } catch(...) {
+                    scoped_lock<mutex> lock(mutex_);
+                    if(error == nullptr){ error = current_exception(); }
+                }
+
+                scoped_lock<mutex> lock(mutex_);
+                blocks[block_id] = move(elements);
+                block_done[block_id] = true;
+                condvar.notify_all();
+            }
+            global_context->unregister_thread();
+        });
+    }
+
+    for(uint64_t block_id = 0; block_id < num_blocks; block_id++){
+        vector<Element> elements;
+        {
+            unique_lock<mutex> lock(mutex_);
+            condvar.wait(lock, [&](){ return block_done[block_id]; });
+            elements = move(blocks[block_id]);
+        }
+
+        file.write(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(Element));
+        header.m_num_elements += elements.size();
+    }
+    for(auto& w : workers){ w.join(); }
+
+    transaction->commit();
+    transaction->decr_user_count();
+
+    if(error != nullptr){
+        file.close();
+        ::remove(path_tmp.c_str());
+        rethrow_exception(error);
+    }
+
+    // Finally, validate the header
+    header.m_magic = MAGIC;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    if(!file.good()){
+        ::remove(path_tmp.c_str());
+        RAISE_EXCEPTION(InternalError, "[Checkpoint] Cannot write the file `" << path_tmp << "'");
+    }
+
+    if(::rename(path_tmp.c_str(), path.c_str()) != 0){
+        RAISE_EXCEPTION(InternalError, "[Checkpoint] Cannot rename the file `" << path_tmp << "' into `" << path << "': " << strerror(errno) << " (" << errno << ")");
+    }
+
+    COUT_DEBUG("blocks: " << num_blocks << ", elements: " << header.m_num_elements);
+}
+
+void Checkpoint::save(Memstore* memstore, transaction::TransactionImpl* transaction, uint64_t vertex_start, uint64_t vertex_end, vector<Element>& out_elements){
+    uint64_t last_vertex = 0; // position of the last vertex in out_elements
+
+    memstore->scan</* weights ? */ true>(transaction, vertex_start, 0, [&](uint64_t source, uint64_t destination, double weight){
+        if(source >= vertex_end) return false;
+
+        Element element;
+        if(destination == 0){ // this is a vertex
+            element.m_vertex.m_vertex_id = source;
+            element.m_vertex.m_first = 1;
+            element.m_vertex.m_lock = 0;
+            element.m_vertex.m_count = 0;
+            last_vertex = out_elements.size();
+        } else { // this is an edge
+            assert(!out_elements.empty() && out_elements[last_vertex].m_vertex.m_vertex_id == source && "Source vertex missing");
+            element.m_edge.m_destination = destination;
+            element.m_edge.m_weight = weight;
+            out_elements[last_vertex].m_vertex.m_count++;
+        }
+        out_elements.push_back(element);
+
+        return true;
+    });
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   Restore                                                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+void Checkpoint::restore(context::GlobalContext* global_context, const string& path){
+    Memstore* memstore = global_context->memstore();
+    COUT_DEBUG("path: " << path);
+
+    // Map the file in memory
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){ RAISE_EXCEPTION(InternalError, "[Checkpoint] Cannot open the file `" << path << "': " << strerror(errno) << " (" << errno << ")"); }
+    struct stat file_stat;
+    if(::fstat(fd, &file_stat) != 0){
+        int errno_ = errno;
+        ::close(fd);
+        RAISE_EXCEPTION(InternalError, "[Checkpoint] Cannot stat the file `" << path << "': " << strerror(errno_) << " (" << errno_ << ")");
+    }
+    const uint64_t file_sz = file_stat.st_size;
+    if(file_sz < sizeof(Header)){
+        ::close(fd);
+        RAISE_EXCEPTION(InternalError, "[Checkpoint] Invalid file `" << path << "': too small");
+    }
+    void* content = ::mmap(nullptr, file_sz, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(content == MAP_FAILED){ RAISE_EXCEPTION(InternalError, "[Checkpoint] Cannot map the file `" << path << "': " << strerror(errno) << " (" << errno << ")"); }
+    ::madvise(content, file_sz, MADV_SEQUENTIAL);
+
+    try {
+        const Header* header = reinterpret_cast<const Header*>(content);
+        if(header->m_magic != MAGIC || sizeof(Header) + header->m_num_elements * sizeof(Element) != file_sz){
+            RAISE_EXCEPTION(InternalError, "[Checkpoint] Invalid file `" << path << "': corrupted or incomplete");
+        }
+        if(static_cast<bool>(header->m_is_directed) != memstore->is_directed()){
+            RAISE_EXCEPTION(LogicalError, "[Checkpoint] The checkpoint `" << path << "' refers to a " << (header->m_is_directed ? "directed" : "undirected") << " graph");
+        }
+        const Element* elements = reinterpret_cast<const Element*>(header +1);
+
+        // The restored leaves replace the first leaf of the memstore, which must be empty
+        Leaf* first_leaf = nullptr;
+        {
+            context::ScopedEpoch epoch; // index_find() requires being inside an epoch
+            first_leaf = memstore->index()->find(0, 0).leaf();
+            bool is_empty = first_leaf->get_hfkey() == KEY_MAX;
+            Context context { memstore };
+            context.m_leaf = first_leaf;
+            for(uint64_t segment_id = 0; segment_id < first_leaf->num_segments() && is_empty; segment_id++){
+                context.m_segment = first_leaf->get_segment(segment_id);
+                is_empty = context.m_segment->is_sparse() && context.sparse_file()->is_empty();
+            }
+            if(!is_empty){ RAISE_EXCEPTION(LogicalError, "[Checkpoint] The database must be empty to restore a checkpoint"); }
+        }
+
+        vector<LeafRange> leaves = partition(elements, header->m_num_elements);
+        COUT_DEBUG("elements: " << header->m_num_elements << ", leaves: " << leaves.size());
+
+        // The merger must not visit the leaves while they are created
+        memstore->merger()->stop();
+
+        atomic<uint64_t> next_leaf = 0;
+        exception_ptr error;
+        mutex mutex_;
+        vector<thread> workers;
+        uint64_t num_workers = min<uint64_t>(max(1u, thread::hardware_concurrency()), leaves.size());
+        for(uint64_t i = 0; i < num_workers; i++){
+            workers.emplace_back([&](){
+                global_context->register_thread();
+                rebalance::ScratchPad scratchpad;
+                uint64_t leaf_id;
+                while((leaf_id = next_leaf++) < leaves.size()){
+                    try {
+                        Leaf* leaf = (leaf_id == 0) ? first_leaf : create_leaf();
+                        const LeafRange* next = (leaf_id +1 < leaves.size()) ? &(leaves[leaf_id +1]) : nullptr;
+                        restore(memstore, leaf, elements, &(leaves[leaf_id]), next, scratchpad);
+                    } catch(...) {
+                        scoped_lock<mutex> lock(mutex_);
+                        if(error == nullptr){ error = current_exception(); }
+                    }
+                }
+                global_context->unregister_thread();
+            });
+        }
+        for(auto& w : workers){ w.join(); }
+
+        memstore->merger()->start();
+        if(error != nullptr){ rethrow_exception(error); }
+
+        // Finally, restore the number of vertices & edges in the graph
+        if(header->m_properties){
+            transaction::TransactionImpl* transaction = context::thread_context()->create_transaction(/* read only ? */ false);
+            transaction->local_graph_changes() = header->m_properties;
+            transaction->commit();
+            transaction->decr_user_count();
+        }
+    } catch(...){
+        ::munmap(content, file_sz);
+        throw;
+    }
+
+    ::munmap(content, file_sz);
+}
+
+vector<Checkpoint::LeafRange> Checkpoint::partition(const Element* elements, uint64_t num_elements){
+    const double leaf_capacity = FILL_FACTOR * context::StaticConfiguration::memstore_max_num_segments_per_leaf * SparseFile::max_num_qwords() / extra_space_factor(); // in qwords
+    vector<LeafRange> leaves;
+    LeafRange current { 0, 0, 0, 0 };
+
+    uint64_t pos = 0;
+    while(pos < num_elements){
+        const uint64_t num_edges = elements[pos].m_vertex.m_count;
+        const uint64_t space_required = OFFSET_VERTEX + num_edges * OFFSET_EDGE;
+
+        if(current.m_space > 0 && current.m_space + space_required > leaf_capacity){ // start a new leaf
+            current.m_end = pos;
+            leaves.push_back(current);
+            current = LeafRange { pos, 0, pos, 0 };
+        }
+
+        if(current.m_space + space_required <= leaf_capacity){ // the vertex fits in the current leaf
+            current.m_space += space_required;
+        } else { // the edges of this vertex span multiple leaves
+            current.m_space += OFFSET_VERTEX;
+            uint64_t edge = pos +1;
+            const uint64_t edge_end = pos + 1 + num_edges;
+            while(true){
+                uint64_t leaf_edges = max<uint64_t>(1, (leaf_capacity - current.m_space) / OFFSET_EDGE);
+                leaf_edges = min(leaf_edges, edge_end - edge);
+                current.m_space += leaf_edges * OFFSET_EDGE;
+                edge += leaf_edges;
+                if(edge == edge_end) break;
+
+                current.m_end = edge;
+                leaves.push_back(current);
+                current = LeafRange { edge, 0, pos, /* dummy vertex */ OFFSET_VERTEX };
+            }
+        }
+
+        pos += 1 + num_edges;
+    }
+
+    if(current.m_space > 0){
+        current.m_end = num_elements;
+        leaves.push_back(current);
+    }
+
+    return leaves;
+}
+
+Key Checkpoint::get_minimum(const Element* elements, const LeafRange* range){
+    if(range == nullptr){
+        return KEY_MAX;
+    } else if(range->m_vertex == range->m_start){
+        return Key { elements[range->m_start].m_vertex.m_vertex_id };
+    } else {
+        return Key { elements[range->m_vertex].m_vertex.m_vertex_id, elements[range->m_start].m_edge.m_destination };
+    }
+}
+
+void Checkpoint::restore(Memstore* memstore, Leaf* leaf, const Element* elements, const LeafRange* range, const LeafRange* next, rebalance::ScratchPad& scratchpad){
+    context::ScopedEpoch epoch; // the index requires being inside an epoch
+    Context context { memstore };
+    context.m_leaf = leaf;
+    const bool is_first_leaf = range->m_start == 0;
+
+    // Load the elements into the scratchpad
+    scratchpad.clear();
+    scratchpad.ensure_capacity(range->m_end - range->m_start +1);
+    if(range->m_vertex < range->m_start){ // the first vertex was stored in the previous leaf
+        Vertex dummy = elements[range->m_vertex].m_vertex;
+        const uint64_t vertex_end = range->m_vertex + 1 + dummy.m_count;
+        dummy.m_first = 0;
+        dummy.m_count = min(vertex_end, range->m_end) - range->m_start;
+        scratchpad.load_vertex(&dummy, nullptr);
+    }
+    const uint64_t offset = scratchpad.size();
+    scratchpad.load(elements + range->m_start, range->m_end - range->m_start);
+    if(next != nullptr && next->m_vertex < next->m_start && next->m_vertex >= range->m_start){ // the edges of the last vertex continue in the next leaf
+        scratchpad.get_vertex(offset + next->m_vertex - range->m_start)->m_count = next->m_start - next->m_vertex -1;
+    }
+
+    // Spread the elements among the segments of the leaf
+    const uint64_t num_segments = leaf->num_segments();
+    const uint64_t space_required = range->m_space;
+    const uint64_t num_filled_segments = min<uint64_t>(num_segments, max<uint64_t>(1, ceil( space_required * extra_space_factor() / (FILL_FACTOR * SparseFile::max_num_qwords()) )));
+    const double empty_per_filled = static_cast<double>(num_segments - num_filled_segments) / num_filled_segments;
+    double empty_balance = 0;
+    uint64_t num_segments_saved = 0;
+    uint64_t budget_achieved = 0;
+    int64_t pos_vertex = 0;
+    int64_t pos_element = 0;
+
+    for(uint64_t segment_id = 0; segment_id < num_segments; segment_id++){
+        context.m_segment = leaf->get_segment(segment_id);
+
+        int64_t target_budget = 0;
+        if(num_segments_saved < num_filled_segments && (empty_balance < 1.0 || num_segments - segment_id <= num_filled_segments - num_segments_saved)){ // fill the segment
+            target_budget = (space_required - budget_achieved) / (num_filled_segments - num_segments_saved);
+            empty_balance += empty_per_filled;
+            num_segments_saved++;
+        } else { // leave the segment empty
+            empty_balance -= 1.0;
+        }
+
+        int64_t in_budget_achieved = 0;
+        Segment::save(context, scratchpad, pos_vertex, pos_element, target_budget, &in_budget_achieved);
+        budget_achieved += in_budget_achieved;
+    }
+    assert(pos_element == (int64_t) scratchpad.size() && "Not all elements have been saved");
+
+    // Set the fence keys, index the segments and populate the vertex table
+    Key hfkey = get_minimum(elements, next);
+    leaf->set_hfkey(hfkey);
+    for(int64_t segment_id = num_segments -1; segment_id >= 0; segment_id--){
+        Segment* segment = context.m_segment = leaf->get_segment(segment_id);
+        SparseFile* sf = context.sparse_file();
+
+        if(sf->is_empty()){
+            segment->m_fence_key = hfkey;
+        } else {
+            Key lfkey = (is_first_leaf && segment_id == 0) ? KEY_MIN /* already in the index */ : sf->get_minimum();
+            segment->m_fence_key = lfkey;
+            if(lfkey != KEY_MIN){
+                memstore->index()->insert(lfkey.source(), lfkey.destination(), IndexEntry{ leaf, (uint64_t) segment_id });
+            }
+            hfkey = lfkey;
+
+            Segment::prune(context, /* rebuild the vertex table ? */ true);
+        }
+    }
+}
+
+} // namespace
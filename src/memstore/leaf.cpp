@@ -33,6 +33,8 @@
 #include "teseo/memstore/segment.hpp"
 #include "teseo/memstore/sparse_file.hpp"
 #include "teseo/profiler/scoped_timer.hpp"
+#include "teseo/util/numa.hpp"
+#include "teseo/util/thread.hpp"
 
 //#define DEBUG
 #include "teseo/util/debug.hpp"
@@ -41,6 +43,21 @@ using namespace std;
 
 namespace teseo::memstore {
 
+static atomic<uint64_t> g_memory_footprint = 0; // total amount of memory, in bytes, allocated for the leaves
+
+// With multiple NUMA nodes, the leaves are explicitly allocated in the node of the thread creating them
+constexpr static bool NUMA_ALLOCATION = context::StaticConfiguration::numa_enabled && context::StaticConfiguration::numa_num_nodes > 1;
+static_assert(context::StaticConfiguration::numa_num_nodes <= numeric_limits<uint8_t>::max(), "The node is stored in a uint8_t");
+
+// Release the memory of a leaf
+static void release_memory(Leaf* leaf){
+    if(NUMA_ALLOCATION){
+        util::NUMA::free(leaf);
+    } else {
+        free(leaf);
+    }
+}
+
 #if defined(DEBUG)
 static atomic<int64_t> g_debug_num_invocations_create = 0;
 static atomic<int64_t> g_debug_num_invocations_destroy = 0;
@@ -79,12 +96,21 @@ namespace internal {
 Leaf* allocate_leaf(uint64_t num_segments){
     assert(num_segments <= numeric_limits<uint32_t>::max() && "Type overflow, num_segments is ultimately stored into a uint32_t");
 
-    const uint64_t space_required = sizeof(Leaf) + Leaf::data_size_bytes(num_segments) * 2 /* x2 = vertices/edges + weights */;
+    const uint64_t space_required = Leaf::allocation_size(num_segments);
 //    int rc = posix_memalign(&heap, /* alignment = */ 2097152ull /* 2MB */,  /* size = */ space_required); // with huge pages
 //    int rc = posix_memalign(&heap, /* alignment = */ 1ull << 12 /* 4 Kb */,  /* size = */ space_required); // with the buffer manager
-    void* heap = malloc(space_required);
+    void* heap = nullptr;
+    int numa_node = 0;
+    if(NUMA_ALLOCATION){
+        numa_node = util::Thread::get_numa_id();
+        heap = util::NUMA::malloc(space_required, numa_node);
+    } else {
+        heap = malloc(space_required);
+    }
     if(heap == nullptr) throw std::runtime_error("[create_leaf] cannot obtain a chunk of aligned memory");
     Leaf* leaf = new (heap) Leaf(num_segments);
+    leaf->m_numa_node = numa_node;
+    g_memory_footprint += space_required;
 
     COUT_DEBUG("leaf: " << heap << ", "
                "num segments: " << leaf->num_segments() << ", "
@@ -120,21 +146,27 @@ void Leaf::destroy_leaf(Leaf* leaf){
             segment->~Segment();
         }
 
+        g_memory_footprint -= allocation_size(leaf->num_segments());
         leaf->~Leaf();
 
-        free(leaf);
+        release_memory(leaf);
     }
 }
 
 namespace internal {
 void deallocate_leaf(Leaf* leaf){
     if(leaf != nullptr){
+        g_memory_footprint -= Leaf::allocation_size(leaf->num_segments());
         leaf->~Leaf();
-        free(leaf);
+        release_memory(leaf);
     }
 }
 } // namespace
 
+uint64_t Leaf::memory_footprint(){
+    return g_memory_footprint;
+}
+
 /*****************************************************************************
  *                                                                           *
  *   Fence keys                                                              *
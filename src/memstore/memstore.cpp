@@ -174,7 +174,7 @@ void Memstore::insert_edge(transaction::TransactionImpl* transaction, uint64_t s
 
     // First, insert the update in the undo, flagged as deletion
     Update update { /* vertex ? */ false, /* insert ? */ false, Key(source, destination), weight };
-    transaction->add_undo(this, update);
+    transaction->add_undo(this, UndoEdgeInsertion{ update, weight });
 
     // Now, set the update as an insertion
     update.flip();
@@ -193,7 +193,7 @@ void Memstore::insert_edge(transaction::TransactionImpl* transaction, uint64_t s
         // second, insert the edge destination -> source. This call will ensure that destination exists
         update.swap();
         update.flip();
-        transaction->add_undo(this, update);
+        transaction->add_undo(this, UndoEdgeInsertion{ update, weight });
         update.flip();
         assert(update.is_insert() && update.is_edge() && update.source() == destination && update.destination() == source && update.weight() == weight);
 
@@ -265,6 +265,22 @@ void Memstore::remove_edge(transaction::TransactionImpl* transaction, uint64_t s
     } // undirected
 }
 
+void Memstore::redo(transaction::TransactionImpl* transaction, const Update& update){
+    Context context { this, transaction };
+
+    // First, insert the inverse of the update in the undo
+    Update undo = update;
+    undo.flip();
+    if(undo.is_edge() && undo.is_remove()){
+        transaction->add_undo(this, UndoEdgeInsertion{ undo, update.weight() });
+    } else {
+        transaction->add_undo(this, undo);
+    }
+
+    // Then, perform the update as it was originally stored
+    write(context, update, /* source vertex exists ? */ true);
+}
+
 void Memstore::write(Context& context, const Update& update, bool has_source_vertex) {
     profiler::ScopedTimer profiler { update.is_vertex() ? profiler::MEMSTORE_WRITE_VERTEX : profiler::MEMSTORE_WRITE_EDGE };
 
@@ -482,14 +498,16 @@ void Memstore::aux_view(transaction::TransactionImpl* transaction, aux::Builder*
         context::ScopedEpoch epoch; // protect from the GC, before using #index_find()
 
         Key key_to = KEY_MAX;
+        int numa_node = 0;
 
         do {
             Leaf* leaf = index()->find(key_from.source(), key_from.destination()).leaf();
             key_to = leaf->get_hfkey();
+            numa_node = leaf->numa_node();
         } while(key_to < key_from); // protect from rebalances
 
         aux::PartialResult* partial_result = builder->issue(key_from, key_to);
-        rt->aux_partial_result(context, partial_result);
+        rt->aux_partial_result(context, partial_result, numa_node);
 
         // next iteration
         key_from = key_to;
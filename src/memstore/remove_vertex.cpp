@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "teseo/context/scoped_epoch.hpp"
+#include "teseo/context/thread_context.hpp"
 #include "teseo/memstore/context.hpp"
 #include "teseo/memstore/data_item.hpp"
 #include "teseo/memstore/error.hpp"
@@ -55,7 +56,7 @@ RemoveVertex::RemoveVertex(Context& context, uint64_t vertex_id, vector<uint64_t
         m_owns_outgoing_edges = true;
     }
 
-    m_scratchpad = new uint64_t[ SparseFile::max_num_qwords() ];
+    m_scratchpad = context::thread_context()->segment_buffer();
 }
 
 RemoveVertex::~RemoveVertex(){
@@ -64,7 +65,7 @@ RemoveVertex::~RemoveVertex(){
         m_owns_outgoing_edges = false;
     }
 
-    delete[] m_scratchpad; m_scratchpad = nullptr;
+    m_scratchpad = nullptr; // owned by the thread context
 }
 
 
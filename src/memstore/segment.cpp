@@ -57,7 +57,7 @@ namespace teseo::memstore {
  *                                                                           *
  *****************************************************************************/
 
-Segment::Segment() : m_flags(0),  m_fence_key( KEY_MAX ), m_latch(0) {
+Segment::Segment() : m_flags(0), m_num_removals(0), m_fence_key( KEY_MAX ), m_latch(0) {
     m_time_last_rebal = chrono::steady_clock::now();
     m_crawler = nullptr;
     m_used_space = 0;
@@ -596,8 +596,10 @@ void Segment::update(Context& context, const Update& update, bool has_source_ver
         assert(segment->is_dense());
         segment->m_used_space += dense_file(context)->update(context, update, has_source_vertex);
     }
+    if(update.is_remove()){ segment->incr_num_removals(); }
 
     request_async_rebalance(context);
+    request_async_prune(context);
 }
 
 void Segment::remove_vertex(RemoveVertex& instance){
@@ -622,6 +624,7 @@ void Segment::remove_vertex(RemoveVertex& instance){
         assert(segment->is_dense());
         segment->m_used_space += dense_file(context)->remove_vertex(instance);
     }
+    segment->incr_num_removals();
 
     if(!instance.done()){
         instance.m_key = Segment::get_hfkey(context);
@@ -631,6 +634,7 @@ void Segment::remove_vertex(RemoveVertex& instance){
     }
 
     request_async_rebalance(context);
+    request_async_prune(context);
 }
 
 void Segment::unlock_vertex(RemoveVertex& instance){
@@ -690,6 +694,21 @@ void Segment::request_async_rebalance(Context& context){
     context.m_tree->global_context()->runtime()->schedule_rebalance(context, segment->m_fence_key);
 }
 
+void Segment::request_async_prune(Context& context){
+    Segment* segment = context.m_segment;
+    if(!segment->is_sparse()) return; // dense files do not support pruning
+    if(segment->has_requested_prune() || segment->has_requested_rebalance()) return; // a rebalance also prunes the versions
+
+    constexpr uint64_t THRESHOLD = context::StaticConfiguration::memstore_prune_threshold * SparseFile::max_num_qwords();
+    if(context.sparse_file()->versions_space() < THRESHOLD){
+        return; // the versions area is still small
+    }
+
+    COUT_DEBUG("Request prune, leaf: " << context.m_leaf << ", segment: " << context.segment_id());
+    segment->set_flag(FLAG_PRUNE_REQUESTED, 1);
+    context.m_tree->global_context()->runtime()->schedule_prune(context, segment->m_fence_key);
+}
+
 /*****************************************************************************
  *                                                                           *
  *   Point look ups                                                          *
@@ -908,6 +927,7 @@ uint64_t Segment::prune(Context& context, bool rebuild_vertex_table){
 
                 result = segment->m_used_space = sf->used_space();
                 segment->cancel_rebalance_request();
+                segment->set_flag(FLAG_PRUNE_REQUESTED, 0);
 
                 // unlock the segment
                 segment->writer_exit();
@@ -967,12 +987,17 @@ bool Segment::need_rebuild_vertex_table() const {
 void Segment::mark_rebalanced(){
     m_time_last_rebal = std::chrono::steady_clock::now();
     set_flag(FLAG_REBAL_REQUESTED, 0);
+    set_flag(FLAG_PRUNE_REQUESTED, 0);
 }
 
 void Segment::cancel_rebalance_request() {
     set_flag(FLAG_REBAL_REQUESTED, 0);
 }
 
+bool Segment::has_requested_prune() const {
+    return get_flag(FLAG_PRUNE_REQUESTED);
+}
+
 rebalance::Crawler* Segment::get_crawler() const noexcept {
     return m_crawler;
 }
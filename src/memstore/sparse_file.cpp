@@ -1857,7 +1857,7 @@ void SparseFile::save(Context& context, rebalance::ScratchPad& scratchpad, int64
     COUT_DEBUG("[before] target_budget: " << target_budget << " qwords, pos_next_vertex: " << pos_next_vertex << ", pos_next_element: " << pos_next_element);
 
     // fill the lhs
-    int64_t target_budget_lhs = min<int64_t>(target_budget, target_budget / 2 + (context::StaticConfiguration::test_mode ? 1ull : OFFSET_VERTEX * 3)); // put a few elements more in the lhs than in the rhs
+    int64_t target_budget_lhs = get_target_budget_lhs(target_budget);
     int64_t achieved_budget_lhs = 0;
     fill(context, scratchpad, /* lhs ? */ true, pos_next_vertex, pos_next_element, target_budget_lhs, &achieved_budget_lhs);
 
@@ -1874,6 +1874,20 @@ void SparseFile::save(Context& context, rebalance::ScratchPad& scratchpad, int64
     COUT_DEBUG("[after] target_budget: " << target_budget << " qwords, achieved: " << budget_achieved << " qwords (lhs: " << achieved_budget_lhs << " qwords, rhs: " << achieved_budget_rhs << " qwords), pos_next_vertex: " << pos_next_vertex << ", pos_next_element: " << pos_next_element);
 }
 
+void SparseFile::save_dry_run(Context& context, const rebalance::ScratchPad& scratchpad, int64_t& pos_next_vertex, int64_t& pos_next_element, int64_t target_budget, int64_t* out_budget_achieved){
+    int64_t achieved_budget_lhs = 0;
+    get_num_elts_to_store(context, scratchpad, /* lhs ? */ true, pos_next_vertex, pos_next_element, get_target_budget_lhs(target_budget), &achieved_budget_lhs);
+
+    int64_t achieved_budget_rhs = 0;
+    get_num_elts_to_store(context, scratchpad, /* lhs ? */ false, pos_next_vertex, pos_next_element, max<int64_t>(0ll, target_budget - achieved_budget_lhs), &achieved_budget_rhs);
+
+    *out_budget_achieved = achieved_budget_lhs + achieved_budget_rhs;
+}
+
+int64_t SparseFile::get_target_budget_lhs(int64_t target_budget){
+    return min<int64_t>(target_budget, target_budget / 2 + (context::StaticConfiguration::test_mode ? 1ull : OFFSET_VERTEX * 3)); // put a few elements more in the lhs than in the rhs
+}
+
 void SparseFile::fill(Context& context, rebalance::ScratchPad& scratchpad, bool is_lhs, int64_t& pos_next_vertex, int64_t& pos_next_element, int64_t target_budget, int64_t* out_budget){
     profiler::ScopedTimer profiler { profiler::SF_SAVE_FILL };
     COUT_DEBUG("[before] is_lhs: " << boolalpha << is_lhs << ", pos_next_vertex: " << pos_next_vertex << ", pos_next_element: " << pos_next_element << ", target_budget: " << target_budget << " qwords");
@@ -1881,7 +1895,9 @@ void SparseFile::fill(Context& context, rebalance::ScratchPad& scratchpad, bool
     // decide in advance how many elements to copy from the scratchpad
     int64_t num_elements = 0; // number of elements to write
     int64_t num_versions = 0; // number of versions to store
-    std::tie(num_elements, num_versions) = get_num_elts_to_store(context, scratchpad, is_lhs, pos_next_vertex, pos_next_element, target_budget, out_budget);
+    int64_t pos_end_vertex = pos_next_vertex;
+    int64_t pos_end_element = pos_next_element;
+    std::tie(num_elements, num_versions) = get_num_elts_to_store(context, scratchpad, is_lhs, pos_end_vertex, pos_end_element, target_budget, out_budget);
 
     // update the segment boundaries
     uint64_t real_space_needed = *out_budget + /* in case we need to write a dummy vertex */ (num_elements > 0 && pos_next_vertex < pos_next_element) * OFFSET_VERTEX;
@@ -1902,6 +1918,7 @@ void SparseFile::fill(Context& context, rebalance::ScratchPad& scratchpad, bool
 
     // finally copy the elts from the scratchpad to the segment
     save_elements(context, scratchpad, is_lhs, pos_next_vertex, pos_next_element, num_elements);
+    assert(pos_next_vertex == pos_end_vertex && pos_next_element == pos_end_element && "Mismatch with the positions computed in advance, see #save_dry_run()");
 
 #if defined(DEBUG)
     COUT_DEBUG("[after] is_lhs: " << boolalpha << is_lhs << ", pos_next_vertex: " << pos_next_vertex << ", pos_next_element: " << pos_next_element << ", target budget: " << target_budget << " qwords, achieved: " << *out_budget << " qwords");
@@ -1909,7 +1926,7 @@ void SparseFile::fill(Context& context, rebalance::ScratchPad& scratchpad, bool
 #endif
 }
 
-std::pair</* elts */ int64_t, /* versions */ int64_t> SparseFile::get_num_elts_to_store(Context& context, const rebalance::ScratchPad& scratchpad, bool is_lhs, int64_t pos_next_vertex, int64_t pos_next_element, int64_t target_budget, int64_t* out_budget){
+std::pair</* elts */ int64_t, /* versions */ int64_t> SparseFile::get_num_elts_to_store(Context& context, const rebalance::ScratchPad& scratchpad, bool is_lhs, int64_t& pos_next_vertex, int64_t& pos_next_element, int64_t target_budget, int64_t* out_budget){
     *out_budget = 0;
     int64_t num_elts = 0;
     int64_t num_versions = 0;
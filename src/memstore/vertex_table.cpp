@@ -20,6 +20,7 @@
 #include <cassert>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <string>
 
@@ -178,9 +179,10 @@ DirectPointer VertexTable::get(uint64_t vertex_id, uint64_t numa_node) const noe
 void VertexTable::upsert(uint64_t vertex_id, const DirectPointer& dptr_new) noexcept {
     assert(dptr_new.leaf() != nullptr && "Pointer to a leaf not set");
     if(vertex_id == TOMBSTONE){ return upsert_vertex1(dptr_new); } // special case
+    // The insertions are serialised among themselves, the readers and the removals only rely on the atomic
+    // loads/stores of the single entries
+    std::scoped_lock<util::SpinLock> lock(m_writer_latch);
     if(fill_factor() > context::StaticConfiguration::vertex_table_max_fill_factor){ resize(); }
-    // There is no need to lock anything here, only the Merger service can invoke this method and there
-    // is only one of these guys around.
 
     CompressedDirectPointer cdptr_new = dptr_new.compress();
 
@@ -408,7 +410,7 @@ void VertexTable::resize(){
 void VertexTable::do_resize(){
     Entry* hashtables[context::StaticConfiguration::numa_num_nodes];
     void* allocations[context::StaticConfiguration::numa_num_nodes];
-    uint64_t num_entries_new = std::max<int64_t>(static_cast<double>(m_num_elts - m_num_tombstones) /2.0 / 0.3, context::StaticConfiguration::vertex_table_min_capacity);
+    uint64_t num_entries_new = num_entries_required();
     std::tie(allocations[0], hashtables[0]) = allocate_hash_table(num_entries_new, 0);
     Entry* table_new = hashtables[0];
     Entry* table_old = m_hashtables[0];
@@ -477,6 +479,23 @@ void VertexTable::do_resize(){
     m_num_tombstones = 0;
 }
 
+uint64_t VertexTable::num_entries_required() const {
+    return std::max<int64_t>(static_cast<double>(m_num_elts - m_num_tombstones) /2.0 / 0.3, context::StaticConfiguration::vertex_table_min_capacity);
+}
+
+void VertexTable::compact(){
+    std::scoped_lock<util::SpinLock> lock(m_writer_latch);
+    // a resize leaves the table 30% full: shrink when it would fit in a quarter of the current capacity or, anyway, when
+    // the tombstones outnumber the live elements
+    if(num_entries_required() *4 <= m_num_entries || m_num_tombstones > m_num_elts - m_num_tombstones){
+        resize();
+    }
+}
+
+uint64_t VertexTable::capacity() const {
+    return m_num_entries;
+}
+
 double VertexTable::fill_factor() const{
     return static_cast<double>(m_num_elts - m_num_tombstones) / (m_num_entries *2);
 }
@@ -170,6 +170,9 @@ Plan Crawler::make_plan() {
 
     leaf_xlock();
 
+    // keep track of the rebalances started from the tail of the last leaf, to detect whether the elements are being appended
+    m_context.m_leaf->set_tail_rebalance(is_tail(segment_id));
+
     window_length *= 2;
     while(!do_rebalance && window_length <= num_segments_leaf){
         height = log2(window_length) +1.;
@@ -234,8 +237,24 @@ Plan Crawler::make_plan() {
     } else { // split
         m_window_start = 0;
         m_window_end = num_segments_leaf;
-        return Plan::create_split(cardinality(), m_used_space, m_context.m_leaf);
+        if(m_context.m_leaf->num_tail_rebalances() >= context::StaticConfiguration::rebalance_append_threshold){
+            return Plan::create_append(cardinality(), m_used_space, m_context.m_leaf);
+        } else {
+            return Plan::create_split(cardinality(), m_used_space, m_context.m_leaf);
+        }
+    }
+}
+
+bool Crawler::is_tail(uint64_t segment_id) const {
+    const Leaf* leaf = m_context.m_leaf;
+    if(leaf->get_hfkey() != KEY_MAX) return false; // not the last leaf
+
+    // the following segments are not locked, the check is only a hint
+    for(uint64_t i = segment_id +1, end = leaf->num_segments(); i < end; i++){
+        if(leaf->get_segment(i)->used_space() > 0) return false;
     }
+
+    return true;
 }
 
 void Crawler::lock2merge(){
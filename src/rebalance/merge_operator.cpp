@@ -17,9 +17,13 @@
 
 #include "teseo/rebalance/merge_operator.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/scoped_epoch.hpp"
 #include "teseo/context/static_configuration.hpp"
+#include "teseo/context/thread_context.hpp"
 #include "teseo/memstore/context.hpp"
 #include "teseo/memstore/index.hpp"
 #include "teseo/memstore/key.hpp"
@@ -41,31 +45,62 @@ using namespace std;
 
 namespace teseo::rebalance {
 
-MergeOperator::MergeOperator(const memstore::Context& context) : m_context(context), m_scratchpad(nullptr){
-    m_scratchpad = new ScratchPad(context::StaticConfiguration::memstore_segment_size); // okay, even though it's in terms of elements
+/*****************************************************************************
+ *                                                                           *
+ *   Budget                                                                  *
+ *                                                                           *
+ *****************************************************************************/
+
+MergeBudget::MergeBudget(chrono::milliseconds time, uint64_t bytes) : m_deadline(chrono::steady_clock::now() + time), m_qwords(bytes / sizeof(uint64_t)) {
+
+}
+
+void MergeBudget::consume(uint64_t qwords){
+    m_qwords.fetch_sub(qwords, memory_order_relaxed);
+}
+
+bool MergeBudget::exhausted() const {
+    return m_qwords.load(memory_order_relaxed) <= 0 || chrono::steady_clock::now() >= m_deadline;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   Operator                                                                *
+ *                                                                           *
+ *****************************************************************************/
+
+MergeOperator::MergeOperator(const memstore::Context& context, MergeBudget* budget, bool compact) : m_context(context), m_scratchpad(nullptr), m_budget(budget), m_compact(compact){
+    m_scratchpad = &(context::thread_context()->scratchpad());
 }
 
 MergeOperator::~MergeOperator(){
-    delete m_scratchpad; m_scratchpad = nullptr;
+    m_scratchpad = nullptr; // owned by the thread context
 }
 
-void MergeOperator::execute(){
-    COUT_DEBUG("init");
+memstore::Key MergeOperator::execute(memstore::Key from, memstore::Key to){
+    COUT_DEBUG("from: " << from << ", to: " << to);
     profiler::ScopedTimer profiler { profiler::MERGER_EXECUTE };
 
     memstore::Leaf* previous_leaf = nullptr; // the last visited chunk
-    memstore::Key previous_key = memstore::KEY_MIN; // the min fence key for the previous chunk
+    memstore::Key previous_key = from; // the min fence key for the previous chunk
     uint64_t previous_size = 0; // the number of slots occupied in the previous chunk
-    memstore::Key current_key = memstore::KEY_MIN; // the min fence key for the current chunk
+    memstore::Key current_key = from; // the min fence key for the current chunk
     constexpr uint64_t MERGE_THRESHOLD = 0.75 * memstore::SparseFile::max_num_qwords() * context::StaticConfiguration::memstore_max_num_segments_per_leaf; // 75%
 
-    do {
+    while(current_key < to){
+        if(m_budget != nullptr && m_budget->exhausted()){ break; } // resume from current_key in the next pass
+
         context::ScopedEpoch epoch; // protect from the GC, before using #index_find()
         bool abort_on_previous = false; // discriminate whether the Abort{} raised originated from `previous_leaf' or `current_leaf'
 
         try {
             memstore::IndexEntry current_entry = m_context.m_tree->index()->find(current_key.source(), current_key.destination());
             memstore::Leaf* current_leaf = current_entry.leaf();
+            if(current_leaf->get_lfkey() < from){ // this leaf is visited by the operator of the preceding key range
+                current_key = current_leaf->get_hfkey();
+                continue;
+            }
+
             m_context.m_leaf = current_leaf;
             uint64_t current_size = visit_and_prune(); // it can Abort{} if `current' is not valid anymore
 
@@ -111,6 +146,11 @@ void MergeOperator::execute(){
                 }
             }
 
+            // compact mode, release the space not used by the current leaf
+            if(m_compact && is_sparse(current_leaf, current_size)){
+                std::tie(current_leaf, current_size) = shrink(current_leaf); // it can Abort{}
+            }
+
             // next iteration
             previous_leaf = current_leaf;
             previous_key = current_key;
@@ -121,15 +161,16 @@ void MergeOperator::execute(){
             if(abort_on_previous){ // reset previous
                 previous_leaf = nullptr;
                 previous_size = 0; // it doesn't matter, ease debug
-                previous_key = memstore::KEY_MIN; // it doesn't matter, ease debug
+                previous_key = from; // it doesn't matter, ease debug
             }
         }
 
         m_context.m_leaf = nullptr;
         m_context.m_segment = nullptr;
-    } while (current_key != memstore::KEY_MAX);
+    }
 
-    COUT_DEBUG("done");
+    COUT_DEBUG("stop: " << current_key);
+    return current_key;
 }
 
 uint64_t MergeOperator::visit_and_prune(){
@@ -138,8 +179,17 @@ uint64_t MergeOperator::visit_and_prune(){
     uint64_t cur_sz = 0; // number of slots in use in the chunk
     for(uint64_t segment_id = 0; segment_id < m_context.m_leaf->num_segments(); segment_id++){
         memstore::Segment* segment = m_context.m_leaf->get_segment(segment_id);
-        m_context.m_segment = segment;
-        cur_sz += memstore::Segment::prune(m_context);
+
+        if(segment->num_removals() == 0 && !segment->need_rebuild_vertex_table()){
+            // the segment did not shrink since the last pass, avoid touching its content
+            cur_sz += segment->used_space();
+        } else {
+            segment->reset_num_removals(); // before pruning, the removals performed in the meanwhile will be visited in the next pass
+            m_context.m_segment = segment;
+            uint64_t segment_sz = memstore::Segment::prune(m_context);
+            if(m_budget != nullptr){ m_budget->consume(segment_sz); }
+            cur_sz += segment_sz;
+        }
     }
 
     m_context.m_segment = nullptr;
@@ -150,10 +200,28 @@ std::pair</* last leaf */ memstore::Leaf*, /* space used */ uint64_t> MergeOpera
     profiler::ScopedTimer profiler { profiler::MERGER_MERGE };
     COUT_DEBUG("leaf 1: " << previous << ", leaf 2: " << current);
     Plan plan = Plan::create_merge(cardinality, used_space, previous, current);
+    plan.set_compact(m_compact && previous->get_lfkey() != memstore::KEY_MIN); // the first leaf of the fat tree is never replaced
+    return spread(plan);
+}
+
+std::pair</* new leaf */ memstore::Leaf*, /* space used */ uint64_t> MergeOperator::shrink(memstore::Leaf* leaf) {
+    COUT_DEBUG("leaf: " << leaf);
+    memstore::Context context { m_context.m_tree };
+    context.m_leaf = leaf;
+    Crawler crawler { context };
+    crawler.lock2merge(); // it can raise an Abort
+    uint64_t used_space = crawler.used_space();
+    if(!is_sparse(leaf, used_space)){ return make_pair(leaf, used_space); } // filled in the meanwhile
+
+    crawler.set_lock_ownership(false); // transfer the locks to the spread operator
+    Plan plan = Plan::create_shrink(crawler.cardinality(), used_space, leaf);
+    return spread(plan);
+}
+
+std::pair</* last leaf */ memstore::Leaf*, /* space used */ uint64_t> MergeOperator::spread(Plan& plan) {
     SpreadOperator spread { m_context, *m_scratchpad, plan};
     spread();
 
-
     // Compute the amount of used space in the last leaf of the interval rebalanced
     // This operation is thread-safe because the spread operator still holds the locks to the leaves rebalanced
     memstore::Context context { m_context.m_tree };
@@ -167,6 +235,38 @@ std::pair</* last leaf */ memstore::Leaf*, /* space used */ uint64_t> MergeOpera
     return make_pair(last, filled_space);
 }
 
-} // namespace
+bool MergeOperator::is_sparse(const memstore::Leaf* leaf, uint64_t used_space){
+    if(leaf->get_lfkey() == memstore::KEY_MIN) return false; // the first leaf of the fat tree holds the min key of the index, it is never replaced
+    constexpr uint64_t MC = context::StaticConfiguration::memstore_max_num_segments_per_leaf;
+    const uint64_t num_segments = max<uint64_t>( ceil( static_cast<double>(used_space) / (0.75 * memstore::SparseFile::max_num_qwords()) ), MC /2 );
+    return num_segments + max<uint64_t>(leaf->num_segments() /4, 1) <= leaf->num_segments();
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   Pass                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+MergePass::MergePass(memstore::Memstore* memstore, vector<pair<memstore::Key, memstore::Key>>& ranges, MergeBudget* budget, bool compact) :
+        m_memstore(memstore), m_ranges(ranges), m_next(0), m_budget(budget), m_compact(compact) {
 
+}
+
+void MergePass::execute(){
+    MergeOperator merge_operator { memstore::Context{ m_memstore }, m_budget, m_compact };
+
+    uint64_t range_id;
+    while((range_id = m_next++) < m_ranges.size()){
+        if(m_budget != nullptr && m_budget->exhausted()) break; // leave the range to the next pass
+        auto& range = m_ranges[range_id];
+        range.first = merge_operator.execute(range.first, range.second);
+    }
+}
+
+uint64_t MergePass::num_ranges() const {
+    return m_ranges.size();
+}
+
+} // namespace
 
@@ -17,6 +17,7 @@
 
 #include "teseo/rebalance/merger_service.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <condition_variable>
 #include <event2/event.h>
@@ -24,13 +25,19 @@
 #include <mutex>
 
 #include "teseo/context/global_context.hpp"
+#include "teseo/context/scoped_epoch.hpp"
 #include "teseo/context/static_configuration.hpp"
 #include "teseo/memstore/context.hpp"
+#include "teseo/memstore/index.hpp"
+#include "teseo/memstore/leaf.hpp"
 #include "teseo/memstore/memstore.hpp"
+#include "teseo/memstore/vertex_table.hpp"
 #include "teseo/rebalance/merge_operator.hpp"
+#include "teseo/runtime/runtime.hpp"
 #include "teseo/util/chrono.hpp"
 #include "teseo/util/error.hpp"
 #include "teseo/util/libevent.hpp"
+#include "teseo/util/system.hpp"
 
 //#define DEBUG
 #include "teseo/util/debug.hpp"
@@ -46,6 +53,7 @@ static condition_variable g_condvar;
 struct MergerCallbackData {
     MergerService* m_instance; // pointer to the background service
     promise<void>* m_producer; // pointer to the producer/consumer queue, only used for synchronous invocations through #execute_now()
+    bool m_compact; // whether the synchronous invocation should also compact the sparse array
 };
 
 MergerService::MergerService(memstore::Memstore* owner) : m_queue(nullptr), m_eventloop_exec(false), m_memstore(owner){
@@ -81,6 +89,7 @@ void MergerService::start(){
     if(event == nullptr) throw std::bad_alloc{};
     event_payload->m_instance = this;
     event_payload->m_producer = nullptr;
+    event_payload->m_compact = false; // depends on the memory target, checked on each pass
     timer = util::duration2timeval(context::StaticConfiguration::merger_frequency);
     rc = event_add(event, &timer);
     if(rc != 0) {
@@ -113,6 +122,14 @@ void MergerService::stop(){
 }
 
 void MergerService::execute_now(){
+    execute_sync(/* compact ? */ false);
+}
+
+void MergerService::compact_now(){
+    execute_sync(/* compact ? */ true);
+}
+
+void MergerService::execute_sync(bool compact){
     // This method is not completely thread safe, because other threads may still stop the service while
     // the invoker of this method is still waiting for the request to be accomplished. But, anyway, this
     // method is supposed to be used only for debugging purposes.
@@ -131,11 +148,12 @@ void MergerService::execute_now(){
     if(event == nullptr) throw std::bad_alloc{};
     event_payload->m_instance = this;
     event_payload->m_producer = &producer;
+    event_payload->m_compact = compact;
     // int rc = event_add(event, nullptr); // nullptr -> execute immediately // it didn't work!
     auto timer = util::duration2timeval(0s);
     int rc = event_add(event, &timer);
     if(rc != 0) {
-        COUT_DEBUG_FORCE("FATAL: MergerService::execute_now, event_add failed");
+        COUT_DEBUG_FORCE("FATAL: MergerService::execute_sync, event_add failed");
         std::abort(); // not sure what we can do here
     }
 
@@ -158,11 +176,14 @@ void MergerService::callback_execute(int fd, short flags, void* /* MergerCallbac
     MergerCallbackData* callback_arg = reinterpret_cast<MergerCallbackData*>(raw_callback_arg);
 
     MergerService* instance = callback_arg->m_instance;
-    memstore::Memstore* memstore = instance->m_memstore;
 
-    memstore::Context context { memstore };
-    MergeOperator merge_operator { context };
-    merge_operator.execute();
+    if(callback_arg->m_producer == nullptr){ // periodic pass
+        MergeBudget budget { context::StaticConfiguration::merger_budget_time, context::StaticConfiguration::merger_budget_bytes };
+        instance->execute(&budget, instance->above_memory_target());
+    } else { // synchronous invocation, sweep the whole sparse array
+        instance->m_ranges.clear();
+        instance->execute(nullptr, callback_arg->m_compact);
+    }
 
     if(callback_arg->m_producer != nullptr){ // this is not the persistent event
         callback_arg->m_producer->set_value();
@@ -171,6 +192,62 @@ void MergerService::callback_execute(int fd, short flags, void* /* MergerCallbac
     }
 }
 
+void MergerService::execute(MergeBudget* budget, bool compact){
+    if(m_ranges.empty()){ // start a new sweep
+        m_ranges = partition();
+    }
+
+    MergePass pass { m_memstore, m_ranges, budget, compact };
+    m_memstore->global_context()->runtime()->merge_leaves(&pass);
+
+    // retain the ranges not completed for the next pass
+    m_ranges.erase(remove_if(begin(m_ranges), end(m_ranges), [](const pair<memstore::Key, memstore::Key>& range){
+        return range.first >= range.second;
+    }), end(m_ranges));
+
+    if(compact && m_ranges.empty()){ // the sweep is complete
+        // the leaves at the boundaries of the key ranges could not be merged by the workers, as they belong to different
+        // ranges. Stitch them together with a serial pass, cheap as the leaves have already been pruned
+        MergeOperator merge_operator { memstore::Context{ m_memstore }, /* budget */ nullptr, /* compact */ true };
+        merge_operator.execute(memstore::KEY_MIN, memstore::KEY_MAX);
+
+        // the merger is the only writer of the vertex table, it can be rehashed while the workers are not merging
+        m_memstore->vertex_table()->compact();
+
+        // the leaves replaced in the previous passes have been released by the GC in the meanwhile
+        util::System::release_memory();
+    }
+}
+
+bool MergerService::above_memory_target() const {
+    uint64_t target = m_memstore->global_context()->merger_memory_target();
+    return target > 0 && memstore::Leaf::memory_footprint() > target;
+}
+
+vector<pair<memstore::Key, memstore::Key>> MergerService::partition() const {
+    uint64_t max_vertex_id = 0; // approximate, the source of the low fence key of the last leaf
+    { // index_find() requires being inside an epoch
+        context::ScopedEpoch epoch;
+        max_vertex_id = m_memstore->index()->find(memstore::KEY_MAX.source(), memstore::KEY_MAX.destination()).leaf()->get_lfkey().source();
+    }
+
+    // split the vertex IDs evenly, the workers pick the ranges dynamically
+    const uint64_t num_workers = m_memstore->global_context()->runtime()->num_workers();
+    const uint64_t num_ranges = max<uint64_t>(1, min<uint64_t>(num_workers * context::StaticConfiguration::merger_ranges_per_worker, max_vertex_id));
+    vector<pair<memstore::Key, memstore::Key>> ranges;
+    memstore::Key from = memstore::KEY_MIN;
+    for(uint64_t i = 1; i < num_ranges; i++){
+        memstore::Key to { max_vertex_id / num_ranges * i };
+        if(from < to){
+            ranges.emplace_back(from, to);
+            from = to;
+        }
+    }
+    ranges.emplace_back(from, memstore::KEY_MAX);
+
+    return ranges;
+}
+
 void MergerService::main_thread(){
     COUT_DEBUG("Service thread started");
     util::Thread::set_name("Teseo.Merger");
@@ -40,7 +40,7 @@ namespace teseo::rebalance {
  *                                                                           *
  *****************************************************************************/
 
-Plan::Plan() : m_leaf1(nullptr), m_leaf2(nullptr), m_window_start(0), m_window_end(0), m_num_output_segments(0), m_is_resize(false), m_cardinality(0) {
+Plan::Plan() : m_leaf1(nullptr), m_leaf2(nullptr), m_window_start(0), m_window_end(0), m_num_output_segments(0), m_is_resize(false), m_is_append(false), m_is_compact(false), m_cardinality(0) {
 
 }
 
@@ -49,6 +49,23 @@ Plan Plan::create_split(uint64_t cardinality, uint64_t used_space, memstore::Lea
     return create_resize(cardinality, used_space, leaf, nullptr);
 }
 
+Plan Plan::create_append(uint64_t cardinality, uint64_t used_space, memstore::Leaf* leaf){
+    Plan plan = create_resize(cardinality, used_space, leaf, nullptr);
+    plan.m_is_resize = true; // always create the new leaf, even if the elements could still be spread in the existing one
+    plan.m_is_append = true;
+
+    COUT_DEBUG("plan: " << plan);
+    return plan;
+}
+
+Plan Plan::create_shrink(uint64_t cardinality, uint64_t used_space, memstore::Leaf* leaf){
+    Plan plan = create_resize(cardinality, used_space, leaf, nullptr);
+    plan.m_is_compact = true;
+
+    COUT_DEBUG("plan: " << plan);
+    return plan;
+}
+
 Plan Plan::create_spread(uint64_t cardinality, memstore::Leaf* leaf, uint64_t window_start, uint64_t window_end){
     assert(window_start < window_end);
 
@@ -107,6 +124,14 @@ bool Plan::is_merge() const {
     return m_leaf2 != nullptr;
 }
 
+bool Plan::is_append() const {
+    return m_is_append;
+}
+
+bool Plan::is_compact() const {
+    return m_is_compact;
+}
+
 uint64_t Plan::window_start() const {
     return m_window_start;
 }
@@ -131,6 +156,14 @@ void Plan::set_resize(bool value){
     m_is_resize = value;
 }
 
+void Plan::set_append(bool value){
+    m_is_append = value;
+}
+
+void Plan::set_compact(bool value){
+    m_is_compact = value;
+}
+
 uint64_t Plan::cardinality() const {
     return m_cardinality;
 }
@@ -171,6 +204,10 @@ string Plan::to_string() const{
     } else {
         if(is_rebalance()){
             ss << "rebalance leaf: " << leaf() << ", segments: [" << window_start() << ", " << window_end() << ")";
+        } else if (is_append()){
+            ss << "append split leaf: " << leaf() << ", fill the existing leaf and move the rest into a new leaf";
+        } else if (is_compact()){
+            ss << "shrink leaf: " << leaf() << " into a new leaf of " << num_output_segments() << " segments";
         } else if (num_output_segments() <= teseo::context::StaticConfiguration::memstore_max_num_segments_per_leaf) {
             ss << "resize leaf: " << leaf() << " into a new leaf of " << num_output_segments() << " segments";
         } else {
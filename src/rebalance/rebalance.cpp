@@ -18,8 +18,12 @@
 #include "teseo/rebalance/rebalance.hpp"
 
 #include "teseo/context/scoped_epoch.hpp"
+#include "teseo/context/thread_context.hpp"
 #include "teseo/memstore/context.hpp"
+#include "teseo/memstore/index.hpp"
 #include "teseo/memstore/key.hpp"
+#include "teseo/memstore/leaf.hpp"
+#include "teseo/memstore/memstore.hpp"
 #include "teseo/memstore/segment.hpp"
 #include "teseo/profiler/scoped_timer.hpp"
 #include "teseo/rebalance/crawler.hpp"
@@ -42,7 +46,7 @@ void handle_rebalance(memstore::Memstore* memstore, memstore::Key& key) {
         memstore::Context context { memstore };
         Crawler crawler { context, key };
         Plan plan = crawler.make_plan();
-        ScratchPad scratchpad { plan.cardinality_ub() };
+        ScratchPad& scratchpad = context::thread_context()->scratchpad(); // reuse the buffers of the previous rebalances
         SpreadOperator rebalance { context, scratchpad, plan };
         rebalance();
     } catch (Abort) {
@@ -52,4 +56,24 @@ void handle_rebalance(memstore::Memstore* memstore, memstore::Key& key) {
     }
 }
 
+void handle_prune(memstore::Memstore* memstore, memstore::Key& key) {
+    profiler::ScopedTimer profiler { profiler::ARS_HANDLE_PRUNE };
+    COUT_DEBUG("Key: " << key);
+    context::ScopedEpoch epoch; // protect from the GC
+
+    try {
+        memstore::Context context { memstore };
+        memstore::IndexEntry entry = memstore->index()->find(key.source(), key.destination());
+        context.m_leaf = entry.leaf();
+        context.m_segment = context.m_leaf->get_segment(entry.segment_id());
+
+        // if the fence key changed, the segment has been rebalanced in the meanwhile and its versions already pruned
+        if(context.m_segment->m_fence_key == key){
+            memstore::Segment::prune(context);
+        }
+    } catch (Abort) {
+        /* nop */
+    }
+}
+
 } // namespace
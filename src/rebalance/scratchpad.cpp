@@ -16,10 +16,12 @@
  */
 #include "teseo/rebalance/scratchpad.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <sys/mman.h>
 
 #define DEBUG
 #include "teseo/util/debug.hpp"
@@ -34,26 +36,57 @@ ScratchPad::ScratchPad() : m_capacity(0), m_elements(nullptr), m_versions(nullpt
 
 ScratchPad::ScratchPad(uint64_t capacity) : m_capacity(capacity){
     m_last_vertex_loaded = numeric_limits<uint64_t>::max();
-    m_elements = (decltype(m_elements)) malloc(capacity * sizeof(m_elements[0]));
-    m_versions = (decltype(m_versions)) malloc(capacity * sizeof(m_versions[0]));
+    m_elements = (decltype(m_elements)) allocate(capacity * sizeof(m_elements[0]));
+    m_versions = (decltype(m_versions)) allocate(capacity * sizeof(m_versions[0]));
     if(m_elements == nullptr || m_versions == nullptr){
         COUT_DEBUG_FORCE("bad alloc at " << __FILE__ << ":" << __LINE__ << ", capacity: " << capacity << ", m_elements: " << m_elements << ", m_versions: " << m_versions);
+        deallocate(m_elements, capacity * sizeof(m_elements[0]));
+        deallocate(m_versions, capacity * sizeof(m_versions[0]));
         throw std::bad_alloc{};
     }
 }
 
 ScratchPad::ScratchPad(const ScratchPad& cp) {
     m_size = m_capacity = cp.m_size;
-    m_elements = (decltype(m_elements)) malloc(m_capacity * sizeof(m_elements[0]));
-    m_versions = (decltype(m_versions)) malloc(m_capacity * sizeof(m_versions[0]));
+    m_elements = (decltype(m_elements)) allocate(m_capacity * sizeof(m_elements[0]));
+    m_versions = (decltype(m_versions)) allocate(m_capacity * sizeof(m_versions[0]));
     memcpy(m_elements, cp.m_elements, m_size * sizeof(m_elements[0]));
     memcpy(m_versions, cp.m_versions, m_size * sizeof(m_versions[0]));
     m_last_vertex_loaded = cp.m_last_vertex_loaded;
 }
 
 ScratchPad::~ScratchPad(){
-    free(m_elements); m_elements = nullptr;
-    free(m_versions); m_versions = nullptr;
+    deallocate(m_elements, m_capacity * sizeof(m_elements[0])); m_elements = nullptr;
+    deallocate(m_versions, m_capacity * sizeof(m_versions[0])); m_versions = nullptr;
+}
+
+/**
+ * Buffers larger than this threshold are mapped directly from the OS and backed by transparent huge pages, to
+ * reduce the number of page faults and TLB misses when they are first filled. Being filled by the thread that
+ * allocated them, their pages are placed in the NUMA node of that thread.
+ */
+constexpr static uint64_t HUGEPAGE_THRESHOLD = 2ull << 20; // 2 MB
+
+void* ScratchPad::allocate(uint64_t size){
+    if(size < HUGEPAGE_THRESHOLD){
+        return malloc(size);
+    } else {
+        void* buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(buffer == MAP_FAILED) return nullptr;
+#if defined(MADV_HUGEPAGE)
+        madvise(buffer, size, MADV_HUGEPAGE); // just a hint, ignore failures
+#endif
+        return buffer;
+    }
+}
+
+void ScratchPad::deallocate(void* buffer, uint64_t size){
+    if(buffer == nullptr) return;
+    if(size < HUGEPAGE_THRESHOLD){
+        free(buffer);
+    } else {
+        munmap(buffer, size);
+    }
 }
 
 uint64_t ScratchPad::capacity() const {
@@ -67,18 +100,23 @@ uint64_t ScratchPad::size() const {
 void ScratchPad::ensure_capacity(uint64_t capacity_new) {
     if(m_capacity >= capacity_new) return; /* nop */
 
-    auto elements_new = (decltype(m_elements)) malloc(capacity_new * sizeof(m_elements[0]));
-    auto versions_new = (decltype(m_versions)) malloc(capacity_new * sizeof(m_versions[0]));
+    // the scratchpads of the thread contexts are reused among the rebalances, grow them geometrically
+    capacity_new = max<uint64_t>(capacity_new, m_capacity + m_capacity /2);
+
+    auto elements_new = (decltype(m_elements)) allocate(capacity_new * sizeof(m_elements[0]));
+    auto versions_new = (decltype(m_versions)) allocate(capacity_new * sizeof(m_versions[0]));
     if(elements_new == nullptr || versions_new == nullptr){
         COUT_DEBUG_FORCE("bad alloc at " << __FILE__ << ":" << __LINE__ << ", capacity: " << capacity_new << ", elements_new: " << elements_new << ", versions_new: " << versions_new);
+        deallocate(elements_new, capacity_new * sizeof(m_elements[0]));
+        deallocate(versions_new, capacity_new * sizeof(m_versions[0]));
         throw std::bad_alloc{};
     }
 
     memcpy(elements_new, m_elements, m_size * sizeof(m_elements[0]));
     memcpy(versions_new, m_versions, m_size * sizeof(m_versions[0]));
 
-    free(m_elements);
-    free(m_versions);
+    deallocate(m_elements, m_capacity * sizeof(m_elements[0]));
+    deallocate(m_versions, m_capacity * sizeof(m_versions[0]));
 
     m_elements = elements_new;
     m_versions = versions_new;
@@ -99,6 +137,23 @@ void ScratchPad::load_vertex(const memstore::Vertex* vertex, const memstore::Ver
     m_size ++;
 }
 
+void ScratchPad::load(const void* elements, uint64_t num_elements){
+    assert(m_size + num_elements <= m_capacity && "Overflow");
+
+    memcpy(m_elements + m_size, elements, num_elements * sizeof(m_elements[0]));
+    memset(reinterpret_cast<uint64_t*>(m_versions) + m_size, 0, num_elements * sizeof(m_versions[0])); // see #unset_version
+    m_last_vertex_loaded = numeric_limits<uint64_t>::max();
+    m_size += num_elements;
+}
+
+void ScratchPad::copy(uint64_t position, const ScratchPad& source, uint64_t start, uint64_t end){
+    assert(start <= end && end <= source.m_size && "Invalid range");
+    assert(position + (end - start) <= m_capacity && "Overflow");
+
+    memcpy(m_elements + position, source.m_elements + start, (end - start) * sizeof(m_elements[0]));
+    memcpy(m_versions + position, source.m_versions + start, (end - start) * sizeof(m_versions[0]));
+}
+
 void ScratchPad::unload_last_vertex(){
     assert(m_size > 0 && "Empty");
     assert(has_last_vertex() && "No last vertex registered");
@@ -170,6 +225,15 @@ bool ScratchPad::has_last_vertex() const{
     return m_last_vertex_loaded != numeric_limits<uint64_t>::max();
 }
 
+uint64_t ScratchPad::get_last_vertex_position() const {
+    return m_last_vertex_loaded;
+}
+
+void ScratchPad::set_last_vertex_position(uint64_t position) {
+    assert((position == numeric_limits<uint64_t>::max() || position < m_size) && "Invalid position");
+    m_last_vertex_loaded = position;
+}
+
 bool ScratchPad::has_version(uint64_t position) const {
     assert(position < m_capacity && "Invalid position");
     return reinterpret_cast<uint64_t*>(m_versions)[position] != 0;
@@ -19,11 +19,15 @@
 
 #include <cassert>
 #include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/static_configuration.hpp"
 #include "teseo/memstore/context.hpp"
+#include "teseo/memstore/dense_file.hpp"
 #include "teseo/memstore/key.hpp"
 #include "teseo/memstore/index.hpp"
 #include "teseo/memstore/index_entry.hpp"
@@ -34,6 +38,7 @@
 #include "teseo/memstore/vertex_table.hpp"
 #include "teseo/rebalance/plan.hpp"
 #include "teseo/rebalance/scratchpad.hpp"
+#include "teseo/runtime/runtime.hpp"
 
 //#define DEBUG
 #include "teseo/util/debug.hpp"
@@ -99,6 +104,32 @@ namespace teseo::rebalance {
 #define DEBUG_SAVE( stuff ) stuff
 #endif
 
+/*****************************************************************************
+ *                                                                           *
+ *  SpreadJob                                                                *
+ *                                                                           *
+ *****************************************************************************/
+
+SpreadJob::SpreadJob(uint64_t num_items, function<void(uint64_t)> callback) : m_num_items(num_items), m_callback(callback), m_next(0), m_num_done(0) {
+
+}
+
+void SpreadJob::execute(){
+    uint64_t item = m_next++;
+    while(item < m_num_items){
+        m_callback(item);
+        m_num_done++;
+
+        item = m_next++; // next iteration
+    }
+}
+
+void SpreadJob::wait(){
+    while(m_num_done < m_num_items){ // only the items already claimed by the workers are left
+        this_thread::yield();
+    }
+}
+
 /*****************************************************************************
  *                                                                           *
  *  Interface                                                                *
@@ -157,7 +188,7 @@ void SpreadOperator::load(){
     m_scratchpad.ensure_capacity(m_plan.cardinality_ub());
 
     memstore::Leaf* leaf = m_plan.first_leaf();
-    load(leaf); // load the elements in the first leaf
+    load(leaf); // register the window of the first leaf
 
     while(leaf != m_plan.last_leaf()){
         assert(m_plan.is_merge() && "Only merge plans (currently) contain more than one leaf");
@@ -175,6 +206,17 @@ void SpreadOperator::load(){
         m_rebalanced_leaves.back().set_removed();
     }
 
+    uint64_t window_length = 0;
+    for(auto& item : m_rebalanced_leaves){ window_length += item.window_end() - item.window_start(); }
+
+    if(window_length >= context::StaticConfiguration::rebalance_parallel_threshold){
+        load_parallel();
+    } else {
+        for(auto& item : m_rebalanced_leaves){
+            load(item.leaf(), item.window_start(), item.window_end());
+        }
+    }
+
     DEBUG_LOAD( validate_load() );
 }
 
@@ -190,7 +232,6 @@ void SpreadOperator::load(memstore::Leaf* leaf){
         window_end = leaf->num_segments();
     }
 
-    load(leaf, window_start, window_end);
     m_rebalanced_leaves.emplace_back(leaf, window_start, window_end);
     m_rebalanced_leaves.back().set_existent();
 }
@@ -209,6 +250,88 @@ void SpreadOperator::load(memstore::Leaf* leaf, uint64_t window_start, uint64_t
     m_context.m_leaf = nullptr;
 }
 
+// Segment#load() checks the segment is owned by the calling thread, which is not the case for the runtime workers assisting the rebalancer
+static void load_segment(memstore::Context& context, ScratchPad& scratchpad){
+    if(context.m_segment->is_sparse()){
+        context.sparse_file()->load(context, scratchpad);
+    } else {
+        assert(context.m_segment->is_dense());
+        context.dense_file()->load(context, scratchpad);
+    }
+}
+
+void SpreadOperator::load_parallel(){
+    using namespace memstore;
+    constexpr uint64_t batch_size = context::StaticConfiguration::rebalance_parallel_batch;
+
+    // split the windows of the leaves into batches of consecutive segments
+    struct Batch { Leaf* m_leaf; uint64_t m_window_start; uint64_t m_window_end; };
+    vector<Batch> batches;
+    for(auto& item : m_rebalanced_leaves){
+        for(uint64_t start = item.window_start(); start < item.window_end(); start += batch_size){
+            batches.push_back(Batch{ item.leaf(), start, min(start + batch_size, item.window_end()) });
+        }
+    }
+
+    // load each batch in its own scratchpad
+    vector<ScratchPad> scratchpads ( batches.size() );
+    execute(batches.size(), [&](uint64_t i){
+        const Batch& batch = batches[i];
+        ScratchPad& scratchpad = scratchpads[i];
+        Context context = m_context;
+        context.m_leaf = batch.m_leaf;
+
+        uint64_t cardinality = 0;
+        for(uint64_t segment_id = batch.m_window_start; segment_id < batch.m_window_end; segment_id++){
+            context.m_segment = batch.m_leaf->get_segment(segment_id);
+            cardinality += Segment::cardinality(context);
+        }
+        scratchpad.ensure_capacity(cardinality +1); // +1 for a dummy vertex at the start of the batch
+
+        for(uint64_t segment_id = batch.m_window_start; segment_id < batch.m_window_end; segment_id++){
+            context.m_segment = batch.m_leaf->get_segment(segment_id);
+            if(Segment::is_unindexed(context)) continue; // empty & unindexed, ignore it
+            load_segment(context, scratchpad);
+        }
+    });
+
+    // compute where each batch is copied in the scratchpad. As in the serial load, a batch starting with a dummy
+    // vertex has its edges attached to the last vertex of the previous batches
+    vector<uint64_t> positions ( batches.size() ); // the position of each batch in the scratchpad
+    vector<uint64_t> first ( batches.size() ); // the first element to copy from each batch, 1 if it starts with a dummy vertex
+    vector<pair<uint64_t, uint64_t>> num_edges; // the edges to attach to the vertices of the previous batches, as <position, count>
+    uint64_t size = m_scratchpad.size();
+    uint64_t last_vertex = numeric_limits<uint64_t>::max();
+    for(uint64_t i = 0; i < batches.size(); i++){
+        const ScratchPad& scratchpad = scratchpads[i];
+        positions[i] = size;
+        first[i] = 0;
+        if(scratchpad.size() == 0) continue;
+
+        const Vertex* vertex = scratchpad.get_vertex(0);
+        if(vertex->m_first == 0 && last_vertex != numeric_limits<uint64_t>::max()){
+            num_edges.emplace_back(last_vertex, vertex->m_count);
+            first[i] = 1;
+        }
+        if(scratchpad.get_last_vertex_position() >= first[i]){
+            last_vertex = size + scratchpad.get_last_vertex_position() - first[i];
+        }
+
+        size += scratchpad.size() - first[i];
+    }
+    assert(size <= m_scratchpad.capacity() && "Overflow");
+
+    // concatenate the batches
+    execute(batches.size(), [&](uint64_t i){
+        m_scratchpad.copy(positions[i], scratchpads[i], first[i], scratchpads[i].size());
+    });
+    m_scratchpad.set_size(size);
+    for(auto& item : num_edges){
+        m_scratchpad.get_vertex(item.first)->m_count += item.second;
+    }
+    m_scratchpad.set_last_vertex_position(last_vertex);
+}
+
 /*****************************************************************************
  *                                                                           *
  *  Prune                                                                    *
@@ -317,9 +440,30 @@ void SpreadOperator::tune_plan(){
         double extra_space_required = m_space_required * (1.0 + static_cast<double>(OFFSET_VERTEX + OFFSET_VERSION + OFFSET_EDGE) / SparseFile::max_num_qwords());
         uint64_t num_segments = ceil( extra_space_required / (0.75 * SparseFile::max_num_qwords()) );
 
-        if(num_segments <= m_plan.num_output_segments()){
+        if(m_plan.is_append()){
+            const uint64_t num_segments_leaf = m_plan.first_leaf()->num_segments();
+            const int64_t num_segments_tail = append_layout().second;
+
+            if(num_segments <= num_segments_leaf /2){ // the pruning released most of the space in the leaf, spread its elements
+                m_plan.set_resize(false);
+                m_plan.set_append(false);
+                m_plan.set_num_output_segments(num_segments);
+                m_profiler.set_window_length(num_segments);
+            } else if(num_segments_tail <= static_cast<int64_t>(context::StaticConfiguration::memstore_max_num_segments_per_leaf)){
+                m_plan.set_num_output_segments(num_segments_leaf + num_segments_tail);
+                m_profiler.set_window_length(num_segments_leaf + num_segments_tail);
+            } else { // the elements do not fit in two leaves, e.g. due to the dense files, resort to a regular split
+                m_plan.set_append(false);
+            }
+        }
+
+        if(m_plan.is_compact()){ // every leaf must contain at least MC/2 segments
+            num_segments = max<uint64_t>(num_segments, context::StaticConfiguration::memstore_max_num_segments_per_leaf /2);
+        }
+
+        if(!m_plan.is_append() && num_segments <= m_plan.num_output_segments()){
             // can we store all segments in the first leaf of the sequence -> transform it to a rebalance
-            if(num_segments <= m_plan.first_leaf()->num_segments()){ // m_plan.is_resize() would be redundant here
+            if(num_segments == m_plan.first_leaf()->num_segments() || (!m_plan.is_compact() && num_segments < m_plan.first_leaf()->num_segments())){ // m_plan.is_resize() would be redundant here
                 m_plan.set_resize(false);
             }
             assert((!m_plan.is_resize() || num_segments >= context::StaticConfiguration::memstore_max_num_segments_per_leaf /2) &&
@@ -353,8 +497,14 @@ void SpreadOperator::save(){
     int64_t pos_vertex = 0;
     int64_t pos_element = 0;
 
+    // with large windows, the segments are only assigned their portion of the scratchpad here, and filled later in parallel
+    vector<SaveItem> items;
+    vector<SaveItem>* deferred = m_plan.num_output_segments() >= context::StaticConfiguration::rebalance_parallel_threshold ? &items : nullptr;
+
     if(!m_plan.is_resize()){
-        save(m_plan.leaf(), m_plan.window_start(), m_plan.window_end(), m_plan.num_output_segments(), num_segments_saved, budget_achieved, pos_vertex, pos_element);
+        save(m_plan.leaf(), m_plan.window_start(), m_plan.window_end(), m_plan.num_output_segments(), num_segments_saved, budget_achieved, pos_vertex, pos_element, deferred);
+    } else if(m_plan.is_append()){
+        save_append(budget_achieved, pos_vertex, pos_element, deferred);
     } else { // Resize it into one or multiple leaves
         assert(m_plan.is_resize());
 
@@ -376,26 +526,28 @@ void SpreadOperator::save(){
             assert(num_segments <= MC && "No leaf can have more than MC segment");
 
             memstore::Leaf* leaf = nullptr;
-            if(is_first_leaf && ((uint64_t) num_segments <= m_plan.first_leaf()->num_segments())){ // special case, don't recreate the first leaf
+            const uint64_t num_segments_first_leaf = m_plan.first_leaf()->num_segments();
+            if(is_first_leaf && ((uint64_t) num_segments == num_segments_first_leaf || (!m_plan.is_compact() && (uint64_t) num_segments < num_segments_first_leaf))){ // special case, don't recreate the first leaf
                 leaf = m_plan.first_leaf();
             } else {
                 if(is_first_leaf){ m_rebalanced_leaves[0].set_removed(); } // explicitly delete the first leaf of the plan
                 leaf = create_leaf(num_segments);
             }
 
-            save(leaf, 0, leaf->num_segments(), num_segments, num_segments_saved, budget_achieved, pos_vertex, pos_element);
+            save(leaf, 0, leaf->num_segments(), num_segments, num_segments_saved, budget_achieved, pos_vertex, pos_element, deferred);
 
             is_first_leaf = false; // next iteration
         }
     }
     assert(m_space_required == budget_achieved && "We didn't copy all data from the buffer");
+    if(deferred != nullptr){ save_parallel(items); }
 
     update_fence_keys();
     DEBUG_LEAF_TRAVERSALS( validate_leaf_traversals() );
     DEBUG_SAVE( validate_save() );
 }
 
-void SpreadOperator::save(memstore::Leaf* leaf, int64_t window_start, int64_t window_end, uint64_t num_filled_segments, uint64_t& num_segments_saved, uint64_t& budget_achieved, int64_t& pos_vertex, int64_t& pos_element){
+void SpreadOperator::save(memstore::Leaf* leaf, int64_t window_start, int64_t window_end, uint64_t num_filled_segments, uint64_t& num_segments_saved, uint64_t& budget_achieved, int64_t& pos_vertex, int64_t& pos_element, vector<SaveItem>* deferred){
     assert(window_start >= 0 && "Invalid initial segment");
     assert(window_start < window_end && "be sure the caller provides window_end and not window_length as argument");
     assert(num_filled_segments <= (uint64_t) (window_end - window_start) && "number of segments to fill larger than the available window");
@@ -407,9 +559,6 @@ void SpreadOperator::save(memstore::Leaf* leaf, int64_t window_start, int64_t wi
     double empty_balance = 0;
 
     for(int64_t segment_id = window_start; segment_id < window_end; segment_id ++) {
-        memstore::Segment* segment = leaf->get_segment(segment_id);
-        m_context.m_segment = segment;
-
         int64_t target_budget = 0;
         if(empty_balance >= 1.0 || /* due to rounding issues */ num_filled_segments == 0){ // make the segment empty
             // target_budget = 0
@@ -422,17 +571,109 @@ void SpreadOperator::save(memstore::Leaf* leaf, int64_t window_start, int64_t wi
             num_segments_saved++;
         }
 
-        int64_t in_budget_achieved = 0;
+        budget_achieved += save(leaf, leaf->get_segment(segment_id), target_budget, pos_vertex, pos_element, deferred);
+    }
 
-        segment->save(m_context, m_scratchpad, pos_vertex, pos_element, target_budget, &in_budget_achieved);
+    m_context.m_leaf = nullptr;
+    m_context.m_segment = nullptr;
+}
+
+int64_t SpreadOperator::save(memstore::Leaf* leaf, memstore::Segment* segment, int64_t target_budget, int64_t& pos_vertex, int64_t& pos_element, vector<SaveItem>* deferred){
+    m_context.m_leaf = leaf;
+    m_context.m_segment = segment;
+    int64_t budget_achieved = 0;
+
+    if(deferred == nullptr){
+        segment->save(m_context, m_scratchpad, pos_vertex, pos_element, target_budget, &budget_achieved);
+    } else { // only compute where the next segment starts, the segment is filled by #save_parallel()
+        deferred->push_back(SaveItem{ leaf, segment, pos_vertex, pos_element, target_budget, 0 });
+        memstore::SparseFile::save_dry_run(m_context, m_scratchpad, pos_vertex, pos_element, target_budget, &budget_achieved);
+        deferred->back().m_budget_achieved = budget_achieved;
+    }
+
+    return budget_achieved;
+}
+
+void SpreadOperator::save_append(uint64_t& budget_achieved, int64_t& pos_vertex, int64_t& pos_element, vector<SaveItem>* deferred){
+    constexpr int64_t MC = context::StaticConfiguration::memstore_max_num_segments_per_leaf;
+    int64_t budget_leaf = 0; // the space to store in the existing leaf
+    int64_t num_segments_tail = 0; // the number of segments to fill in the new leaf
+    std::tie(budget_leaf, num_segments_tail) = append_layout();
+    assert(num_segments_tail >= 1 && num_segments_tail <= MC);
+
+    // fill all segments of the existing leaf
+    memstore::Leaf* leaf = m_plan.first_leaf();
+    for(int64_t segment_id = 0, num_segments = leaf->num_segments(); segment_id < num_segments; segment_id++){
+        int64_t target_budget = max<int64_t>(0, budget_leaf - static_cast<int64_t>(budget_achieved)) / (num_segments - segment_id);
+        budget_achieved += save(leaf, leaf->get_segment(segment_id), target_budget, pos_vertex, pos_element, deferred);
+    }
+    assert(budget_achieved < m_space_required && "The new leaf cannot be empty");
 
-        budget_achieved += in_budget_achieved;
+    // the rest goes to the first segments of the new leaf, the following segments are left empty for the next appends
+    leaf = create_leaf(MC);
+    for(int64_t segment_id = 0; segment_id < MC; segment_id++){
+        int64_t target_budget = 0;
+        if(segment_id < num_segments_tail){
+            target_budget = (m_space_required - budget_achieved) / (num_segments_tail - segment_id);
+        }
+        budget_achieved += save(leaf, leaf->get_segment(segment_id), target_budget, pos_vertex, pos_element, deferred);
     }
 
     m_context.m_leaf = nullptr;
     m_context.m_segment = nullptr;
 }
 
+pair<int64_t, int64_t> SpreadOperator::append_layout() const {
+    using namespace memstore;
+    const int64_t space_per_segment = SparseFile::max_num_qwords();
+
+    // A segment is filled up to the brim, but for the elements a save can write past its target budget: the vertex
+    // with the first edge of the rhs, and the dummy vertex in the lhs.
+    const int64_t budget_per_segment = space_per_segment - 2 * (OFFSET_VERTEX + OFFSET_VERSION + OFFSET_EDGE);
+
+    // Always leave some elements for the new leaf, so that its first segment is not empty and it can be indexed
+    const int64_t budget_tail_min = min<int64_t>(m_space_required /2, space_per_segment /2);
+    const int64_t budget_leaf = min<int64_t>(m_plan.first_leaf()->num_segments() * budget_per_segment, m_space_required - budget_tail_min);
+
+    // Same density as a regular split for the segments filled in the new leaf
+    const double budget_tail = (m_space_required - budget_leaf) * (1.0 + static_cast<double>(OFFSET_VERTEX + OFFSET_VERSION + OFFSET_EDGE) / space_per_segment);
+    const int64_t num_segments_tail = max<int64_t>(1, ceil( budget_tail / (0.75 * space_per_segment) ));
+
+    return make_pair(budget_leaf, num_segments_tail);
+}
+
+void SpreadOperator::save_parallel(const vector<SaveItem>& items){
+    constexpr uint64_t batch_size = context::StaticConfiguration::rebalance_parallel_batch;
+
+    execute((items.size() + batch_size -1) / batch_size, [&](uint64_t i){
+        memstore::Context context = m_context;
+
+        for(uint64_t j = i * batch_size, end = min<uint64_t>(items.size(), (i +1) * batch_size); j < end; j++){
+            const SaveItem& item = items[j];
+            context.m_leaf = item.m_leaf;
+            context.m_segment = item.m_segment;
+            int64_t pos_vertex = item.m_pos_vertex;
+            int64_t pos_element = item.m_pos_element;
+            int64_t budget_achieved = 0;
+
+            item.m_segment->save(context, m_scratchpad, pos_vertex, pos_element, item.m_target_budget, &budget_achieved);
+            assert(budget_achieved == item.m_budget_achieved && "Mismatch with the dry run");
+        }
+    });
+}
+
+void SpreadOperator::execute(uint64_t num_items, function<void(uint64_t)> callback){
+    auto job = make_shared<SpreadJob>(num_items, callback);
+
+    runtime::Runtime* runtime = m_context.m_tree->global_context()->runtime();
+    if(num_items > 1 && runtime != nullptr){
+        runtime->spread_job(job, min<uint64_t>(runtime->num_workers(), num_items -1));
+    }
+
+    job->execute();
+    job->wait();
+}
+
 void SpreadOperator::update_fence_keys(){
     memstore::Index* index = m_context.m_tree->index();
 
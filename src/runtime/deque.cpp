@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "teseo/runtime/deque.hpp"
+
+#include <cassert>
+
+//#define DEBUG
+#include "teseo/util/debug.hpp"
+
+using namespace std;
+
+namespace teseo::runtime {
+
+/*****************************************************************************
+ *                                                                           *
+ *   Array                                                                   *
+ *                                                                           *
+ *****************************************************************************/
+
+Deque::Array::Array(int64_t capacity) : m_capacity(capacity), m_tasks(new atomic<Task>[capacity]) {
+    assert(capacity > 0 && (capacity & (capacity -1)) == 0 && "The capacity must be a power of 2");
+}
+
+Deque::Array::~Array(){
+    delete[] m_tasks; m_tasks = nullptr;
+}
+
+Task Deque::Array::get(int64_t index) const {
+    return m_tasks[index & (m_capacity -1)].load(memory_order_relaxed);
+}
+
+void Deque::Array::put(int64_t index, Task task){
+    m_tasks[index & (m_capacity -1)].store(task, memory_order_relaxed);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   Deque                                                                   *
+ *                                                                           *
+ *****************************************************************************/
+
+Deque::Deque(uint64_t capacity) : m_top(0), m_bottom(0), m_array(nullptr) {
+    uint64_t actual_capacity = 1;
+    while(actual_capacity < capacity){ actual_capacity *= 2; }
+    m_array = new Array(actual_capacity);
+}
+
+Deque::~Deque(){
+    delete m_array.load(); m_array = nullptr;
+    for(auto array : m_retired){ delete array; }
+    m_retired.clear();
+}
+
+Deque::Array* Deque::resize(Array* array, int64_t top, int64_t bottom){
+    Array* new_array = new Array(array->m_capacity * 2);
+    for(int64_t i = top; i < bottom; i++){
+        new_array->put(i, array->get(i));
+    }
+    m_retired.push_back(array); // a thief may be still reading the old array
+    m_array.store(new_array, memory_order_release);
+    COUT_DEBUG("new capacity: " << new_array->m_capacity);
+    return new_array;
+}
+
+void Deque::push(Task task){
+    int64_t bottom = m_bottom.load(memory_order_relaxed);
+    int64_t top = m_top.load(memory_order_acquire);
+    Array* array = m_array.load(memory_order_relaxed);
+    if(bottom - top > array->m_capacity -1){ // full
+        array = resize(array, top, bottom);
+    }
+    array->put(bottom, task);
+    atomic_thread_fence(memory_order_release);
+    m_bottom.store(bottom +1, memory_order_relaxed);
+}
+
+bool Deque::take(Task* out_task){
+    assert(out_task != nullptr);
+    int64_t bottom = m_bottom.load(memory_order_relaxed) -1;
+    Array* array = m_array.load(memory_order_relaxed);
+    m_bottom.store(bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = m_top.load(memory_order_relaxed);
+
+    bool result = true;
+    if(top <= bottom){ // not empty
+        *out_task = array->get(bottom);
+        if(top == bottom){ // last task, race with the thieves
+            if(!m_top.compare_exchange_strong(top, top +1, memory_order_seq_cst, memory_order_relaxed)){
+                result = false; // lost the race
+            }
+            m_bottom.store(bottom +1, memory_order_relaxed);
+        }
+    } else { // empty
+        result = false;
+        m_bottom.store(bottom +1, memory_order_relaxed);
+    }
+
+    return result;
+}
+
+bool Deque::steal(Task* out_task){
+    assert(out_task != nullptr);
+    int64_t top = m_top.load(memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t bottom = m_bottom.load(memory_order_acquire);
+    if(top >= bottom) return false; // empty
+
+    Array* array = m_array.load(memory_order_acquire);
+    Task task = array->get(top);
+    if(!m_top.compare_exchange_strong(top, top +1, memory_order_seq_cst, memory_order_relaxed)){
+        return false; // lost the race with the owner or another thief
+    }
+
+    *out_task = task;
+    return true;
+}
+
+uint64_t Deque::size() const {
+    int64_t bottom = m_bottom.load(memory_order_relaxed);
+    int64_t top = m_top.load(memory_order_relaxed);
+    return bottom > top ? bottom - top : 0;
+}
+
+bool Deque::empty() const {
+    return size() == 0;
+}
+
+} // namespace
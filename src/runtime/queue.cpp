@@ -17,14 +17,18 @@
 
 #include "teseo/runtime/queue.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <future>
 #include <memory>
 #include <random>
+#include <thread>
 
 #include "teseo/context/global_context.hpp"
+#include "teseo/runtime/runtime.hpp"
 #include "teseo/runtime/worker.hpp"
 #include "teseo/util/cpu_topology.hpp"
+#include "teseo/util/thread.hpp"
 
 #include "teseo/util/debug.hpp"
 
@@ -34,17 +38,65 @@ namespace teseo::runtime {
 
 static int init_setting_num_threads(); // forward decl.
 
-Queue::Queue(runtime::Runtime* runtime) : m_num_workers(init_setting_num_threads()), m_workers( new WState[m_num_workers] ), m_runtime(runtime) {
+Queue::Queue(runtime::Runtime* runtime) : m_num_workers(init_setting_num_threads()), m_workers( new WState[m_num_workers] ), m_num_parked(0), m_runtime(runtime) {
     COUT_DEBUG("num workers: " << m_num_workers);
 
+    init_topology();
     start_workers();
 }
 
 Queue::~Queue(){
     stop_workers();
+
+    // release the tasks left behind
+    for(int i = 0; i < num_workers(); i++){
+        auto& winfo = m_workers[i];
+        Task task;
+        while(winfo.m_deque.take(&task)){ Runtime::delete_task(task); }
+        while(pop_shared(winfo, &task)){ Runtime::delete_task(task); }
+        while(pop_pinned(winfo, &task)){ Runtime::delete_task(task); }
+    }
+
     delete[] m_workers; m_workers = nullptr;
 }
 
+void Queue::init_topology(){
+    constexpr int num_nodes = context::StaticConfiguration::numa_num_nodes;
+
+    if(context::StaticConfiguration::runtime_pin_workers){
+        // the physical cores where the process is allowed to run, excluding the SMT threads, interleaved among the NUMA nodes
+        auto topo = make_unique<util::cpu_topology>();
+        auto allowed = util::Thread::get_affinity();
+        vector<int> cpus;
+        for(int cpu_id : topo->get_threads(/* interleaved */ true, /* SMT ? */ false)){
+            if(find(begin(allowed), end(allowed), cpu_id) != end(allowed)){ cpus.push_back(cpu_id); }
+        }
+
+        for(int i = 0; i < num_workers() && !cpus.empty(); i++){
+            int cpu_id = cpus[i % cpus.size()];
+            int numa_node = context::StaticConfiguration::numa_enabled ? topo->get_node(cpu_id) : 0;
+            m_workers[i].m_cpu_id = cpu_id;
+            m_workers[i].m_numa_node = (numa_node >= 0 && numa_node < num_nodes) ? numa_node : 0;
+            COUT_DEBUG("worker #" << i << ", cpu: " << cpu_id << ", numa node: " << m_workers[i].m_numa_node);
+        }
+    }
+
+    m_node_workers.resize(num_nodes);
+    for(int i = 0; i < num_workers(); i++){
+        m_node_workers[m_workers[i].m_numa_node].push_back(i);
+    }
+    for(auto& workers : m_node_workers){
+        if(workers.empty()){ // no workers on this node, any worker will do
+            for(int i = 0; i < num_workers(); i++){ workers.push_back(i); }
+        }
+    }
+}
+
+const vector<int>& Queue::workers_on_node(int numa_node) const {
+    assert(numa_node >= 0 && numa_node < (int) m_node_workers.size() && "Invalid node");
+    return m_node_workers[numa_node];
+}
+
 void Queue::start_workers(){
     for(int i = 0; i < num_workers(); i++){
         m_workers[i].m_worker = new Worker(this, i);
@@ -63,13 +115,53 @@ runtime::Runtime* Queue::runtime() {
     return m_runtime;
 }
 
+bool Queue::is_stealable(TaskType type) {
+    switch(type){
+    case TaskType::GC_RUN:
+    case TaskType::MEMSTORE_REBALANCE:
+    case TaskType::MEMSTORE_REBALANCE_SYNC:
+    case TaskType::MEMSTORE_PRUNE:
+    case TaskType::MEMSTORE_MERGE_LEAVES:
+    case TaskType::MEMSTORE_SPREAD_JOB:
+    case TaskType::AUX_PARTIAL_RESULT:
+    case TaskType::AUX_BUILD_HASHMAP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The queue & the worker id of the current thread, if it is a worker
+static thread_local Queue* g_worker_queue = nullptr;
+static thread_local int g_worker_id = -1;
+
 void Queue::submit(Task task, int worker_id){
     assert(worker_id < num_workers() && "Invalid worker id");
-    auto& winfo = m_workers[worker_id];
-    winfo.m_mutex.lock();
-    winfo.m_queue.append(task);
-    winfo.m_mutex.unlock();
-    winfo.m_condvar.notify_one();
+    const bool stealable = is_stealable(task.type());
+
+    if(stealable && g_worker_queue == this){ // the task has been spawned by one of our workers
+        m_workers[g_worker_id].m_deque.push(task);
+        atomic_thread_fence(memory_order_seq_cst); // pairs with the fence in #park
+        wake_any();
+    } else {
+        auto& winfo = m_workers[worker_id];
+        winfo.m_latch.lock();
+        if(stealable){
+            winfo.m_shared.append(task);
+            winfo.m_num_shared++;
+        } else {
+            winfo.m_pinned.append(task);
+            winfo.m_num_pinned++;
+        }
+        winfo.m_latch.unlock();
+        atomic_thread_fence(memory_order_seq_cst); // pairs with the fence in #park
+
+        if(winfo.m_parked){
+            wake(winfo);
+        } else if(stealable){
+            wake_any();
+        }
+    }
 }
 
 void Queue::submit_all(Task task){
@@ -78,20 +170,126 @@ void Queue::submit_all(Task task){
     }
 }
 
-Task Queue::fetch(int worker_id){
+Task Queue::fetch(int worker_id, bool can_steal){
     assert(worker_id < num_workers() && "Invalid worker id");
+    g_worker_queue = this;
+    g_worker_id = worker_id;
+    m_workers[worker_id].m_can_steal = can_steal;
+
+    Task task;
+    while(true){
+        for(uint64_t i = 0; i < context::StaticConfiguration::runtime_spin_iterations; i++){
+            if(try_fetch(worker_id, can_steal, &task)){
+                return task;
+            }
+            this_thread::yield();
+        }
+
+        park(worker_id, can_steal);
+    }
+}
 
+bool Queue::try_fetch(int worker_id, bool can_steal, Task* out_task){
+    auto& winfo = m_workers[worker_id];
+    return pop_pinned(winfo, out_task) || winfo.m_deque.take(out_task) || pop_shared(winfo, out_task) || (can_steal && steal(worker_id, out_task));
+}
+
+bool Queue::steal(int worker_id, Task* out_task){
+    const int numa_node = m_workers[worker_id].m_numa_node;
+    const int start = random_worker_id();
+    for(int pass = 0; pass < 2; pass++){ // first from the workers on the same NUMA node, then from the remote workers
+        for(int i = 0; i < num_workers(); i++){
+            int victim = (start + i) % num_workers();
+            auto& winfo = m_workers[victim];
+            if(victim == worker_id || (winfo.m_numa_node == numa_node) != (pass == 0)) continue;
+            if(winfo.m_deque.steal(out_task) || pop_shared(winfo, out_task)){
+                COUT_DEBUG("worker #" << worker_id << " stole " << *out_task << " from worker #" << victim);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Queue::pop_pinned(WState& winfo, Task* out_task){
+    if(winfo.m_num_pinned == 0) return false;
+    scoped_lock<util::SpinLock> lock(winfo.m_latch);
+    if(winfo.m_pinned.empty()) return false;
+
+    Task task = winfo.m_pinned[0];
+    // terminate only after the tasks already queued to this worker have been processed
+    if(task.type() == TaskType::TERMINATE && (!winfo.m_shared.empty() || !winfo.m_deque.empty())) return false;
+
+    winfo.m_pinned.pop();
+    winfo.m_num_pinned--;
+    *out_task = task;
+    return true;
+}
+
+bool Queue::pop_shared(WState& winfo, Task* out_task){
+    if(winfo.m_num_shared == 0) return false;
+    scoped_lock<util::SpinLock> lock(winfo.m_latch);
+    if(winfo.m_shared.empty()) return false;
+
+    *out_task = winfo.m_shared[0];
+    winfo.m_shared.pop();
+    winfo.m_num_shared--;
+    return true;
+}
+
+bool Queue::has_work(int worker_id, bool can_steal) const {
+    const auto& winfo = m_workers[worker_id];
+    if(winfo.m_num_pinned > 0 || winfo.m_num_shared > 0 || !winfo.m_deque.empty()) return true;
+    if(can_steal){
+        for(int i = 0; i < num_workers(); i++){
+            if(m_workers[i].m_num_shared > 0 || !m_workers[i].m_deque.empty()) return true;
+        }
+    }
+    return false;
+}
+
+void Queue::park(int worker_id, bool can_steal){
     auto& winfo = m_workers[worker_id];
-    auto& queue = winfo.m_queue;
     unique_lock<mutex> lock(winfo.m_mutex);
-    winfo.m_condvar.wait(lock, [&queue]{ return !queue.empty(); });
-    Task task = queue[0];
-    queue.pop();
-    return task;
+    winfo.m_parked = true;
+    m_num_parked++;
+    atomic_thread_fence(memory_order_seq_cst); // pairs with the fence in #submit
+
+    // check again, a task may have been submitted before the flag m_parked was set
+    if(!has_work(worker_id, can_steal)){
+        COUT_DEBUG("worker #" << worker_id << " parked");
+        winfo.m_condvar.wait(lock, [&winfo]{ return winfo.m_signalled; });
+    }
+
+    winfo.m_signalled = false;
+    winfo.m_parked = false;
+    m_num_parked--;
+}
+
+void Queue::wake(WState& winfo){
+    if(!winfo.m_parked) return;
+
+    winfo.m_mutex.lock();
+    winfo.m_signalled = true;
+    winfo.m_mutex.unlock();
+    winfo.m_condvar.notify_one();
+}
+
+void Queue::wake_any(){
+    if(m_num_parked == 0) return;
+
+    const int start = random_worker_id();
+    for(int i = 0; i < num_workers(); i++){
+        auto& winfo = m_workers[(start + i) % num_workers()];
+        if(winfo.m_parked && winfo.m_can_steal){
+            wake(winfo);
+            return;
+        }
+    }
 }
 
 int Queue::random_worker_id() {
-    mt19937 random_generator { random_device{}() };
+    static thread_local mt19937 random_generator { random_device{}() };
     return uniform_int_distribution<int>{0, num_workers() -1}(random_generator);
 }
 
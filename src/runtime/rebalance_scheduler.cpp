@@ -0,0 +1,138 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "teseo/runtime/rebalance_scheduler.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "teseo/memstore/context.hpp"
+#include "teseo/memstore/latch_state.hpp"
+#include "teseo/memstore/segment.hpp"
+#include "teseo/memstore/sparse_file.hpp"
+
+//#define DEBUG
+#include "teseo/util/debug.hpp"
+
+using namespace std;
+
+namespace teseo::runtime {
+
+RebalanceScheduler::RebalanceScheduler() {
+
+}
+
+RebalanceScheduler::~RebalanceScheduler(){
+    for(auto& item : m_requests){ delete item.second; }
+    m_requests.clear();
+}
+
+bool RebalanceScheduler::request(const memstore::Context& context, const memstore::Key& key, const vector<int>& workers, chrono::milliseconds delay, int* out_worker_id){
+    assert(context.m_leaf != nullptr && context.m_segment != nullptr);
+    assert(out_worker_id != nullptr);
+    const uint64_t segment_urgency = urgency(context);
+
+    scoped_lock<mutex> lock(m_mutex);
+    auto it = m_requests.find(context.m_leaf);
+    if(it != m_requests.end()){ // coalesce with the pending request for the same leaf
+        Request* request = it->second;
+        request->m_keys.emplace_back(key, segment_urgency);
+        request->m_urgency += segment_urgency;
+        COUT_DEBUG("leaf: " << context.m_leaf << ", key: " << key << ", coalesced with " << request->m_keys.size() -1 << " requests");
+        return false;
+    } else {
+        Request* request = new Request();
+        request->m_memstore = context.m_tree;
+        request->m_leaf = context.m_leaf;
+        request->m_keys.emplace_back(key, segment_urgency);
+        request->m_urgency = segment_urgency;
+        request->m_deadline = chrono::steady_clock::now() + delay;
+        request->m_worker_id = worker_id(context.m_leaf, workers);
+        m_requests[context.m_leaf] = request;
+
+        *out_worker_id = request->m_worker_id;
+        COUT_DEBUG("leaf: " << context.m_leaf << ", key: " << key << ", worker_id: " << request->m_worker_id);
+        return true;
+    }
+}
+
+RebalanceScheduler::Request* RebalanceScheduler::fetch(int worker_id){
+    const auto now = chrono::steady_clock::now();
+    scoped_lock<mutex> lock(m_mutex);
+
+    // Every request notifies its worker once, after its deadline. Pick the most urgent among the requests already
+    // past their deadline or, if the timer was slightly ahead, the request with the closest deadline.
+    Request* candidate = nullptr;
+    for(auto& item : m_requests){
+        Request* request = item.second;
+        if(request->m_worker_id != worker_id) continue;
+
+        if(candidate == nullptr){
+            candidate = request;
+        } else if(request->m_deadline <= now){
+            if(candidate->m_deadline > now || request->m_urgency > candidate->m_urgency){
+                candidate = request;
+            }
+        } else if(candidate->m_deadline > now && request->m_deadline < candidate->m_deadline){
+            candidate = request;
+        }
+    }
+
+    if(candidate != nullptr){
+        m_requests.erase(candidate->m_leaf);
+    }
+
+    return candidate;
+}
+
+uint64_t RebalanceScheduler::size() {
+    scoped_lock<mutex> lock(m_mutex);
+    return m_requests.size();
+}
+
+int RebalanceScheduler::worker_id(const memstore::Leaf* leaf, const vector<int>& workers){
+    assert(!workers.empty());
+    uint64_t h = reinterpret_cast<uint64_t>(leaf) >> 4; // drop the bits fixed by the alignment of the allocator
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdull; h ^= h >> 33; // mix the bits, from MurmurHash3's finaliser
+    return workers[h % workers.size()];
+}
+
+uint64_t RebalanceScheduler::urgency(const memstore::Context& context){
+    const memstore::Segment* segment = context.m_segment;
+
+    // the writer issuing the request still holds the segment, the readers and writers queued behind it would be delayed
+    // by the next rebalances as well
+    uint64_t score = segment->used_space();
+    if(segment->latch_state().m_wait){ score += memstore::SparseFile::max_num_qwords(); }
+    return score;
+}
+
+vector<memstore::Key> RebalanceScheduler::Request::keys() const {
+    auto keys = m_keys;
+    stable_sort(begin(keys), end(keys), [](const auto& k1, const auto& k2){ return k1.second > k2.second; });
+
+    vector<memstore::Key> result;
+    result.reserve(keys.size());
+    for(auto& k : keys){
+        if(find(begin(result), end(result), k.first) == end(result)){ // the same segment may be requested again after a rebalance
+            result.push_back(k.first);
+        }
+    }
+    return result;
+}
+
+} // namespace
@@ -16,16 +16,21 @@
  */
 #include "teseo/runtime/runtime.hpp"
 
+#include <algorithm>
 #include <future>
+#include <vector>
 
+#include "teseo/aux/static_view.hpp"
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/scoped_epoch.hpp"
+#include "teseo/context/static_configuration.hpp"
 #include "teseo/memstore/context.hpp"
 #include "teseo/memstore/index.hpp"
 #include "teseo/memstore/leaf.hpp"
 #include "teseo/memstore/memstore.hpp"
 #include "teseo/memstore/segment.hpp"
 #include "teseo/profiler/scoped_timer.hpp"
+#include "teseo/rebalance/merge_operator.hpp"
 #include "teseo/runtime/queue.hpp"
 #include "teseo/runtime/task.hpp"
 #include "teseo/runtime/timer_service.hpp"
@@ -38,7 +43,7 @@ using namespace std;
 
 namespace teseo::runtime {
 
-Runtime::Runtime(context::GlobalContext* global_context) : m_global_context(global_context), m_queue(this), m_timer_service(this) {
+Runtime::Runtime(context::GlobalContext* global_context) : m_global_context(global_context), m_rebalance_scheduler(), m_queue(this), m_timer_service(this), m_thread_pool(global_context) {
     // to avoid a false positive in Valgrid, start explicitly the service after the queue has been completely initialised
     m_timer_service.start();
 
@@ -46,7 +51,7 @@ Runtime::Runtime(context::GlobalContext* global_context) : m_global_context(glob
     m_queue.submit_all(Task{TaskType::TXN_MEMPOOL_PASS, nullptr});
 
     // start performing the GC passes
-    m_queue.submit_all(Task{TaskType::GC_RUN, nullptr});
+    start_gc();
 }
 
 Runtime::~Runtime(){
@@ -84,25 +89,87 @@ void Runtime::rebalance_segment_sync(memstore::Memstore* memstore, const memstor
     consumer.wait();
 }
 
-void Runtime::aux_partial_result(const memstore::Context& context, aux::PartialResult* partial_result){
-    int worker_id = next_worker_id();
+void Runtime::aux_partial_result(const memstore::Context& context, aux::PartialResult* partial_result, int numa_node){
+    int worker_id = next_worker_id(numa_node);
     Task task { TaskType::AUX_PARTIAL_RESULT, new TaskAuxPartialResult{ context, partial_result } };
     m_queue.submit(task, worker_id);
 }
 
-void Runtime::schedule_rebalance(memstore::Memstore* memstore, const memstore::Key& key){
-    profiler::ScopedTimer profiler { profiler::RUNTIME_SCHEDULE_REBALANCE };
-    Task task { TaskType::MEMSTORE_REBALANCE, new TaskRebalance{ memstore, key } };
-    m_timer_service.schedule_task(task, /* anyone = */ -1, context::StaticConfiguration::runtime_delay_rebalance);
+void Runtime::aux_build_hashmap(aux::StaticView* view, bool init, uint64_t size){
+    const uint64_t partition_size = context::StaticConfiguration::aux_hashmap_partition_size;
+    const uint64_t num_tasks = max<uint64_t>(1, min<uint64_t>(m_queue.num_workers(), (size + partition_size -1) / partition_size));
+    vector<promise<void>> producers ( num_tasks );
+    vector<future<void>> consumers; consumers.reserve(num_tasks);
+
+    for(uint64_t i = 0; i < num_tasks; i++){
+        uint64_t start = size * i / num_tasks;
+        uint64_t end = size * (i +1) / num_tasks;
+        consumers.push_back( producers[i].get_future() );
+        Task task { TaskType::AUX_BUILD_HASHMAP, new TaskAuxBuildHashMap{ &(producers[i]), view, init, start, end } };
+        m_queue.submit(task, i);
+    }
+
+    for(auto& c : consumers){ c.wait(); }
+}
+
+void Runtime::merge_leaves(rebalance::MergePass* pass){
+    const uint64_t num_tasks = max<uint64_t>(1, min<uint64_t>(m_queue.num_workers(), pass->num_ranges()));
+    vector<promise<void>> producers ( num_tasks );
+    vector<future<void>> consumers; consumers.reserve(num_tasks);
+
+    for(uint64_t i = 0; i < num_tasks; i++){
+        consumers.push_back( producers[i].get_future() );
+        Task task { TaskType::MEMSTORE_MERGE_LEAVES, new TaskMergeLeaves{ &(producers[i]), pass } };
+        m_queue.submit(task, i);
+    }
+
+    for(auto& c : consumers){ c.wait(); }
+}
+
+void Runtime::spread_job(shared_ptr<rebalance::SpreadJob> job, int num_workers){
+    for(int i = 0, end = min(num_workers, m_queue.num_workers()); i < end; i++){
+        Task task { TaskType::MEMSTORE_SPREAD_JOB, new TaskSpreadJob{ job } };
+        m_queue.submit(task, next_worker_id());
+    }
 }
 
 void Runtime::schedule_rebalance(const memstore::Context& context, const memstore::Key& key){
-    schedule_rebalance(context.m_tree, key);
+    profiler::ScopedTimer profiler { profiler::RUNTIME_SCHEDULE_REBALANCE };
+    int worker_id = -1;
+    bool first_request = m_rebalance_scheduler.request(context, key, m_queue.workers_on_node(context.m_leaf->numa_node()), context::StaticConfiguration::runtime_delay_rebalance, &worker_id);
+    if(first_request){ // otherwise the worker has already been notified
+        Task task { TaskType::MEMSTORE_REBALANCE, reinterpret_cast<void*>(static_cast<uintptr_t>(worker_id)) };
+        m_timer_service.schedule_task(task, worker_id, context::StaticConfiguration::runtime_delay_rebalance);
+    }
+}
+
+RebalanceScheduler* Runtime::rebalance_scheduler(){
+    return &m_rebalance_scheduler;
+}
+
+ThreadPool* Runtime::thread_pool(){
+    return &m_thread_pool;
 }
 
-void Runtime::schedule_gc_pass(int worker_id){
-    Task task { TaskType::GC_RUN, nullptr };
-    m_timer_service.schedule_task(task, worker_id, context::StaticConfiguration::runtime_gc_frequency);
+void Runtime::schedule_prune(memstore::Memstore* memstore, const memstore::Key& key){
+    profiler::ScopedTimer profiler { profiler::RUNTIME_SCHEDULE_PRUNE };
+    Task task { TaskType::MEMSTORE_PRUNE, new TaskRebalance{ memstore, key } };
+    m_timer_service.schedule_task(task, /* anyone = */ -1, context::StaticConfiguration::runtime_delay_prune);
+}
+
+void Runtime::schedule_prune(const memstore::Context& context, const memstore::Key& key){
+    schedule_prune(context.m_tree, key);
+}
+
+void Runtime::start_gc(){
+    for(int i = 0; i < m_queue.num_workers(); i++){
+        m_queue.submit(Task{TaskType::GC_RUN, reinterpret_cast<void*>(static_cast<uintptr_t>(i))}, i);
+    }
+}
+
+void Runtime::schedule_gc_pass(int worker_id, std::chrono::milliseconds delay){
+    Task task { TaskType::GC_RUN, reinterpret_cast<void*>(static_cast<uintptr_t>(worker_id)) };
+    m_timer_service.schedule_task(task, worker_id, delay);
 }
 
 void Runtime::schedule_txnpool_pass(int worker_id){
@@ -155,6 +222,16 @@ int Runtime::next_worker_id(){
     return next % num_workers;
 }
 
+int Runtime::next_worker_id(int numa_node){
+    const auto& workers = m_queue.workers_on_node(numa_node);
+    uint64_t next = m_rr_next_counter ++;
+    return workers[next % workers.size()];
+}
+
+int Runtime::num_workers() const {
+    return m_queue.num_workers();
+}
+
 transaction::MemoryPoolList* Runtime::transaction_pool(){
     return m_queue.random_worker()->transaction_pool();
 }
@@ -175,7 +252,7 @@ void Runtime::unregister_thread_contexts(){
     execute_sync(TaskType::UNREGISTER_THREAD_CONTEXT);
 
     // resume the GC at full throttle to deallocate the unregistered thread contexts
-    m_queue.submit_all(Task{TaskType::GC_RUN, nullptr});
+    start_gc();
 }
 
 void Runtime::enable_rebalance(){
@@ -193,12 +270,21 @@ void Runtime::delete_task(Task task){
     case TaskType::AUX_PARTIAL_RESULT: {
         delete reinterpret_cast<TaskAuxPartialResult*>(task.payload());
     } break;
-    case TaskType::MEMSTORE_REBALANCE:{
+    case TaskType::AUX_BUILD_HASHMAP: {
+        delete reinterpret_cast<TaskAuxBuildHashMap*>(task.payload());
+    } break;
+    case TaskType::MEMSTORE_PRUNE: {
         delete reinterpret_cast<TaskRebalance*>(task.payload());
     } break;
     case TaskType::MEMSTORE_REBALANCE_SYNC: {
         delete reinterpret_cast<SyncTaskRebalance*>(task.payload());
     } break;
+    case TaskType::MEMSTORE_MERGE_LEAVES: {
+        delete reinterpret_cast<TaskMergeLeaves*>(task.payload());
+    } break;
+    case TaskType::MEMSTORE_SPREAD_JOB: {
+        delete reinterpret_cast<TaskSpreadJob*>(task.payload());
+    } break;
     default:
         ; /* nop */
     }
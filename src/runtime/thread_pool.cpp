@@ -0,0 +1,263 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "teseo/runtime/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <string>
+
+#include "teseo/context/global_context.hpp"
+#include "teseo/context/static_configuration.hpp"
+#include "teseo/util/cpu_topology.hpp"
+#include "teseo/util/error.hpp"
+#include "teseo/util/thread.hpp"
+
+//#define DEBUG
+#include "teseo/util/debug.hpp"
+
+using namespace std;
+
+namespace teseo::runtime {
+
+/*****************************************************************************
+ *                                                                           *
+ *   ThreadPool                                                              *
+ *                                                                           *
+ *****************************************************************************/
+
+static uint64_t init_setting_max_threads(); // forward decl.
+
+ThreadPool::ThreadPool(context::GlobalContext* global_context) : m_global_context(global_context), m_max_threads(init_setting_max_threads()) {
+    COUT_DEBUG("max threads: " << m_max_threads);
+}
+
+ThreadPool::~ThreadPool(){
+    stop();
+}
+
+void ThreadPool::submit(function<void()> job){
+    scoped_lock<mutex> lock(m_mutex);
+    if(m_terminate) RAISE(InternalError, "The thread pool has been stopped");
+    reap_exited_threads();
+
+    m_queue.push_back(move(job));
+    if(m_queue.size() > m_num_idle && m_num_active < m_max_threads){ // spawn a new thread
+        uint64_t thread_id = m_next_thread_id++;
+        m_num_active++;
+        m_threads[thread_id] = thread(&ThreadPool::main_thread, this, thread_id);
+    } else {
+        m_condvar.notify_one();
+    }
+}
+
+void ThreadPool::main_thread(uint64_t thread_id){
+    util::Thread::set_name(string("Teseo.Pool #") + to_string(thread_id));
+    m_global_context->register_thread();
+    COUT_DEBUG("thread #" << thread_id << " started");
+
+    unique_lock<mutex> lock(m_mutex);
+    while(true){
+        if(!m_queue.empty()){
+            auto job = move(m_queue.front());
+            m_queue.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        } else if(m_terminate){
+            break;
+        } else {
+            m_num_idle++;
+            bool timeout = !m_condvar.wait_for(lock, context::StaticConfiguration::runtime_pool_idle_timeout, [this](){ return m_terminate || !m_queue.empty(); });
+            m_num_idle--;
+            if(timeout){
+                m_exited.push_back(thread_id);
+                break;
+            }
+        }
+    }
+    m_num_active--;
+    lock.unlock();
+
+    m_global_context->unregister_thread();
+    COUT_DEBUG("thread #" << thread_id << " terminated");
+}
+
+void ThreadPool::reap_exited_threads(){
+    for(auto thread_id : m_exited){
+        auto it = m_threads.find(thread_id);
+        assert(it != m_threads.end());
+        it->second.join();
+        m_threads.erase(it);
+    }
+    m_exited.clear();
+}
+
+void ThreadPool::parallel_for(uint64_t begin, uint64_t end, uint64_t grain, const function<function<void(uint64_t)>()>& make_body){
+    if(begin >= end) return;
+    if(grain == 0) RAISE(InternalError, "Invalid grain: 0");
+
+    struct State {
+        atomic<uint64_t> m_next; // the first index of the next chunk to process
+        const uint64_t m_end; // the last index of the interval, excl.
+        const uint64_t m_grain; // the size of each chunk
+        mutex m_mutex; // sync the access to m_num_runners and m_error
+        condition_variable m_condvar; // notify the caller when all runners are done
+        uint64_t m_num_runners = 0; // number of threads currently processing the interval
+        exception_ptr m_error; // the first exception raised
+
+        State(uint64_t begin, uint64_t end, uint64_t grain) : m_next(begin), m_end(end), m_grain(grain) { }
+    };
+    auto state = make_shared<State>(begin, end, grain);
+
+    // The runners submitted to the pool may start after the interval has already been processed by the others. Only
+    // the runners that claimed a chunk can access `make_body', as the caller waits for them to complete.
+    auto runner = [state, &make_body](){
+        { scoped_lock<mutex> lock(state->m_mutex); state->m_num_runners++; } // before claiming any chunk
+        try {
+            uint64_t from = state->m_next.fetch_add(state->m_grain);
+            if(from < state->m_end){
+                auto body = make_body();
+                do {
+                    uint64_t to = min(from + state->m_grain, state->m_end);
+                    for(uint64_t i = from; i < to; i++){ body(i); }
+                    from = state->m_next.fetch_add(state->m_grain);
+                } while(from < state->m_end);
+            }
+        } catch(...){
+            state->m_next = state->m_end; // skip the remaining chunks
+            scoped_lock<mutex> lock(state->m_mutex);
+            if(!state->m_error){ state->m_error = current_exception(); }
+        }
+
+        scoped_lock<mutex> lock(state->m_mutex);
+        state->m_num_runners--;
+        if(state->m_num_runners == 0){ state->m_condvar.notify_all(); }
+    };
+
+    const uint64_t num_chunks = (end - begin + grain -1) / grain;
+    const uint64_t num_helpers = min(num_chunks, m_max_threads) -1;
+    for(uint64_t i = 0; i < num_helpers; i++){
+        submit(runner);
+    }
+    runner(); // the caller participates as well
+
+    unique_lock<mutex> lock(state->m_mutex);
+    state->m_condvar.wait(lock, [&state](){ return state->m_num_runners == 0; });
+    if(state->m_error){ rethrow_exception(state->m_error); }
+}
+
+void ThreadPool::stop(){
+    unordered_map<uint64_t, thread> threads;
+    {
+        scoped_lock<mutex> lock(m_mutex);
+        m_terminate = true;
+        m_queue.clear();
+        m_exited.clear();
+        threads.swap(m_threads);
+        m_condvar.notify_all();
+    }
+
+    for(auto& t : threads){ t.second.join(); }
+}
+
+uint64_t ThreadPool::max_threads() const {
+    return m_max_threads;
+}
+
+uint64_t ThreadPool::num_threads() {
+    scoped_lock<mutex> lock(m_mutex);
+    return m_num_active;
+}
+
+static uint64_t init_setting_max_threads(){
+    if(context::StaticConfiguration::runtime_pool_max_threads == 0){
+        // one thread for each core in the machine, excluding the physical threads in SMT
+        auto topo = make_unique<util::cpu_topology>();
+        auto threads = topo->get_threads(/* ignore */ false, /* SMT ? */ false);
+        return max<uint64_t>(1, threads.size());
+    } else {
+        return context::StaticConfiguration::runtime_pool_max_threads;
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   TaskGroup                                                               *
+ *                                                                           *
+ *****************************************************************************/
+
+TaskGroup::TaskGroup(ThreadPool* pool) : m_pool(pool), m_state(make_shared<State>()) {
+    assert(pool != nullptr);
+}
+
+TaskGroup::~TaskGroup(){
+    try {
+        wait();
+    } catch(...) {
+        /* ignore */
+    }
+}
+
+void TaskGroup::run(function<void()> closure){
+    {
+        scoped_lock<mutex> lock(m_state->m_mutex);
+        m_state->m_pending.push_back(move(closure));
+    }
+
+    m_pool->submit([state = m_state](){ state->execute_next(); });
+}
+
+bool TaskGroup::State::execute_next(){
+    function<void()> closure;
+    {
+        scoped_lock<mutex> lock(m_mutex);
+        if(m_pending.empty()) return false; // already executed by another thread
+        closure = move(m_pending.front());
+        m_pending.pop_front();
+        m_num_running++;
+    }
+
+    exception_ptr error;
+    try {
+        closure();
+    } catch(...){
+        error = current_exception();
+    }
+    closure = nullptr; // release the state captured by the closure before signalling the waiters
+
+    scoped_lock<mutex> lock(m_mutex);
+    if(error && !m_error){ m_error = error; }
+    m_num_running--;
+    if(m_num_running == 0 && m_pending.empty()){ m_condvar.notify_all(); }
+    return true;
+}
+
+void TaskGroup::wait(){
+    while(m_state->execute_next()) { /* help with the pending closures */ };
+
+    unique_lock<mutex> lock(m_state->m_mutex);
+    m_state->m_condvar.wait(lock, [this](){ return m_state->m_num_running == 0 && m_state->m_pending.empty(); });
+    if(m_state->m_error){
+        exception_ptr error = m_state->m_error;
+        m_state->m_error = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+} // namespace
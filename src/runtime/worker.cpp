@@ -20,14 +20,18 @@
 #include <iostream>
 #include <string>
 
+#include "teseo/aux/static_view.hpp"
 #include "teseo/context/global_context.hpp"
+#include "teseo/context/scoped_epoch.hpp"
 #include "teseo/context/thread_context.hpp"
 #include "teseo/gc/garbage_collector.hpp"
 #include "teseo/memstore/index.hpp"
 #include "teseo/memstore/memstore.hpp"
 #include "teseo/rebalance/merge_operator.hpp"
 #include "teseo/rebalance/rebalance.hpp"
+#include "teseo/rebalance/spread_operator.hpp"
 #include "teseo/runtime/queue.hpp"
+#include "teseo/runtime/rebalance_scheduler.hpp"
 #include "teseo/runtime/runtime.hpp"
 #include "teseo/runtime/task.hpp"
 #include "teseo/transaction/memory_pool_list.hpp"
@@ -56,13 +60,17 @@ Worker::~Worker(){
 void Worker::main_thread(){
     COUT_DEBUG("Worker #" << worker_id() << " started");
     set_thread_name(worker_id());
+    if(m_worker_pool->cpu_id(worker_id()) >= 0){ // the memory allocated by this worker will reside in its node
+        util::Thread::set_affinity(m_worker_pool->cpu_id(worker_id()));
+    }
 
     // event loop
     bool rebal_enabled = false;
+    bool registered = false; // whether the thread context has been registered, required to steal the tasks of the other workers
     bool gc_enabled = true;
     bool terminate = false;
     while(!terminate){
-        Task task = m_worker_pool->fetch(worker_id());
+        Task task = m_worker_pool->fetch(worker_id(), registered);
         switch(task.type()){
         case TaskType::NOP: {
             assert(0 && "Nop");
@@ -73,6 +81,7 @@ void Worker::main_thread(){
             m_gc->set_profiler(context::thread_context()->profiler_events());
             producer->set_value();
             rebal_enabled = true;
+            registered = true;
         } break;
         case TaskType::UNREGISTER_THREAD_CONTEXT: {
             m_gc->set_profiler(nullptr);
@@ -80,11 +89,14 @@ void Worker::main_thread(){
             m_worker_pool->runtime()->global_context()->unregister_thread();
             producer->set_value();
             rebal_enabled = false;
+            registered = false;
         } break;
         case TaskType::GC_RUN: {
-            if(gc_enabled){
-                m_gc->execute();
-                m_worker_pool->runtime()->schedule_gc_pass(worker_id());
+            int owner_id = static_cast<int>(reinterpret_cast<uintptr_t>(task.payload())); // the task may have been stolen
+            gc::GarbageCollector* gc = m_worker_pool->get_worker(owner_id)->gc();
+            if(gc_enabled && gc != nullptr){
+                gc->execute(/* record profile ? */ owner_id == worker_id());
+                m_worker_pool->runtime()->schedule_gc_pass(owner_id, gc->delay());
             }
         } break;
         case TaskType::GC_TERMINATE:
@@ -105,11 +117,23 @@ void Worker::main_thread(){
             rebal_enabled = false;
         } break;
         case TaskType::MEMSTORE_REBALANCE: {
-            auto task_rebal = reinterpret_cast<TaskRebalance*>(task.payload());
+            int target_id = static_cast<int>(reinterpret_cast<uintptr_t>(task.payload())); // the task may have been stolen
+            RebalanceScheduler::Request* request = m_worker_pool->runtime()->rebalance_scheduler()->fetch(target_id);
+            if(request != nullptr){
+                if(rebal_enabled){
+                    for(auto& key : request->keys()){
+                        rebalance::handle_rebalance(request->m_memstore, key);
+                    }
+                } else {
+                    COUT_DEBUG("Request ignored, leaf: " << request->m_leaf << ", num keys: " << request->m_keys.size());
+                }
+                delete request;
+            }
+        } break;
+        case TaskType::MEMSTORE_PRUNE: {
+            auto task_prune = reinterpret_cast<TaskRebalance*>(task.payload());
             if(rebal_enabled){
-                rebalance::handle_rebalance(task_rebal->m_memstore, task_rebal->m_key);
-            } else {
-                COUT_DEBUG("Request ignored, context: " << task_rebal->m_context << ", key: " << task_rebal->m_key);
+                rebalance::handle_prune(task_prune->m_memstore, task_prune->m_key);
             }
         } break;
         case TaskType::MEMSTORE_REBALANCE_SYNC: { // only used for testing purposes
@@ -117,6 +141,18 @@ void Worker::main_thread(){
             rebalance::handle_rebalance(task_rebal->m_memstore, task_rebal->m_key);
             task_rebal->m_producer->set_value(); // done
         } break;
+        case TaskType::MEMSTORE_MERGE_LEAVES: {
+            auto task_merge = reinterpret_cast<TaskMergeLeaves*>(task.payload());
+            task_merge->m_pass->execute();
+            task_merge->m_producer->set_value(); // done
+        } break;
+        case TaskType::MEMSTORE_SPREAD_JOB: {
+            auto task_spread = reinterpret_cast<TaskSpreadJob*>(task.payload());
+            if(rebal_enabled){ // otherwise the items are left to the rebalancer
+                context::ScopedEpoch epoch; // protect from the GC
+                task_spread->m_job->execute();
+            }
+        } break;
         case TaskType::AUX_PARTIAL_RESULT: {
             auto task_aux = reinterpret_cast<TaskAuxPartialResult*>(task.payload());
             auto memstore = task_aux->m_context.m_tree;
@@ -124,6 +160,15 @@ void Worker::main_thread(){
             auto partial_result = task_aux->m_partial_result;
             memstore->aux_partial_result(transaction, partial_result);
         } break;
+        case TaskType::AUX_BUILD_HASHMAP: {
+            auto task_hashmap = reinterpret_cast<TaskAuxBuildHashMap*>(task.payload());
+            if(task_hashmap->m_init){
+                task_hashmap->m_view->hashmap_init(task_hashmap->m_start, task_hashmap->m_end);
+            } else {
+                task_hashmap->m_view->hashmap_insert(task_hashmap->m_start, task_hashmap->m_end, /* concurrent ? */ true);
+            }
+            task_hashmap->m_producer->set_value(); // done
+        } break;
         case TaskType::TERMINATE: {
             terminate = true;
         } break;
@@ -20,24 +20,31 @@
 
 #include <cassert>
 #include <cinttypes>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
+#include "teseo/aux/cost_model.hpp"
 #include "teseo/aux/dynamic_view.hpp"
 #include "teseo/aux/view.hpp"
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/scoped_epoch.hpp"
 #include "teseo/context/thread_context.hpp"
+#include "teseo/memstore/checkpoint.hpp"
 #include "teseo/memstore/context.hpp"
 #include "teseo/memstore/cursor_state.hpp"
 #include "teseo/memstore/error.hpp"
 #include "teseo/memstore/memstore.hpp"
 #include "teseo/profiler/scoped_timer.hpp"
+#include "teseo/rebalance/merger_service.hpp"
+#include "teseo/runtime/runtime.hpp"
+#include "teseo/runtime/thread_pool.hpp"
 #include "teseo/transaction/transaction_impl.hpp"
 #include "teseo/transaction/transaction_latch.hpp"
 #include "teseo/util/error.hpp"
 #include "teseo/util/interface.hpp"
+#include "teseo/util/timer.hpp"
 
 //#define DEBUG
 #include "teseo/util/debug.hpp"
@@ -84,10 +91,100 @@ Transaction Teseo::start_transaction(bool read_only){
     return Transaction(tx_impl);
 }
 
+void Teseo::enable_redo_log(const std::string& path){
+    GCTXT->enable_redo_log(path);
+}
+
+void Teseo::disable_redo_log(){
+    GCTXT->disable_redo_log();
+}
+
+void Teseo::checkpoint(const std::string& path){
+    memstore::Checkpoint::save(GCTXT, path);
+}
+
+void Teseo::restore(const std::string& path){
+    memstore::Checkpoint::restore(GCTXT, path);
+}
+
+void Teseo::compact(){
+    GCTXT->memstore()->merger()->compact_now();
+}
+
+void Teseo::set_memory_target(uint64_t bytes){
+    GCTXT->set_merger_memory_target(bytes);
+}
+
+void Teseo::parallel_for(uint64_t begin, uint64_t end, uint64_t grain, const std::function<void(uint64_t)>& fn){
+    GCTXT->runtime()->thread_pool()->parallel_for(begin, end, grain, [&fn](){ return fn; });
+}
+
+void Teseo::parallel_for(const Transaction& transaction, uint64_t begin, uint64_t end, uint64_t grain, const std::function<void(Transaction&, Iterator&, uint64_t)>& fn){
+    struct Local { // the copies of each thread
+        Transaction m_transaction;
+        Iterator m_iterator;
+
+        Local(const Transaction& transaction) : m_transaction(transaction), m_iterator(m_transaction.iterator()) { }
+    };
+
+    GCTXT->runtime()->thread_pool()->parallel_for(begin, end, grain, [&transaction, &fn](){
+        auto local = make_shared<Local>(transaction);
+        return [local, &fn](uint64_t i){ fn(local->m_transaction, local->m_iterator, i); };
+    });
+}
+
 void* Teseo::handle_impl(){
     return m_pImpl;
 }
 
+/*****************************************************************************
+ *                                                                           *
+ *  Task group                                                               *
+ *                                                                           *
+ *****************************************************************************/
+
+namespace {
+struct TaskGroupImpl {
+    runtime::TaskGroup m_group;
+    unique_ptr<Transaction> m_transaction; // optional, the transaction shared by the closures
+
+    TaskGroupImpl(Teseo& database) : m_group(reinterpret_cast<context::GlobalContext*>(database.handle_impl())->runtime()->thread_pool()) { }
+};
+} // anon namespace
+
+#define TGIMPL reinterpret_cast<TaskGroupImpl*>(m_pImpl)
+
+TaskGroup::TaskGroup(Teseo& database) : m_pImpl(new TaskGroupImpl(database)){
+
+}
+
+TaskGroup::TaskGroup(Teseo& database, const Transaction& transaction) : TaskGroup(database) {
+    TGIMPL->m_transaction.reset(new Transaction(transaction));
+}
+
+TaskGroup::~TaskGroup(){
+    delete TGIMPL; m_pImpl = nullptr; // wait for the pending closures
+}
+
+void TaskGroup::run(std::function<void()> fn){
+    TGIMPL->m_group.run(move(fn));
+}
+
+void TaskGroup::run(std::function<void(Transaction&, Iterator&)> fn){
+    if(!TGIMPL->m_transaction){ RAISE_EXCEPTION(LogicalError, "The task group has not been created with a transaction"); }
+
+    TGIMPL->m_group.run([transaction = *(TGIMPL->m_transaction), fn = move(fn)]() mutable {
+        Iterator iterator = transaction.iterator();
+        fn(transaction, iterator);
+    });
+}
+
+void TaskGroup::wait(){
+    TGIMPL->m_group.wait();
+}
+
+#undef TGIMPL
+
 /*****************************************************************************
  *                                                                           *
  * Transaction                                                               *
@@ -225,6 +322,12 @@ uint64_t Transaction::degree(uint64_t vertex, bool logical) const {
 
             if (logical || TXN->aux_use_for_degree()){ // rely on the degree vector
                 result = TXN->aux_degree(logical ? vertex : E2I(vertex), logical);
+            } else if (TXN->aux_sample_degree()){ // sample the cost of the lookup for the cost model of the aux view
+                util::Timer timer;
+                timer.start();
+                result = sa->get_degree(TXN, E2I(vertex));
+                timer.stop();
+                context::global_context()->aux_cost_model()->record_lookup(timer.nanoseconds());
             } else {
                 // lock the traversed segments with a shared lock
                 result = sa->get_degree(TXN, E2I(vertex));
@@ -241,6 +344,12 @@ uint64_t Transaction::degree(uint64_t vertex, bool logical) const {
 
                     if(logical || TXN->aux_use_for_degree()){
                         result = TXN->aux_degree(logical ? vertex : E2I(vertex), logical);
+                    } else if(TXN->aux_sample_degree()){ // sample the cost of the lookup for the cost model of the aux view
+                        util::Timer timer;
+                        timer.start();
+                        result = sa->get_degree_nolock(TXN, E2I(vertex));
+                        timer.stop();
+                        context::global_context()->aux_cost_model()->record_lookup(timer.nanoseconds());
                     } else {
                         result = sa->get_degree_nolock(TXN, E2I(vertex));
                     }
@@ -448,6 +557,10 @@ bool Transaction::is_read_only() const {
     return TXN->is_read_only();
 }
 
+void Transaction::hint_degree_queries(uint64_t num_queries){
+    TXN->aux_degree_hint(num_queries);
+}
+
 void Transaction::commit(){
     TXN->commit();
 }
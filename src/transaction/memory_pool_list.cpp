@@ -17,11 +17,13 @@
 
 #include "teseo/transaction/memory_pool_list.hpp"
 
+#include <cstring>
 #include <mutex>
 
 #include "teseo/context/static_configuration.hpp"
 #include "teseo/profiler/scoped_timer.hpp"
 #include "teseo/transaction/memory_pool.hpp"
+#include "teseo/transaction/undo_buffer.hpp"
 
 //#define DEBUG
 #include "teseo/util/debug.hpp"
@@ -30,8 +32,10 @@ using namespace std;
 
 namespace teseo::transaction {
 
-MemoryPoolList::MemoryPoolList() : m_profiler(nullptr) {
-    /* nop */
+MemoryPoolList::MemoryPoolList() : m_profiler(nullptr), m_undo_cached_bytes(0) {
+    static_assert(context::StaticConfiguration::transaction_undo_buffer_size << (m_undo_num_classes -1) == context::StaticConfiguration::transaction_undo_buffer_max_size,
+            "The max size of an undo buffer must be a power of two multiple of its default size");
+    memset(m_undo_free_lists, '\0', sizeof(m_undo_free_lists));
 }
 
 MemoryPoolList::~MemoryPoolList(){
@@ -43,6 +47,13 @@ MemoryPoolList::~MemoryPoolList(){
         MemoryPool::destroy(m_idle[0]);
         m_idle.pop();
     }
+    for(uint64_t i = 0; i < m_undo_num_classes; i++){
+        while(m_undo_free_lists[i] != nullptr){
+            UndoBuffer* next = m_undo_free_lists[i]->m_next;
+            UndoBuffer::deallocate(m_undo_free_lists[i]);
+            m_undo_free_lists[i] = next;
+        }
+    }
 }
 
 MemoryPool* MemoryPoolList::acquire(){
@@ -122,6 +133,68 @@ void MemoryPoolList::cleanup(){
     COUT_DEBUG("idle queue size: " << m_idle.size() << ", ready queue size: " << m_ready.size());
 }
 
+int MemoryPoolList::undo_size_class(uint32_t buffer_sz){
+    constexpr uint32_t min_size = context::StaticConfiguration::transaction_undo_buffer_size;
+    if(buffer_sz < min_size || buffer_sz % min_size != 0) return -1;
+    uint32_t multiple = buffer_sz / min_size;
+    if((multiple & (multiple -1)) != 0) return -1; // not a power of 2
+    int size_class = __builtin_ctz(multiple);
+    return size_class < static_cast<int>(m_undo_num_classes) ? size_class : -1;
+}
+
+UndoBuffer* MemoryPoolList::acquire_undo_buffer(uint32_t buffer_sz){
+    UndoBuffer* undo_buffer = nullptr;
+
+    int size_class = undo_size_class(buffer_sz);
+    if(size_class >= 0){
+        scoped_lock<util::SpinLock> lock(m_undo_latch);
+        undo_buffer = m_undo_free_lists[size_class];
+        if(undo_buffer != nullptr){
+            m_undo_free_lists[size_class] = undo_buffer->m_next;
+            m_undo_cached_bytes -= buffer_sz;
+        }
+    }
+
+    if(undo_buffer == nullptr){
+        undo_buffer = UndoBuffer::allocate(buffer_sz);
+        undo_buffer->m_cache = (size_class >= 0) ? this : nullptr;
+    } else { // reset its state
+        assert(undo_buffer->m_space_total == buffer_sz);
+        assert(undo_buffer->m_cache == this);
+        undo_buffer->m_space_left = undo_buffer->m_space_total;
+    }
+    undo_buffer->m_next = nullptr;
+
+    COUT_DEBUG("buffer_sz: " << buffer_sz << ", undo buffer: " << undo_buffer);
+    return undo_buffer;
+}
+
+void MemoryPoolList::release_undo_buffer(UndoBuffer* undo_buffer){
+    if(undo_buffer == nullptr) return;
+    assert(undo_buffer->m_cache == this && "The undo buffer does not belong to this list");
+    int size_class = undo_size_class(undo_buffer->m_space_total);
+    assert(size_class >= 0 && "Only the buffers with a proper size class should have been associated to this list");
+
+    bool retained = false;
+    { // restrict the scope of the latch
+        scoped_lock<util::SpinLock> lock(m_undo_latch);
+        if(m_undo_cached_bytes + undo_buffer->m_space_total <= context::StaticConfiguration::transaction_undo_buffer_cache_size){
+            undo_buffer->m_next = m_undo_free_lists[size_class];
+            m_undo_free_lists[size_class] = undo_buffer;
+            m_undo_cached_bytes += undo_buffer->m_space_total;
+            retained = true;
+        }
+    }
+
+    if(!retained){ // the free lists are already full
+        UndoBuffer::deallocate(undo_buffer);
+    }
+}
+
+uint64_t MemoryPoolList::undo_cached_bytes() const {
+    return m_undo_cached_bytes;
+}
+
 void MemoryPoolList::set_profiler(profiler::EventThread* profiler){
     m_profiler = profiler;
 }
@@ -132,6 +205,7 @@ void MemoryPoolList::dump() const {
             "target number queues in the ready list: " << context::StaticConfiguration::transaction_memory_pool_list_cache_size << "\n";
     dump_queue("ready", m_ready);
     dump_queue("idle", m_idle);
+    cout << "undo buffers cached: " << m_undo_cached_bytes << " bytes\n";
 }
 
 void MemoryPoolList::dump_queue(const char* name, const util::CircularArray<MemoryPool*>& queue) const {
@@ -0,0 +1,319 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "teseo/transaction/redo_log.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "teseo/context/global_context.hpp"
+#include "teseo/context/static_configuration.hpp"
+#include "teseo/context/thread_context.hpp"
+#include "teseo/memstore/error.hpp"
+#include "teseo/memstore/memstore.hpp"
+#include "teseo/memstore/update.hpp"
+#include "teseo/third-party/magic_enum.hpp"
+#include "teseo/transaction/rollback_interface.hpp"
+#include "teseo/transaction/transaction_impl.hpp"
+#include "teseo/transaction/undo.hpp"
+#include "teseo/transaction/undo_buffer.hpp"
+#include "teseo/util/error.hpp"
+#include "teseo/util/thread.hpp"
+
+//#define DEBUG
+#include "teseo/util/debug.hpp"
+
+using namespace std;
+
+namespace teseo::transaction {
+
+/*****************************************************************************
+ *                                                                           *
+ *   Init                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+RedoLog::RedoLog(const string& path) : m_path(path), m_fd(-1), m_num_partitions(context::StaticConfiguration::transaction_log_num_partitions), m_partitions(nullptr) {
+    m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if(m_fd < 0){ RAISE_EXCEPTION(InternalError, "[RedoLog] Cannot open the log file `" << m_path << "': " << strerror(errno) << " (" << errno << ")"); }
+
+    m_partitions = new Partition[m_num_partitions];
+    m_flusher = thread(&RedoLog::main_flusher, this);
+}
+
+RedoLog::~RedoLog(){
+    { // stop the flusher, it will sync the pending records before terminating
+        lock_guard<mutex> lock(m_mutex);
+        m_terminate = true;
+    }
+    m_condvar_flusher.notify_all();
+    m_flusher.join();
+
+    delete[] m_partitions; m_partitions = nullptr;
+    ::close(m_fd); m_fd = -1;
+}
+
+const string& RedoLog::path() const noexcept {
+    return m_path;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   Append                                                                  *
+ *                                                                           *
+ *****************************************************************************/
+
+uint64_t RedoLog::append(const TransactionImpl* transaction, uint64_t transaction_id){
+    const RollbackInterface* memstore = transaction->m_global_context->memstore();
+
+    // The undo records are stored from the newest to the oldest. Reverse the order, to replay the updates as they were originally performed.
+    vector<const memstore::Update*> updates;
+    for(const UndoBuffer* undo_buffer = transaction->m_undo_last; undo_buffer != nullptr; undo_buffer = undo_buffer->m_next){
+        uint64_t offset = undo_buffer->m_space_left;
+        while(offset < undo_buffer->m_space_total){
+            const Undo* undo = reinterpret_cast<const Undo*>(undo_buffer->buffer() + offset);
+            if(undo->is_active() && undo->data_structure() == memstore){
+                const memstore::Update* update = reinterpret_cast<const memstore::Update*>(undo->payload());
+                if(!update->is_empty()){ updates.push_back(update); }
+            }
+            offset += undo->length();
+        }
+    }
+    if(updates.empty()) return 0; // nothing to log
+
+    uint64_t record_sz = sizeof(TxnHeader) + updates.size() * sizeof(TxnUpdate);
+    Partition& partition = m_partitions[ util::Thread::get_thread_id() % m_num_partitions ];
+    scoped_lock<util::SpinLock> lock(partition.m_latch);
+    uint64_t pos = partition.m_buffer.size();
+    partition.m_buffer.resize(pos + record_sz);
+
+    TxnHeader* header = reinterpret_cast<TxnHeader*>(partition.m_buffer.data() + pos);
+    header->m_magic = MAGIC;
+    header->m_num_updates = updates.size();
+    header->m_transaction_id = transaction_id;
+    header->m_changes = transaction->m_prop_local;
+
+    TxnUpdate* record = reinterpret_cast<TxnUpdate*>(header +1);
+    for(auto it = updates.rbegin(); it != updates.rend(); it++, record++){
+        const memstore::Update* undo = *it; // the undo stores the inverse of the update performed
+        record->m_source = undo->source();
+        record->m_destination = undo->is_edge() ? undo->destination() : 0;
+        // for the insertions, the weight in the undo has been replaced by the storage with the previous weight of the edge
+        record->m_weight = (undo->is_edge() && undo->is_remove()) ? reinterpret_cast<const memstore::UndoEdgeInsertion*>(undo)->m_weight : 0;
+        record->m_flags = (undo->is_vertex() ? FLAG_VERTEX : 0) | (undo->is_remove() ? FLAG_INSERT : 0);
+        record->m_unused = 0;
+    }
+
+    // the lsn must be drawn while holding the latch on the partition, so that the flusher cannot
+    // observe the new lsn without also observing the content of the record
+    return ++m_lsn_appended;
+}
+
+void RedoLog::wait(uint64_t lsn){
+    if(lsn == 0) return; // nop
+
+    unique_lock<mutex> lock(m_mutex);
+    if(m_lsn_durable < lsn){
+        m_condvar_flusher.notify_one();
+        m_condvar_durable.wait(lock, [this, lsn](){ return m_lsn_durable >= lsn || m_error != 0; });
+    }
+
+    if(m_lsn_durable < lsn){
+        RAISE_EXCEPTION(InternalError, "[RedoLog] Cannot write the log file `" << m_path << "': " << strerror(m_error) << " (" << m_error << ")");
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   Flusher                                                                 *
+ *                                                                           *
+ *****************************************************************************/
+
+void RedoLog::main_flusher(){
+    util::Thread::set_name("Teseo.RedoLog");
+    COUT_DEBUG("started");
+
+    vector<uint8_t> buffer;
+    auto time_last_flush = chrono::steady_clock::now() - context::StaticConfiguration::transaction_log_flush_interval;
+
+    unique_lock<mutex> lock(m_mutex);
+    while(true){
+        m_condvar_flusher.wait(lock, [this](){ return m_terminate || m_lsn_appended > m_lsn_durable; });
+        if(m_lsn_appended == m_lsn_durable) break; // terminate, all records have been synced
+
+        lock.unlock();
+        // group commit: let the committers arriving within the interval share the same flush
+        this_thread::sleep_until(time_last_flush + context::StaticConfiguration::transaction_log_flush_interval);
+        time_last_flush = chrono::steady_clock::now();
+        uint64_t lsn = 0;
+        int error = flush(buffer, &lsn);
+        lock.lock();
+
+        if(error != 0){ // the log cannot be written anymore, fail all pending and future commits
+            m_error = error;
+            m_condvar_durable.notify_all();
+            break;
+        }
+
+        m_lsn_durable = lsn;
+        m_condvar_durable.notify_all();
+    }
+
+    COUT_DEBUG("terminated");
+}
+
+int RedoLog::flush(vector<uint8_t>& buffer, uint64_t* out_lsn){
+    uint64_t lsn = m_lsn_appended; // see #append, this must be read before draining the partitions
+
+    buffer.clear();
+    for(uint64_t i = 0; i < m_num_partitions; i++){
+        scoped_lock<util::SpinLock> lock(m_partitions[i].m_latch);
+        buffer.insert(buffer.end(), m_partitions[i].m_buffer.begin(), m_partitions[i].m_buffer.end());
+        m_partitions[i].m_buffer.clear();
+    }
+
+    uint64_t offset = 0;
+    while(offset < buffer.size()){
+        ssize_t rc = ::write(m_fd, buffer.data() + offset, buffer.size() - offset);
+        if(rc < 0){
+            if(errno == EINTR) continue;
+            return errno;
+        }
+        offset += rc;
+    }
+    if(::fdatasync(m_fd) != 0){ return errno; }
+
+    *out_lsn = lsn;
+    return 0;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *   Recovery                                                                *
+ *                                                                           *
+ *****************************************************************************/
+
+struct RedoLog::RecoveredUpdate {
+    uint64_t m_transaction_id; // commit time of the transaction
+    uint64_t m_position; // position in the log, to preserve the order of the updates inside the same transaction
+    memstore::Update m_update; // the update to replay
+};
+
+uint64_t RedoLog::recover(context::GlobalContext* global_context, const string& path){
+    ifstream file(path, ios::binary | ios::ate);
+    if(!file.good()) return 0; // the log does not exist
+    uint64_t file_sz = file.tellg();
+    file.seekg(0);
+    vector<uint8_t> content(file_sz);
+    file.read(reinterpret_cast<char*>(content.data()), file_sz);
+    if(!file.good()){ RAISE_EXCEPTION(InternalError, "[RedoLog] Cannot read the log file `" << path << "'"); }
+    file.close();
+
+    // parse the log
+    vector<RecoveredUpdate> updates;
+    context::GraphProperty changes;
+    uint64_t num_transactions = 0;
+    uint64_t offset = 0;
+    while(offset + sizeof(TxnHeader) <= file_sz){
+        const TxnHeader* header = reinterpret_cast<const TxnHeader*>(content.data() + offset);
+        if(header->m_magic != MAGIC || offset + sizeof(TxnHeader) + header->m_num_updates * sizeof(TxnUpdate) > file_sz){
+            break; // truncated tail, the transaction was never acknowledged as committed
+        }
+
+        const TxnUpdate* record = reinterpret_cast<const TxnUpdate*>(header +1);
+        for(uint64_t i = 0; i < header->m_num_updates; i++){
+            memstore::Key key { record[i].m_source, record[i].m_destination };
+            updates.push_back(RecoveredUpdate{ header->m_transaction_id, updates.size(), memstore::Update{ (record[i].m_flags & FLAG_VERTEX) != 0, (record[i].m_flags & FLAG_INSERT) != 0, key, record[i].m_weight } });
+        }
+
+        changes += header->m_changes;
+        num_transactions++;
+        offset += sizeof(TxnHeader) + header->m_num_updates * sizeof(TxnUpdate);
+    }
+    COUT_DEBUG("transactions: " << num_transactions << ", updates: " << updates.size());
+
+    // Updates on different source vertices are independent of each other, replay them in commit order only inside the same source
+    sort(begin(updates), end(updates), [](const RecoveredUpdate& u1, const RecoveredUpdate& u2){
+        if(u1.m_update.source() != u2.m_update.source()) return u1.m_update.source() < u2.m_update.source();
+        if(u1.m_transaction_id != u2.m_transaction_id) return u1.m_transaction_id < u2.m_transaction_id;
+        return u1.m_position < u2.m_position;
+    });
+
+    // Split the updates in partitions of contiguous source vertices
+    uint64_t num_partitions = min<uint64_t>(max(1u, thread::hardware_concurrency()), updates.size() / context::StaticConfiguration::transaction_log_replay_batch_size +1);
+    vector<thread> workers;
+    vector<exception_ptr> errors(num_partitions);
+    uint64_t start = 0;
+    for(uint64_t i = 0; i < num_partitions && start < updates.size(); i++){
+        uint64_t end = (i == num_partitions -1) ? updates.size() : max(start, updates.size() * (i +1) / num_partitions);
+        while(end < updates.size() && end > start && updates[end].m_update.source() == updates[end -1].m_update.source()){ end++; } // do not split a source vertex
+
+        workers.emplace_back([global_context, &updates, &errors, i, start, end](){
+            global_context->register_thread();
+            try {
+                replay(global_context, updates.data() + start, end - start);
+            } catch(...){
+                errors[i] = current_exception();
+            }
+            global_context->unregister_thread();
+        });
+
+        start = end;
+    }
+    for(auto& w : workers){ w.join(); }
+    for(auto& e : errors){ if(e != nullptr){ rethrow_exception(e); } }
+
+    // Finally, restore the number of vertices & edges in the graph
+    if(changes){
+        TransactionImpl* transaction = context::thread_context()->create_transaction(/* read only ? */ false);
+        transaction->local_graph_changes() = changes;
+        transaction->commit();
+        transaction->decr_user_count();
+    }
+
+    return num_transactions;
+}
+
+void RedoLog::replay(context::GlobalContext* global_context, const RecoveredUpdate* updates, uint64_t num_updates){
+    memstore::Memstore* memstore = global_context->memstore();
+    constexpr uint64_t BATCH_SIZE = context::StaticConfiguration::transaction_log_replay_batch_size;
+
+    for(uint64_t i = 0; i < num_updates; i += BATCH_SIZE){
+        TransactionImpl* transaction = context::thread_context()->create_transaction(/* read only ? */ false);
+
+        try {
+            for(uint64_t j = i, end = min(i + BATCH_SIZE, num_updates); j < end; j++){
+                memstore->redo(transaction, updates[j].m_update);
+            }
+        } catch(const memstore::Error& error){
+            transaction->rollback();
+            transaction->decr_user_count();
+            RAISE_EXCEPTION(InternalError, "[RedoLog] Cannot replay the log, key: " << error.m_key << ", error: " << magic_enum::enum_name(error.m_type));
+        }
+
+        transaction->commit();
+        transaction->decr_user_count();
+    }
+}
+
+} // namespace
@@ -28,7 +28,9 @@
 #include <mutex>
 #include <thread>
 
+#include "teseo/aux/cache.hpp"
 #include "teseo/aux/cb_serialise_build.hpp"
+#include "teseo/aux/cost_model.hpp"
 #include "teseo/aux/static_view.hpp"
 #include "teseo/aux/view.hpp"
 #include "teseo/context/global_context.hpp"
@@ -41,6 +43,8 @@
 #include "teseo/memstore/segment.hpp"
 #include "teseo/profiler/scoped_timer.hpp"
 #include "teseo/transaction/memory_pool.hpp"
+#include "teseo/transaction/memory_pool_list.hpp"
+#include "teseo/transaction/redo_log.hpp"
 #include "teseo/transaction/transaction_latch.hpp"
 #include "teseo/transaction/undo.hpp"
 #include "teseo/transaction/undo_buffer.hpp"
@@ -166,27 +170,46 @@ bool TransactionImpl::can_read_optimistic(const Undo* head, void** out_payload,
  *****************************************************************************/
 void TransactionImpl::commit(){
     profiler::ScopedTimer profiler { profiler::TXN_COMMIT };
+    RedoLog* redo_log = m_global_context->redo_log();
+    aux::Cache* aux_cache = m_global_context->aux_cache();
+    uint64_t lsn = 0; // the position of the changes in the redo log
+
+    { // critical section
+        TransactionWriteLatch xlock(this);
+        profiler::ScopedTimer prof_cs { profiler::TXN_COMMIT_CRITICAL_SECTION };
+        if(is_terminated()) RAISE_EXCEPTION(LogicalError, "This transaction is already terminated");
+        if(has_iterators()) RAISE_EXCEPTION(LogicalError, "The transaction cannot be terminated while there are still open iterators (" << num_iterators() << ")");
+
+        {
+            profiler::ScopedTimer prof_unregister { profiler::TXN_COMMIT_UNREGISTER };
+            unregister();
+        }
 
-    TransactionWriteLatch xlock(this);
-    profiler::ScopedTimer prof_cs { profiler::TXN_COMMIT_CRITICAL_SECTION };
-    if(is_terminated()) RAISE_EXCEPTION(LogicalError, "This transaction is already terminated");
-    if(has_iterators()) RAISE_EXCEPTION(LogicalError, "The transaction cannot be terminated while there are still open iterators (" << num_iterators() << ")");
+        // Record the changes to the vertices and their degrees, to keep up to date the cached auxiliary views
+        uint64_t transaction_id = 0;
+        if(aux_cache != nullptr && !is_read_only()){
+            transaction_id = aux_cache->commit(this);
+        } else {
+            transaction_id = m_global_context->next_transaction_id();
+        }
 
-    {
-        profiler::ScopedTimer prof_unregister { profiler::TXN_COMMIT_UNREGISTER };
-        unregister();
-    }
+        // Append the changes to the redo log, before they become visible to the other transactions
+        if(redo_log != nullptr && !is_read_only()){
+            lsn = redo_log->append(this, transaction_id);
+        }
 
-    uint64_t transaction_id = m_global_context->next_transaction_id();
+        // Save the local changes
+        if(m_prop_local){
+            context::ScopedEpoch epoch; // must be inside an epoch
+            context::thread_context()->save_local_changes(m_prop_local, transaction_id);
+        }
 
-    // Save the local changes
-    if(m_prop_local){
-        context::ScopedEpoch epoch; // must be inside an epoch
-        context::thread_context()->save_local_changes(m_prop_local, transaction_id);
+        m_transaction_id = transaction_id;
+        m_state = State::COMMITTED;
     }
 
-    m_transaction_id = transaction_id;
-    m_state = State::COMMITTED;
+    // Group commit, wait for the changes to become durable outside the critical section
+    if(lsn > 0){ redo_log->wait(lsn); }
 }
 
 void TransactionImpl::rollback(){
@@ -215,7 +238,7 @@ void TransactionImpl::do_rollback(uint64_t N) {
 
             UndoBuffer* temp = m_undo_last;
             m_undo_last = m_undo_last->m_next;
-            gc_mark(temp, (void (*)(void*)) UndoBuffer::deallocate); // use the GC to support optimistic readers in the undo history
+            gc_mark(temp, (void (*)(void*)) UndoBuffer::recycle); // use the GC to support optimistic readers in the undo history
         } else {
             Undo* undo = reinterpret_cast<Undo*>(m_undo_last->buffer() + m_undo_last->m_space_left);
             if(undo->is_active()){ // ignore inactive undos
@@ -245,7 +268,20 @@ Undo* TransactionImpl::add_undo(RollbackInterface* data_structure, uint32_t payl
     // first entry in the undo chain
     if(m_undo_last->m_space_left < total_length){
         UndoBuffer* temp = m_undo_last;
-        m_undo_last = UndoBuffer::allocate(max<uint32_t>(total_length, context::StaticConfiguration::transaction_undo_buffer_size));
+
+        // geometric growth, each new buffer doubles the capacity of the previous one
+        uint32_t buffer_sz = context::StaticConfiguration::transaction_undo_buffer_size;
+        if(temp->m_next != nullptr){ // the last buffer is not the one embedded in the transaction
+            buffer_sz = min<uint32_t>(max<uint32_t>(temp->m_space_total, buffer_sz) * 2, context::StaticConfiguration::transaction_undo_buffer_max_size);
+        }
+        buffer_sz = max<uint32_t>(total_length, buffer_sz);
+
+        context::ThreadContext* thread_context = context::thread_context_if_exists();
+        if(LIKELY(thread_context != nullptr)){ // recycle a buffer released by a previous transaction
+            m_undo_last = thread_context->undo_buffer_cache()->acquire_undo_buffer(buffer_sz);
+        } else {
+            m_undo_last = UndoBuffer::allocate(buffer_sz);
+        }
         m_undo_last->m_next = temp;
     }
 
@@ -375,7 +411,7 @@ void TransactionImpl::release_undo_buffers(){
     while(m_undo_last->m_next != nullptr){
         UndoBuffer* next = m_undo_last->m_next;
         // here always use the global GC
-        gc_mark(m_undo_last, (void (*)(void*)) UndoBuffer::deallocate); // use the GC to support optimistic readers in the undo history
+        gc_mark(m_undo_last, (void (*)(void*)) UndoBuffer::recycle); // use the GC to support optimistic readers in the undo history
         m_undo_last = next;
     }
 }
@@ -514,15 +550,43 @@ aux::View* TransactionImpl::aux_ret_ptr(void* aux_view_pointer, bool numa_aware)
     }
 }
 
-bool TransactionImpl::aux_use_for_degree() const noexcept {
+bool TransactionImpl::aux_use_for_degree() const {
     if( !m_global_context->is_aux_degree_enabled() ){
         return false;
     } else if( has_aux_view() ){
         return true;
-    } else {
-        // don't use an atomic on m_aux_degree, we don't need to be precise here as it's a mere optimisation
-        return m_aux_degree++ >= context::StaticConfiguration::aux_degree_threshold;
     }
+
+    // don't use an atomic on m_aux_degree, we don't need to be precise here as it's a mere optimisation
+    uint64_t num_queries = m_aux_degree++;
+    if(num_queries < context::StaticConfiguration::aux_degree_threshold){
+        return false;
+    } else if(num_queries > context::StaticConfiguration::aux_degree_threshold && (num_queries & (num_queries -1)) != 0){
+        return false; // only re-evaluate the cost model when the number of queries doubles
+    }
+
+    // is a view already available in the cache?
+    aux::Cache* cache = m_global_context->aux_cache();
+    bool is_cached = cache != nullptr && (is_read_only() ? cache->has_view(ts_read()) : cache->has_dynamic(ts_read()));
+
+    uint64_t num_elements = 0;
+    if(!is_cached){
+        context::ScopedEpoch epoch; // must be inside an epoch
+        context::GraphProperty properties = graph_properties();
+        num_elements = properties.m_vertex_count + properties.m_edge_count;
+    }
+
+    return m_global_context->aux_cost_model()->use_aux_view(num_queries, m_aux_degree_hint, num_elements, is_cached);
+}
+
+bool TransactionImpl::aux_sample_degree() const noexcept {
+    // sample the first query and then whenever the number of queries doubles
+    uint64_t num_queries = m_aux_degree; // 0 if the aux degree is disabled
+    return num_queries > 0 && (num_queries & (num_queries -1)) == 0;
+}
+
+void TransactionImpl::aux_degree_hint(uint64_t num_queries) noexcept {
+    m_aux_degree_hint = num_queries;
 }
 
 uint64_t TransactionImpl::aux_degree(uint64_t vertex_id, bool logical) const {
@@ -22,6 +22,8 @@
 #include <cstring>
 #include <emmintrin.h>
 #include <iostream>
+#include <limits>
+#include <new>
 
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/thread_context.hpp"
@@ -35,73 +37,161 @@ using namespace std;
 
 namespace teseo::transaction {
 
-TransactionList::TransactionList() {
-    memset(m_transactions, '\0', sizeof(m_transactions));
+TransactionList::TransactionList() : m_tail(&m_head), m_high_water_mark(numeric_limits<uint64_t>::max()) {
+    memset(&m_head, '\0', sizeof(m_head));
 }
 
 TransactionList::~TransactionList() {
-
+    Segment* segment = m_head.m_next;
+    while(segment != nullptr){
+        Segment* next = segment->m_next;
+        delete segment;
+        segment = next;
+    }
+    m_head.m_next = nullptr;
+    m_tail = nullptr;
 }
 
 uint64_t TransactionList::insert(context::GlobalContext* gcntxt, TransactionImpl* transaction) {
     bool success = false;
     uint64_t transaction_id { 0 };
 
-    uint64_t value = m_version ++ ;// lock
-    assert(m_version % 2 == 1 && "Odd value => locked");
-    assert(value % 2 == 0 && "Expected the even value before the lock was taken");
+    writer_lock();
 
+    // search for a free slot among those already used
+    TransactionImpl** cell = nullptr;
+    Segment* segment = &m_head;
     uint64_t slot_id = 0;
-    while(slot_id < m_transactions_sz && !success){
-        success = (m_transactions[slot_id] == nullptr);
-        slot_id += (!success);
+    while(slot_id < m_transactions_sz && cell == nullptr){
+        uint64_t offset = slot_id % m_segment_capacity;
+        if(segment->m_transactions[offset] == nullptr){
+            cell = segment->m_transactions + offset;
+        } else {
+            slot_id++;
+            if(slot_id % m_segment_capacity == 0){ segment = segment->m_next; }
+        }
     }
 
-    if(!success && m_transactions_sz < m_transactions_capacity){
-        slot_id = m_transactions_sz;
-        m_transactions_sz++;
-        success = true;
+    // append a new slot at the end of the list
+    if(cell == nullptr){
+        if(m_transactions_sz == m_transactions_capacity){ // all segments are full, append a new one
+            Segment* segment = new (nothrow) Segment();
+            if(segment != nullptr){
+                m_tail->m_next = segment;
+                m_tail = segment;
+                m_transactions_capacity += m_segment_capacity;
+            }
+        }
+
+        if(m_transactions_sz < m_transactions_capacity){
+            cell = m_tail->m_transactions + (m_transactions_sz % m_segment_capacity);
+            m_transactions_sz++;
+        }
     }
 
+    success = (cell != nullptr);
     if(success){
         // we have to assign here the transaction ID, to avoid a potential data race, if done before:
         // Thread #1 starts a new transaction and creates a new transaction ID, e.g. 7
         // Thread #2 executes #active_transactions() and read the next transaction ID: 8
         // If Thread #2 completes the invocation before Thread #1 it will think that the high water mark is 8, rather than 7
-        m_transactions[slot_id] = transaction;
+        *cell = transaction;
+
+        // transaction IDs are always increasing, the min only changes when the list was empty. In this case, we also
+        // need to publish a lower bound for the min before the transaction ID is drawn, for the same reason above
+        bool was_empty = (m_high_water_mark == numeric_limits<uint64_t>::max());
+        if(was_empty){ m_high_water_mark = 0; }
+
         transaction_id = gcntxt->next_transaction_id();
         if(!transaction->is_read_only()){
             m_highest_writer_id = max((uint64_t) m_highest_writer_id, transaction_id);
         }
+
+        if(was_empty){ m_high_water_mark = transaction_id; }
     }
 
-    m_version = value +2; // unlock
+    writer_unlock();
 
-    if(!success){ RAISE(LogicalError, "There are too many active transactions in this thread"); }
+    if(!success){ throw std::bad_alloc{}; } // failed to allocate a new segment
 
     return transaction_id;
 }
 
 bool TransactionList::remove(TransactionImpl* transaction){
     assert(transaction != nullptr && "Null pointer");
+    bool found = false;
+
+    writer_lock();
+
+    uint64_t num_active_transactions = m_transactions_sz;
+    Segment* segment = &m_head;
+    uint64_t base = 0;
+    while(segment != nullptr && base < num_active_transactions && !found){
+        uint64_t end = std::min(num_active_transactions - base, m_segment_capacity);
+        for(uint64_t i = 0; i < end && !found; i++){
+            if(segment->m_transactions[i] == transaction){
+                segment->m_transactions[i] = nullptr;
+                found = true;
+            }
+        }
 
-    int64_t num_active_transactions = m_transactions_sz;
-    int64_t i = 0;
-    while(i < num_active_transactions && m_transactions[i] != transaction){ i ++; }
-    bool found = !(i == num_active_transactions);
+        base += m_segment_capacity;
+        segment = segment->m_next;
+    }
 
-    if(found){
-        m_transactions[i] = nullptr;
+    // we removed the oldest transaction in the list
+    if(found && transaction->ts_read() == m_high_water_mark){
+        recompute_high_water_mark();
     }
 
+    writer_unlock();
+
     return found;
 }
 
+void TransactionList::recompute_high_water_mark(){
+    assert(m_version % 2 == 1 && "The latch must have been acquired in exclusive mode");
+
+    uint64_t minimum = numeric_limits<uint64_t>::max();
+    uint64_t num_active_transactions = m_transactions_sz;
+    const Segment* segment = &m_head;
+    uint64_t base = 0;
+    while(base < num_active_transactions){
+        uint64_t end = std::min(num_active_transactions - base, m_segment_capacity);
+        for(uint64_t i = 0; i < end; i++){
+            TransactionImpl* tx = segment->m_transactions[i];
+            if(tx != nullptr && tx->ts_read() < minimum){
+                minimum = tx->ts_read();
+            }
+        }
+
+        base += m_segment_capacity;
+        segment = segment->m_next;
+    }
+
+    m_high_water_mark = minimum;
+}
+
+void TransactionList::writer_lock(){
+    uint64_t version = m_version;
+    while(version % 2 == 1 || !m_version.compare_exchange_weak(version, version +1)){
+        _mm_pause();
+        version = m_version;
+    }
+    assert(m_version % 2 == 1 && "Odd value => locked");
+}
+
+void TransactionList::writer_unlock(){
+    assert(m_version % 2 == 1 && "Odd value => locked");
+    m_version++;
+}
+
 TransactionSequence TransactionList::snapshot(uint64_t max_transaction_id) const {
     assert(context::thread_context()->epoch() != numeric_limits<uint64_t>::max() &&
             "Need to be inside an epoch, the transaction read could have been released to the GC");
 
-    TransactionSequence seq ( m_transactions_capacity );
+    TransactionSequence seq;
+    uint64_t seq_capacity = 0;
     uint64_t version0 {0}, version1 {0};
 
     do {
@@ -109,13 +199,26 @@ TransactionSequence TransactionList::snapshot(uint64_t max_transaction_id) const
         version0 = m_version;
         while(version0 % 2 == 1){ _mm_pause(); version0 = m_version; }
 
-        int64_t num_active_transactions = m_transactions_sz;
-        int64_t size = 0;
-        for(int64_t i = 0; i < num_active_transactions; i++){
-            TransactionImpl* tx = m_transactions[i];
-            if(tx != nullptr && tx->ts_read() < max_transaction_id){
-                seq.m_transaction_ids[size++] = tx->ts_read();
+        uint64_t num_active_transactions = m_transactions_sz;
+        if(num_active_transactions > seq_capacity){
+            seq_capacity = std::max(num_active_transactions, m_segment_capacity);
+            seq = TransactionSequence{ seq_capacity };
+        }
+
+        uint64_t size = 0;
+        const Segment* segment = &m_head;
+        uint64_t base = 0;
+        while(segment != nullptr && base < num_active_transactions){ // segment == nullptr => a writer is appending a new segment
+            uint64_t end = std::min(num_active_transactions - base, m_segment_capacity);
+            for(uint64_t i = 0; i < end; i++){
+                TransactionImpl* tx = segment->m_transactions[i];
+                if(tx != nullptr && tx->ts_read() < max_transaction_id){
+                    seq.m_transaction_ids[size++] = tx->ts_read();
+                }
             }
+
+            base += m_segment_capacity;
+            segment = segment->m_next;
         }
         seq.m_num_transactions = size;
 
@@ -129,30 +232,7 @@ TransactionSequence TransactionList::snapshot(uint64_t max_transaction_id) const
 }
 
 uint64_t TransactionList::high_water_mark() const {
-    assert(context::thread_context()->epoch() != numeric_limits<uint64_t>::max() &&
-            "Need to be inside an epoch, the transaction read could have been released to the GC");
-
-    uint64_t version0 {0}, version1 {0}, minimum {0};
-
-    do {
-        minimum = numeric_limits<uint64_t>::max();
-
-        // lock (reader)
-        version0 = m_version;
-        while(version0 % 2 == 1){ _mm_pause(); version0 = m_version; }
-
-        int num_active_transactions = m_transactions_sz;
-        for(int i = 0; i < num_active_transactions; i++){
-            if(m_transactions[i] != nullptr && m_transactions[i]->ts_read() < minimum){
-                minimum = m_transactions[i]->ts_read();
-            }
-        }
-
-        // unlock (reader)
-        version1 = m_version;
-    } while(version0 != version1);
-
-    return minimum;
+    return m_high_water_mark;
 }
 
 uint64_t TransactionList::highest_txn_rw_id() const {
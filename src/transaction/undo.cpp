@@ -56,6 +56,10 @@ Undo::Undo(TransactionImpl* tx, RollbackInterface* data_structure, uint32_t leng
 TransactionImpl* Undo::transaction() { return m_transaction; }
 const TransactionImpl* Undo::transaction() const { return m_transaction; }
 
+const RollbackInterface* Undo::data_structure() const {
+    return m_data_structure;
+}
+
 uint64_t Undo::transaction_id() const {
     return m_transaction->ts_write();
 }
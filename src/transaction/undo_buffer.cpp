@@ -20,6 +20,8 @@
 #include <cstdlib>
 #include <stdexcept>
 
+#include "teseo/transaction/memory_pool_list.hpp"
+
 using namespace std;
 
 namespace teseo::transaction {
@@ -37,6 +39,16 @@ void UndoBuffer::deallocate(UndoBuffer* undobuffer){
     }
 }
 
+void UndoBuffer::recycle(UndoBuffer* undobuffer){
+    if(undobuffer == nullptr) return;
+
+    if(undobuffer->m_cache != nullptr){
+        undobuffer->m_cache->release_undo_buffer(undobuffer);
+    } else {
+        deallocate(undobuffer);
+    }
+}
+
 
 } // namespace
 
@@ -18,6 +18,9 @@
 
 #include <cerrno>
 #include <cstring>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 #include <unistd.h>
 
 #include "teseo/util/error.hpp"
@@ -47,5 +50,11 @@ string System::hostname(){
     return hostname;
 }
 
+void System::release_memory(){
+#if defined(__GLIBC__)
+    malloc_trim(0); // the arenas only release the memory at their top, unless explicitly trimmed
+#endif
+}
+
 
 } // namespace
@@ -57,6 +57,27 @@ int Thread::get_numa_id(){
 #endif
 }
 
+vector<int> Thread::get_affinity(){
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    int rc = pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if(rc != 0){ RAISE_EXCEPTION(InternalError, "[Thread::get_affinity] pthread_getaffinity_np error: " << strerror(rc) << " (" << rc << ")"); }
+
+    vector<int> result;
+    for(int i = 0; i < CPU_SETSIZE; i++){
+        if(CPU_ISSET(i, &cpu_set)){ result.push_back(i); }
+    }
+    return result;
+}
+
+void Thread::set_affinity(int cpu_id){
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu_id, &cpu_set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if(rc != 0){ RAISE_EXCEPTION(InternalError, "[Thread::set_affinity] pthread_setaffinity_np error: " << strerror(rc) << " (" << rc << "), cpu_id: " << cpu_id); }
+}
+
 int64_t Thread::get_process_id(){
     return getpid(); // unistd.h
 }
@@ -17,14 +17,18 @@
 
 #include "catch.hpp"
 
+#include <atomic>
 #include <condition_variable>
 #include <iostream>
+#include <map>
 #include <mutex>
 #include <thread>
 #include <unordered_set>
 #include <vector>
 
 #include "teseo/aux/builder.hpp"
+#include "teseo/aux/cache.hpp"
+#include "teseo/aux/change.hpp"
 #include "teseo/aux/counting_tree.hpp"
 #include "teseo/aux/item.hpp"
 #include "teseo/aux/partial_result.hpp"
@@ -40,6 +44,7 @@
 #include "teseo/memstore/segment.hpp"
 #include "teseo/runtime/runtime.hpp"
 #include "teseo/transaction/transaction_impl.hpp"
+#include "teseo/util/numa.hpp"
 #include "teseo/util/permutation.hpp"
 #include "teseo.hpp"
 
@@ -119,7 +124,6 @@ TEST_CASE("aux_builder_empty2", "[aux]") {
     REQUIRE(dv != nullptr);
 
     auto view = StaticView::create_undirected(0, dv);
-    REQUIRE(view->degree_vector() == dv);
     REQUIRE(view->logical_id(0) == aux::NOT_FOUND);
     REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
     REQUIRE(view->vertex_id(0) == aux::NOT_FOUND);
@@ -160,7 +164,6 @@ TEST_CASE("aux_builder_sparse_file1", "[aux]") {
     REQUIRE(dv != nullptr);
 
     auto view = StaticView::create_undirected(tx0.num_vertices(), dv);
-    REQUIRE(view->degree_vector() == dv);
     REQUIRE(view->num_vertices() == tx0.num_vertices());
 
     // vertex IDs
@@ -244,7 +247,6 @@ TEST_CASE("aux_builder_sparse_file2", "[aux]") {
         auto dv = builder.create_dv_undirected(tx.num_vertices());
         view = StaticView::create_undirected(tx.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
     }
 
     // vertex IDs
@@ -313,7 +315,6 @@ TEST_CASE("aux_builder_sparse_file3", "[aux]") {
         auto dv = builder.create_dv_undirected(tx.num_vertices());
         view = StaticView::create_undirected(tx.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
     }
 
     // vertex IDs
@@ -382,7 +383,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx1.num_vertices());
         auto view = StaticView::create_undirected(tx1.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx1.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(21) == aux::NOT_FOUND);
@@ -414,7 +414,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx1.num_vertices());
         auto view = StaticView::create_undirected(tx1.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx1.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(21) == aux::NOT_FOUND);
@@ -443,7 +442,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx2.num_vertices());
         auto view = StaticView::create_undirected(tx2.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx2.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(21) == aux::NOT_FOUND);
@@ -474,7 +472,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx3.num_vertices());
         auto view = StaticView::create_undirected(tx3.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx3.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == 0);
         REQUIRE(view->logical_id(21) == 1);
@@ -504,7 +501,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx1.num_vertices());
         auto view = StaticView::create_undirected(tx1.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx1.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(21) == aux::NOT_FOUND);
@@ -529,7 +525,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx2.num_vertices());
         auto view = StaticView::create_undirected(tx2.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx2.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(21) == aux::NOT_FOUND);
@@ -554,7 +549,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx3.num_vertices());
         auto view = StaticView::create_undirected(tx3.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx3.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == 0);
         REQUIRE(view->logical_id(21) == 1);
@@ -585,7 +579,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx4.num_vertices());
         auto view = StaticView::create_undirected(tx4.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx4.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == 0);
         REQUIRE(view->logical_id(21) == 1);
@@ -613,7 +606,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx1.num_vertices());
         auto view = StaticView::create_undirected(tx1.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx1.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(21) == aux::NOT_FOUND);
@@ -638,7 +630,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx2.num_vertices());
         auto view = StaticView::create_undirected(tx2.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx2.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(21) == aux::NOT_FOUND);
@@ -663,7 +654,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx3.num_vertices());
         auto view = StaticView::create_undirected(tx3.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx3.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == 0);
         REQUIRE(view->logical_id(21) == 1);
@@ -688,7 +678,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx4.num_vertices());
         auto view = StaticView::create_undirected(tx4.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx4.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == 0);
         REQUIRE(view->logical_id(21) == 1);
@@ -718,7 +707,6 @@ TEST_CASE("aux_builder_dense_file", "[aux]") {
         auto dv = builder.create_dv_undirected(tx5.num_vertices());
         auto view = StaticView::create_undirected(tx5.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx5.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
         REQUIRE(view->logical_id(1) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(11) == aux::NOT_FOUND);
         REQUIRE(view->logical_id(21) == 0);
@@ -793,7 +781,6 @@ TEST_CASE("aux_builder_multiple_intermediates1", "[aux]") {
         auto dv = builder.create_dv_undirected(tx.num_vertices());
         view = StaticView::create_undirected(tx.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
     }
 
     // vertex IDs
@@ -889,7 +876,6 @@ TEST_CASE("aux_builder_multiple_intermediates2", "[aux]") {
         auto dv = builder.create_dv_undirected(tx.num_vertices());
         view = StaticView::create_undirected(tx.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
     }
 
     // vertex IDs
@@ -1000,7 +986,6 @@ TEST_CASE("aux_builder_multiple_intermediates3", "[aux]") {
         auto dv = builder.create_dv_undirected(tx.num_vertices());
         view = StaticView::create_undirected(tx.num_vertices(), dv);
         REQUIRE(view->num_vertices() == tx.num_vertices());
-        REQUIRE(view->degree_vector() == dv);
     }
 
     // vertex IDs
@@ -1386,7 +1371,7 @@ TEST_CASE("aux_cache", "[aux]"){
     auto view2 = tx2_impl->aux_view();
     REQUIRE(view2 == view1); // cached view
     auto view0 = tx0_impl->aux_view();
-    REQUIRE(view0 != view1); // it needs to be recomputed because tx0 < tx1
+    REQUIRE(view0 == view1); // tx0 < tx1, but no changes were committed in between
 
     auto tx3 = teseo.start_transaction(/* read only ? */ true);
     auto tx3_impl = reinterpret_cast<transaction::TransactionImpl*>(tx3.handle_impl());
@@ -1398,7 +1383,184 @@ TEST_CASE("aux_cache", "[aux]"){
     auto tx4 = teseo.start_transaction(/* read only ? */ true);
     auto tx4_impl = reinterpret_cast<transaction::TransactionImpl*>(tx4.handle_impl());
     auto view4 = tx4_impl->aux_view();
-    REQUIRE(view4 != view1); // unsafe to use tx1's view. Well, we could have waited for tx_rw to commit first in truth.
+    REQUIRE(view4 == view1); // tx_rw has not committed any change yet
+
+    tx_rw.insert_vertex(10);
+    tx_rw.commit();
+
+    auto tx5 = teseo.start_transaction(/* read only ? */ true);
+    auto tx5_impl = reinterpret_cast<transaction::TransactionImpl*>(tx5.handle_impl());
+    auto view5 = tx5_impl->aux_view();
+    REQUIRE(view5 != view1); // derived from the cached view with the changes of tx_rw
+    REQUIRE(view5->num_vertices() == 1);
+    REQUIRE(view5->logical_id(11) == 0); // 10 + 1 => 11 due to E2I
+}
+
+/**
+ * Retain the views for multiple snapshots, so that older read-only transactions can reuse them
+ */
+TEST_CASE("aux_cache_multiversion", "[aux]"){
+    Teseo teseo;
+    context::global_context()->enable_aux_cache();
+    aux::Cache* cache = context::global_context()->aux_cache();
+
+    auto tx = teseo.start_transaction();
+    tx.insert_vertex(10);
+    tx.commit();
+
+    auto tx0 = teseo.start_transaction(/* read only ? */ true);
+    auto view0 = reinterpret_cast<transaction::TransactionImpl*>(tx0.handle_impl())->aux_view(); // start recording the changes
+    REQUIRE(view0->num_vertices() == 1);
+
+    tx = teseo.start_transaction();
+    tx.insert_vertex(20);
+    tx.commit();
+
+    // long running readers, sharing the same snapshot
+    auto tx_old1 = teseo.start_transaction(/* read only ? */ true);
+    auto tx_old2 = teseo.start_transaction(/* read only ? */ true);
+
+    tx = teseo.start_transaction();
+    tx.insert_vertex(30);
+    tx.commit();
+
+    auto tx_new = teseo.start_transaction(/* read only ? */ true);
+    auto view_new = reinterpret_cast<transaction::TransactionImpl*>(tx_new.handle_impl())->aux_view();
+    REQUIRE(view_new->num_vertices() == 3);
+
+    auto view_old1 = reinterpret_cast<transaction::TransactionImpl*>(tx_old1.handle_impl())->aux_view();
+    REQUIRE(view_old1->num_vertices() == 2);
+    REQUIRE(view_old1 != view_new);
+    REQUIRE(cache->num_versions() >= 2);
+
+    auto view_old2 = reinterpret_cast<transaction::TransactionImpl*>(tx_old2.handle_impl())->aux_view();
+    REQUIRE(view_old2 == view_old1); // same snapshot
+
+    // the latest view is still available
+    auto tx_new2 = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(reinterpret_cast<transaction::TransactionImpl*>(tx_new2.handle_impl())->aux_view() == view_new);
+
+    // with no memory budget, only the views of the most recent snapshot are retained
+    context::global_context()->set_aux_cache_memory_budget(0);
+    auto tx_old3 = teseo.start_transaction(/* read only ? */ true); // after tx_new, same snapshot
+    tx = teseo.start_transaction();
+    tx.insert_vertex(40);
+    tx.commit();
+    auto tx_new3 = teseo.start_transaction(/* read only ? */ true);
+    auto view_new3 = reinterpret_cast<transaction::TransactionImpl*>(tx_new3.handle_impl())->aux_view();
+    REQUIRE(view_new3->num_vertices() == 4);
+    REQUIRE(cache->num_versions() == 1);
+    auto view_old3 = reinterpret_cast<transaction::TransactionImpl*>(tx_old3.handle_impl())->aux_view();
+    REQUIRE(view_old3->num_vertices() == 3);
+    REQUIRE(cache->num_versions() == 1);
+
+    context::global_context()->set_aux_cache_memory_budget(context::StaticConfiguration::aux_cache_memory_budget);
+}
+
+/**
+ * Multiple read-only transactions retrieving their views from the cache, while a writer keeps inserting vertices
+ */
+TEST_CASE("aux_cache_concurrent", "[aux]"){
+    Teseo teseo;
+    context::global_context()->enable_aux_cache();
+    constexpr uint64_t num_readers = 8;
+    constexpr uint64_t num_iterations = 200;
+    atomic<bool> writer_done = false;
+
+    thread writer([&](){
+        teseo.register_thread();
+        for(uint64_t vertex_id = 10; vertex_id <= num_iterations * 10; vertex_id += 10){
+            auto tx = teseo.start_transaction();
+            tx.insert_vertex(vertex_id);
+            if(vertex_id > 10){ tx.insert_edge(10, vertex_id, vertex_id); }
+            tx.commit();
+        }
+        writer_done = true;
+        teseo.unregister_thread();
+    });
+
+    vector<thread> readers;
+    for(uint64_t i = 0; i < num_readers; i++){
+        readers.emplace_back([&](){
+            teseo.register_thread();
+            uint64_t num_rounds = 0;
+            while(!writer_done || num_rounds < num_iterations){
+                auto tx = teseo.start_transaction(/* read only ? */ true);
+                auto tx_impl = reinterpret_cast<transaction::TransactionImpl*>(tx.handle_impl());
+                auto view = tx_impl->aux_view();
+
+                // the vertices are inserted in order, the snapshot consists of the vertices 10, 20, ..., num_vertices * 10
+                uint64_t num_vertices = view->num_vertices();
+                REQUIRE((num_vertices == 0 || tx.has_vertex(num_vertices * 10)));
+                REQUIRE(!tx.has_vertex((num_vertices +1) * 10));
+                for(uint64_t logical_id = 0; logical_id < num_vertices; logical_id++){
+                    REQUIRE(view->vertex_id(logical_id) == (logical_id +1) * 10 +1); // 10 -> 11 due to E2I
+                    REQUIRE(view->logical_id(view->vertex_id(logical_id)) == logical_id);
+                }
+                if(num_vertices > 0){
+                    REQUIRE(view->degree(0, true) == num_vertices -1);
+                }
+
+                tx.commit();
+                num_rounds++;
+            }
+            teseo.unregister_thread();
+        });
+    }
+
+    writer.join();
+    for(auto& t: readers) t.join();
+}
+
+/**
+ * The auxiliary view should be built to answer the queries on the degree only when the cost model deems it convenient
+ */
+TEST_CASE("aux_degree_cost_model", "[aux]"){
+    Teseo teseo;
+    context::global_context()->enable_aux_degree();
+    const uint64_t num_vertices = 10000;
+    const uint64_t threshold = context::StaticConfiguration::aux_degree_threshold;
+
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 1; vertex_id <= num_vertices; vertex_id++){
+        tx.insert_vertex(vertex_id * 10);
+        if(vertex_id > 1){ tx.insert_edge((vertex_id -1) * 10, vertex_id * 10, vertex_id); }
+    }
+    tx.commit();
+
+    // a few queries do not pay off the construction of the view
+    tx = teseo.start_transaction(/* read only ? */ true);
+    auto tx_impl = reinterpret_cast<transaction::TransactionImpl*>(tx.handle_impl());
+    for(uint64_t i = 1; i <= 2 * threshold; i++){
+        REQUIRE(tx.degree(i * 10) == (i == 1 ? 1 : 2));
+    }
+    REQUIRE(tx_impl->has_aux_view() == false);
+    tx.commit();
+
+    // the user expects to query the degree of all vertices
+    tx = teseo.start_transaction(/* read only ? */ true);
+    tx.hint_degree_queries(num_vertices);
+    tx_impl = reinterpret_cast<transaction::TransactionImpl*>(tx.handle_impl());
+    for(uint64_t i = 1; i <= threshold; i++){
+        REQUIRE(tx.degree(i * 10) == (i == 1 ? 1 : 2));
+    }
+    REQUIRE(tx_impl->has_aux_view() == false);
+    REQUIRE(tx.degree(num_vertices * 10) == 1);
+    REQUIRE(tx_impl->has_aux_view() == true);
+    tx.commit();
+
+    // the view is now available in the cache
+    if(context::global_context()->is_aux_cache_enabled()){
+        tx = teseo.start_transaction(/* read only ? */ true);
+        tx_impl = reinterpret_cast<transaction::TransactionImpl*>(tx.handle_impl());
+        for(uint64_t i = 1; i <= threshold; i++){
+            REQUIRE(tx.degree(i * 10) == (i == 1 ? 1 : 2));
+        }
+        REQUIRE(tx_impl->has_aux_view() == false);
+        REQUIRE(tx.degree(num_vertices * 10) == 1);
+        REQUIRE(tx_impl->has_aux_view() == true);
+        tx.commit();
+    }
 }
 
 /**
@@ -1533,6 +1695,81 @@ TEST_CASE("aux_vertex_id", "[aux]"){
     REQUIRE_THROWS_WITH(tx.vertex_id(tx.num_vertices()), Catch::Contains("Invalid logical vertex identifier"));
 }
 
+/**
+ * Derive the new views from the cached view and the changes committed in the meanwhile
+ */
+TEST_CASE("aux_cache_incremental", "[aux]"){
+    Teseo teseo;
+    context::global_context()->enable_aux_degree();
+    REQUIRE(context::global_context()->is_aux_cache_enabled());
+
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 10; vertex_id <= 100; vertex_id += 10){
+        tx.insert_vertex(vertex_id);
+    }
+    tx.insert_edge(10, 20, 1020);
+    tx.insert_edge(10, 30, 1030);
+    tx.commit();
+
+    auto tx_ro = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx_ro.logical_id(30) == 2);
+    REQUIRE(tx_ro.degree(0, true) == 2);
+    tx_ro.commit();
+
+    // only the degrees change
+    tx = teseo.start_transaction();
+    tx.insert_edge(20, 30, 2030);
+    tx.insert_edge(40, 50, 4050);
+    tx.remove_edge(10, 20);
+    tx.commit();
+    auto tx_old = teseo.start_transaction(/* read only ? */ true);
+
+    tx_ro = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx_ro.num_vertices() == 10);
+    REQUIRE(tx_ro.degree(10, false) == 1);
+    REQUIRE(tx_ro.degree(20, false) == 1);
+    REQUIRE(tx_ro.degree(30, false) == 2);
+    REQUIRE(tx_ro.degree(40, false) == 1);
+    REQUIRE(tx_ro.degree(50, false) == 1);
+    REQUIRE(tx_ro.logical_id(30) == 2);
+    tx_ro.commit();
+
+    // insert & remove vertices, the logical IDs shift
+    tx = teseo.start_transaction();
+    tx.insert_vertex(55);
+    tx.insert_edge(55, 10, 5510);
+    REQUIRE(tx.remove_vertex(30) == 2);
+    tx.insert_vertex(200);
+    tx.remove_vertex(200);
+    tx.commit();
+    tx = teseo.start_transaction();
+    tx.insert_vertex(5);
+    tx.rollback();
+
+    tx_ro = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx_ro.num_vertices() == 10);
+    for(uint64_t vertex_id : { 10, 20, 40, 50, 55, 60, 70, 80, 90, 100 }){
+        REQUIRE(tx_ro.vertex_id(tx_ro.logical_id(vertex_id)) == vertex_id);
+    }
+    REQUIRE(tx_ro.logical_id(10) == 0);
+    REQUIRE(tx_ro.logical_id(55) == 4);
+    REQUIRE(tx_ro.logical_id(100) == 9);
+    REQUIRE_THROWS_WITH(tx_ro.logical_id(30), Catch::Contains("does not exist"));
+    REQUIRE_THROWS_WITH(tx_ro.logical_id(200), Catch::Contains("does not exist"));
+    REQUIRE_THROWS_WITH(tx_ro.logical_id(5), Catch::Contains("does not exist"));
+    REQUIRE(tx_ro.degree(10, false) == 1);
+    REQUIRE(tx_ro.degree(20, false) == 0);
+    REQUIRE(tx_ro.degree(55, false) == 1);
+    tx_ro.commit();
+
+    // a transaction older than the cached view
+    REQUIRE(tx_old.num_vertices() == 10);
+    REQUIRE(tx_old.logical_id(30) == 2);
+    REQUIRE(tx_old.degree(30, false) == 2);
+    REQUIRE_THROWS_WITH(tx_old.logical_id(55), Catch::Contains("does not exist"));
+    tx_old.commit();
+}
+
 /**
  * Validate a scan with the iterator
  */
@@ -2186,3 +2423,217 @@ TEST_CASE("aux_dynamic_view3", "[aux]"){
 //    // done ...
 //}
 
+
+/**
+ * Build the dictionary of a static view in parallel, with both a hash table and a direct table
+ */
+TEST_CASE("aux_static_parallel_hashmap", "[aux]"){
+    Teseo teseo;
+    const uint64_t num_vertices = context::StaticConfiguration::aux_hashmap_partition_size * 16 +1;
+
+    for(uint64_t stride : { 1, 2, 1000 }){ // stride 1 => implicit mapping, 2 => direct table, 1000 => hash table
+        ItemUndirected* dv = (ItemUndirected*) util::NUMA::malloc(num_vertices * sizeof(ItemUndirected));
+        for(uint64_t i = 0; i < num_vertices; i++){
+            dv[i].m_vertex_id = (i +1) * stride;
+            dv[i].m_degree = i;
+        }
+
+        auto view = StaticView::create_undirected(num_vertices, dv);
+        REQUIRE(view->num_vertices() == num_vertices);
+        for(uint64_t i = 0; i < num_vertices; i++){
+            REQUIRE(view->logical_id((i +1) * stride) == i);
+            REQUIRE(view->degree((i +1) * stride, false) == i);
+        }
+        REQUIRE(view->logical_id(0) == aux::NOT_FOUND);
+        REQUIRE(view->logical_id((num_vertices +1) * stride) == aux::NOT_FOUND);
+
+        view->decr_ref_count(); // delete the view
+    }
+}
+
+/**
+ * Degrees that do not fit in 32 bits are moved to the overflow table, contiguous vertex IDs do not require a dictionary
+ */
+TEST_CASE("aux_static_compact", "[aux]"){
+    Teseo teseo;
+    const uint64_t num_vertices = 1000;
+    const uint64_t big_degree = (1ull << 32);
+
+    for(uint64_t stride : { 1, 2, 1000 }){ // stride 1 => implicit mapping, 2 => direct table, 1000 => hash table
+        ItemUndirected* dv = (ItemUndirected*) util::NUMA::malloc(num_vertices * sizeof(ItemUndirected));
+        for(uint64_t i = 0; i < num_vertices; i++){
+            dv[i].m_vertex_id = (i +1) * stride;
+            dv[i].m_degree = (i % 100 == 0) ? big_degree + i : i;
+        }
+
+        auto view = StaticView::create_undirected(num_vertices, dv);
+        REQUIRE(view->num_vertices() == num_vertices);
+        REQUIRE(view->is_implicit() == (stride == 1));
+        REQUIRE(view->num_overflow() == num_vertices / 100);
+        REQUIRE(view->memory_footprint() < num_vertices * sizeof(ItemUndirected) * (stride == 1 ? 1 : 2));
+        for(uint64_t i = 0; i < num_vertices; i++){
+            uint64_t expected_degree = (i % 100 == 0) ? big_degree + i : i;
+            REQUIRE(view->logical_id((i +1) * stride) == i);
+            REQUIRE(view->vertex_id(i) == (i +1) * stride);
+            REQUIRE(view->degree(i, true) == expected_degree);
+            REQUIRE(view->degree((i +1) * stride, false) == expected_degree);
+        }
+        REQUIRE(view->logical_id(0) == aux::NOT_FOUND);
+        REQUIRE(view->logical_id((num_vertices +1) * stride) == aux::NOT_FOUND);
+        REQUIRE(view->vertex_id(num_vertices) == aux::NOT_FOUND);
+
+        // derive a new view with the same logical IDs, the degree of the logical ID 0 falls on the boundary of the overflow table
+        StaticView* derived1 = nullptr;
+        StaticView::create_undirected(view, vector<Change>{ Change{ 0, stride, Change::DECR_DEGREE }, Change{ 0, 2 * stride, Change::INCR_DEGREE } }, &derived1, 1);
+        REQUIRE(derived1->num_vertices() == num_vertices);
+        REQUIRE(derived1->num_overflow() == num_vertices / 100);
+        REQUIRE(derived1->degree(stride, false) == big_degree -1);
+        REQUIRE(derived1->degree(2 * stride, false) == 2);
+
+        // derive a new view inserting a vertex, the degree of the logical ID 0 moves back to the 32-bit column
+        StaticView* derived2 = nullptr;
+        StaticView::create_undirected(derived1, vector<Change>{ Change{ 0, stride, Change::DECR_DEGREE }, Change{ 0, (num_vertices +1) * stride, Change::INSERT_VERTEX } }, &derived2, 1);
+        REQUIRE(derived2->num_vertices() == num_vertices +1);
+        REQUIRE(derived2->is_implicit() == (stride == 1));
+        REQUIRE(derived2->num_overflow() == num_vertices / 100 -1);
+        REQUIRE(derived2->degree(stride, false) == big_degree -2);
+        REQUIRE(derived2->degree(2 * stride, false) == 2);
+        REQUIRE(derived2->degree(101 * stride, false) == big_degree + 100);
+        REQUIRE(derived2->degree((num_vertices +1) * stride, false) == 0);
+        REQUIRE(derived2->logical_id((num_vertices +1) * stride) == num_vertices);
+
+        derived2->decr_ref_count();
+        derived1->decr_ref_count();
+        view->decr_ref_count(); // delete the view
+    }
+}
+
+/**
+ * Assign the logical IDs of the static views by decreasing degree
+ */
+TEST_CASE("aux_ordering_degree", "[aux]"){
+    Teseo teseo;
+    context::global_context()->set_aux_ordering(Ordering::DEGREE_DESC);
+    const uint64_t num_vertices = 100;
+
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 1; vertex_id <= num_vertices; vertex_id++){
+        tx.insert_vertex(vertex_id * 10);
+        for(uint64_t dst = 1; dst < vertex_id && dst <= (vertex_id % 7); dst++){
+            tx.insert_edge(vertex_id * 10, dst * 10, 1);
+        }
+    }
+    tx.commit();
+
+    auto check = [&](){
+        auto tx = teseo.start_transaction(/* read only ? */ true);
+        REQUIRE(tx.num_vertices() == num_vertices);
+        uint64_t prev_degree = numeric_limits<uint64_t>::max();
+        uint64_t prev_vertex_id = 0;
+        for(uint64_t logical_id = 0; logical_id < num_vertices; logical_id++){
+            uint64_t vertex_id = tx.vertex_id(logical_id);
+            REQUIRE(tx.logical_id(vertex_id) == logical_id);
+            uint64_t degree = tx.degree(logical_id, /* logical ? */ true);
+            REQUIRE(degree == tx.degree(vertex_id));
+            REQUIRE(degree <= prev_degree);
+            if(degree == prev_degree){ REQUIRE(vertex_id > prev_vertex_id); }
+            prev_degree = degree;
+            prev_vertex_id = vertex_id;
+        }
+    };
+    check();
+
+    // a vertex becomes the one with the highest degree, the view is derived from the cached one
+    tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 2; vertex_id <= num_vertices; vertex_id++){
+        if(!tx.has_edge(10, vertex_id * 10)){ tx.insert_edge(10, vertex_id * 10, 1); }
+    }
+    tx.commit();
+    check();
+    tx = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx.logical_id(10) == 0);
+    REQUIRE(tx.vertex_id(0) == 10);
+    REQUIRE(tx.degree(0, /* logical ? */ true) == num_vertices -1);
+    tx.commit();
+
+    // remove a vertex
+    tx = teseo.start_transaction();
+    tx.remove_vertex(10);
+    tx.commit();
+    tx = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx.num_vertices() == num_vertices -1);
+    REQUIRE(tx.degree(tx.vertex_id(0)) >= tx.degree(tx.vertex_id(num_vertices -2)));
+    tx.commit();
+}
+
+/**
+ * The dynamic views of the read-write transactions are backed by the counting tree shared in the aux cache. Each
+ * transaction must observe the logical IDs and the degrees of its own snapshot, while other writers commit.
+ */
+TEST_CASE("aux_dynamic_shared", "[aux]"){
+    Teseo teseo;
+    const uint64_t max_vertex_id = 200;
+
+    map<uint64_t, uint64_t> expected; // vertex ID -> degree
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 10; vertex_id <= max_vertex_id; vertex_id += 10){
+        tx.insert_vertex(vertex_id); expected[vertex_id] = 0;
+        if(vertex_id > 10){
+            tx.insert_edge(10, vertex_id, vertex_id);
+            expected[10]++; expected[vertex_id]++;
+        }
+    }
+    tx.commit();
+
+    auto check = [](Transaction& tx, const map<uint64_t, uint64_t>& expected){
+        uint64_t logical_id = 0;
+        for(auto& e : expected){
+            REQUIRE(tx.logical_id(e.first) == logical_id);
+            REQUIRE(tx.vertex_id(logical_id) == e.first);
+            REQUIRE(tx.degree(logical_id, /* logical ? */ true) == e.second);
+            logical_id++;
+        }
+        REQUIRE_THROWS_AS(tx.vertex_id(logical_id), LogicalError);
+    };
+
+    // the first writer builds the shared tree
+    auto tx1 = teseo.start_transaction();
+    check(tx1, expected);
+    tx1.commit();
+    REQUIRE(context::global_context()->aux_cache()->to_string().find("shared tree: {ready: true") != string::npos);
+
+    auto txA = teseo.start_transaction();
+    auto expected_A = expected;
+    txA.insert_vertex(205); expected_A[205] = 0;
+    txA.insert_edge(205, 20, 1); expected_A[205]++; expected_A[20]++;
+    check(txA, expected_A);
+
+    // another writer alters the graph
+    auto txB = teseo.start_transaction();
+    txB.insert_vertex(15); expected[15] = 0;
+    txB.insert_edge(15, 10, 1); expected[15]++; expected[10]++;
+    txB.insert_vertex(1); expected[1] = 0;
+    REQUIRE(txB.remove_vertex(50) == 1); expected.erase(50); expected[10]--;
+    REQUIRE(txB.remove_vertex(200) == 1); expected.erase(200); expected[10]--;
+    txB.commit();
+
+    // txA must not observe the changes of txB
+    check(txA, expected_A);
+    txA.insert_vertex(5); expected_A[5] = 0;
+    txA.insert_edge(5, 50, 1); expected_A[5]++; expected_A[50]++;
+    REQUIRE(txA.remove_vertex(100) == 1); expected_A.erase(100); expected_A[10]--;
+    check(txA, expected_A);
+
+    // a new writer observes the changes of txB
+    auto txC = teseo.start_transaction();
+    check(txC, expected);
+    txC.insert_edge(1, 15, 1); expected[1]++; expected[15]++;
+    check(txC, expected);
+    txC.rollback();
+    expected[1]--; expected[15]--;
+
+    txA.rollback();
+    auto txD = teseo.start_transaction();
+    check(txD, expected);
+    txD.commit();
+}
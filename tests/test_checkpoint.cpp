@@ -0,0 +1,143 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+#include "teseo.hpp"
+
+using namespace std;
+using namespace teseo;
+
+static string checkpoint_path(const char* name){
+    return string("/tmp/teseo_") + name + "_" + to_string(getpid()) + ".ckp";
+}
+
+/**
+ * Only the changes visible to the checkpoint should be restored
+ */
+TEST_CASE("checkpoint_basic", "[checkpoint]"){
+    string path = checkpoint_path("checkpoint_basic");
+    remove(path.c_str());
+
+    { // first instance
+        Teseo teseo;
+        auto tx1 = teseo.start_transaction();
+        tx1.insert_vertex(10);
+        tx1.insert_vertex(20);
+        tx1.insert_vertex(30);
+        tx1.insert_edge(10, 20, 1020);
+        tx1.insert_edge(20, 30, 2030);
+        tx1.commit();
+
+        auto tx2 = teseo.start_transaction();
+        REQUIRE(tx2.remove_vertex(30) == 1);
+        tx2.commit();
+
+        auto tx3 = teseo.start_transaction(); // uncommitted while the checkpoint is taken
+        tx3.insert_vertex(40);
+        tx3.insert_edge(10, 40, 1040);
+
+        teseo.checkpoint(path);
+        tx3.rollback();
+    }
+
+    { // second instance
+        Teseo teseo;
+        teseo.restore(path);
+
+        auto tx = teseo.start_transaction(/* read only ? */ true);
+        REQUIRE(tx.num_vertices() == 2);
+        REQUIRE(tx.num_edges() == 1);
+        REQUIRE(tx.has_vertex(10));
+        REQUIRE(tx.has_vertex(20));
+        REQUIRE(!tx.has_vertex(30));
+        REQUIRE(!tx.has_vertex(40));
+        REQUIRE(tx.get_weight(20, 10) == 1020);
+        REQUIRE(tx.degree(10) == 1);
+        REQUIRE(tx.degree(20) == 1);
+        tx.commit();
+
+        // the database can be altered as usual
+        auto tx2 = teseo.start_transaction();
+        tx2.insert_vertex(50);
+        tx2.insert_edge(50, 10, 5010);
+        tx2.commit();
+
+        auto tx3 = teseo.start_transaction(/* read only ? */ true);
+        REQUIRE(tx3.num_vertices() == 3);
+        REQUIRE(tx3.num_edges() == 2);
+        REQUIRE(tx3.degree(10) == 2);
+
+        // the database is not empty anymore
+        REQUIRE_THROWS_AS(teseo.restore(path), LogicalError);
+    }
+
+    remove(path.c_str());
+}
+
+/**
+ * Restore a graph spanning multiple leaves, including a vertex whose edges do not fit in a single leaf
+ */
+TEST_CASE("checkpoint_multiple_leaves", "[checkpoint]"){
+    string path = checkpoint_path("checkpoint_multiple_leaves");
+    remove(path.c_str());
+    constexpr uint64_t num_vertices = 4000;
+
+    { // first instance
+        Teseo teseo;
+        auto tx = teseo.start_transaction();
+        for(uint64_t vertex_id = 1; vertex_id <= num_vertices; vertex_id++){
+            tx.insert_vertex(vertex_id);
+            if(vertex_id > 1){ tx.insert_edge(1, vertex_id, vertex_id); } // hub
+            if(vertex_id > 2 && vertex_id % 2 == 0){ tx.insert_edge(vertex_id -1, vertex_id, vertex_id * 10); }
+        }
+        tx.commit();
+
+        teseo.checkpoint(path);
+    }
+
+    { // second instance
+        Teseo teseo;
+        teseo.restore(path);
+
+        auto tx = teseo.start_transaction(/* read only ? */ true);
+        REQUIRE(tx.num_vertices() == num_vertices);
+        REQUIRE(tx.num_edges() == (num_vertices -1) + (num_vertices /2 -1));
+        REQUIRE(tx.degree(1) == num_vertices -1);
+        for(uint64_t vertex_id = 2; vertex_id <= num_vertices; vertex_id++){
+            REQUIRE(tx.has_vertex(vertex_id));
+            REQUIRE(tx.get_weight(vertex_id, 1) == vertex_id);
+            REQUIRE(tx.degree(vertex_id) == (vertex_id == 2 ? 1 : 2));
+        }
+
+        uint64_t num_edges = 0;
+        uint64_t sum_weights = 0;
+        tx.iterator().edges(1, false, [&](uint64_t destination, double weight){
+            num_edges++;
+            sum_weights += weight;
+            return true;
+        });
+        REQUIRE(num_edges == num_vertices -1);
+        REQUIRE(sum_weights == num_vertices * (num_vertices +1) /2 -1);
+    }
+
+    remove(path.c_str());
+}
@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <limits>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -406,3 +407,67 @@ TEST_CASE( "context_high_water_mark", "[context]" ){
         }
     }
 }
+
+/**
+ * Check that a single thread can hold more active transactions than those fitting a single segment of the
+ * transaction list
+ */
+TEST_CASE( "context_transaction_list_unbounded", "[context]" ){
+    GlobalContext instance;
+    constexpr uint64_t num_transactions = 1000;
+
+    vector<TransactionImpl*> transactions;
+    for(uint64_t i = 0; i < num_transactions; i++){
+        transactions.push_back( thread_context()->create_transaction() );
+        REQUIRE(transactions.back()->ts_read() == i);
+    }
+
+    { // all transactions should be visible
+        ScopedEpoch epoch;
+        REQUIRE( instance.high_water_mark() == 0 );
+        TransactionSequence seq = thread_context()->my_active_transactions(num_transactions);
+        REQUIRE( seq.size() == num_transactions );
+        for(uint64_t i = 0; i < num_transactions; i++){
+            REQUIRE( seq[i] == num_transactions -1 -i );
+        }
+    }
+
+    // terminate the first half of the transactions
+    for(uint64_t i = 0; i < num_transactions /2; i++){
+        transactions[i]->rollback();
+        transactions[i]->decr_user_count();
+        transactions[i] = nullptr;
+    }
+
+    {
+        ScopedEpoch epoch;
+        REQUIRE( thread_context()->my_high_water_mark() == num_transactions /2 );
+        REQUIRE( instance.high_water_mark() == num_transactions /2 );
+        TransactionSequence seq = thread_context()->my_active_transactions(num_transactions);
+        REQUIRE( seq.size() == num_transactions /2 );
+    }
+
+    // the slots freed should be reused by the new transactions
+    for(uint64_t i = 0; i < num_transactions /2; i++){
+        transactions[i] = thread_context()->create_transaction();
+    }
+
+    {
+        ScopedEpoch epoch;
+        REQUIRE( instance.high_water_mark() == num_transactions /2 );
+        TransactionSequence seq = thread_context()->my_active_transactions(numeric_limits<uint64_t>::max());
+        REQUIRE( seq.size() == num_transactions );
+    }
+
+    for(auto tx : transactions){
+        tx->rollback();
+        tx->decr_user_count();
+    }
+
+    {
+        ScopedEpoch epoch;
+        TransactionSequence seq = thread_context()->my_active_transactions(numeric_limits<uint64_t>::max());
+        REQUIRE( seq.size() == 0 );
+        REQUIRE( thread_context()->my_high_water_mark() == numeric_limits<uint64_t>::max() );
+    }
+}
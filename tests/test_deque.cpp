@@ -0,0 +1,105 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "teseo/runtime/deque.hpp"
+#include "teseo/runtime/task.hpp"
+
+using namespace std;
+using namespace teseo::runtime;
+
+static Task mktask(uint64_t value){
+    return Task{ TaskType::NOP, reinterpret_cast<void*>(value) };
+}
+
+static uint64_t value(Task task){
+    return reinterpret_cast<uint64_t>(task.payload());
+}
+
+/**
+ * The owner takes the tasks in LIFO order, the thieves in FIFO order
+ */
+TEST_CASE("deque_sequential", "[deque]") {
+    Deque deque { 4 };
+    Task task;
+
+    REQUIRE(deque.empty());
+    REQUIRE(deque.take(&task) == false);
+    REQUIRE(deque.steal(&task) == false);
+
+    for(uint64_t i = 1; i <= 10; i++){ // resize twice
+        deque.push(mktask(i));
+    }
+    REQUIRE(deque.size() == 10);
+
+    REQUIRE(deque.take(&task) == true);
+    REQUIRE(value(task) == 10);
+    REQUIRE(deque.steal(&task) == true);
+    REQUIRE(value(task) == 1);
+    REQUIRE(deque.size() == 8);
+
+    uint64_t expected = 9;
+    while(deque.take(&task)){
+        REQUIRE(value(task) == expected);
+        expected--;
+    }
+    REQUIRE(expected == 1);
+    REQUIRE(deque.empty());
+    REQUIRE(deque.steal(&task) == false);
+}
+
+/**
+ * Every task is retrieved exactly once, either by the owner or by one of the thieves
+ */
+TEST_CASE("deque_concurrent", "[deque]") {
+    constexpr uint64_t num_tasks = 1ull << 18;
+    constexpr uint64_t num_thieves = 3;
+    Deque deque;
+    vector<atomic<uint64_t>> counts ( num_tasks +1 );
+    for(auto& c : counts) { c = 0; }
+    atomic<bool> done = false;
+
+    vector<thread> thieves;
+    for(uint64_t i = 0; i < num_thieves; i++){
+        thieves.emplace_back([&](){
+            Task task;
+            while(!done || !deque.empty()){
+                if(deque.steal(&task)){ counts[value(task)]++; }
+            }
+        });
+    }
+
+    Task task;
+    for(uint64_t i = 1; i <= num_tasks; i++){
+        deque.push(mktask(i));
+        if(i % 3 == 0 && deque.take(&task)){ counts[value(task)]++; }
+    }
+    while(deque.take(&task)){ counts[value(task)]++; }
+    done = true;
+    for(auto& t : thieves){ t.join(); }
+
+    for(uint64_t i = 1; i <= num_tasks; i++){
+        REQUIRE(counts[i] == 1);
+    }
+}
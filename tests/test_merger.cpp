@@ -27,7 +27,10 @@
 #include "teseo/memstore/leaf.hpp"
 #include "teseo/memstore/memstore.hpp"
 #include "teseo/memstore/segment.hpp"
+#include "teseo/memstore/vertex_table.hpp"
+#include "teseo/rebalance/merge_operator.hpp"
 #include "teseo/rebalance/merger_service.hpp"
+#include "teseo/runtime/runtime.hpp"
 #include "teseo.hpp"
 
 using namespace std;
@@ -99,4 +102,109 @@ TEST_CASE("merger_merge", "[merger]"){
     merger->execute_now();
 }
 
+/**
+ * Only the segments with removals are pruned, and a pass stops once its budget is exhausted
+ */
+TEST_CASE("merger_budget", "[merger]"){
+    Teseo teseo;
+    global_context()->runtime()->disable_rebalance();
+    Memstore* memstore = global_context()->memstore();
+    memstore->merger()->stop();
+
+    {
+        auto tx = teseo.start_transaction();
+        tx.insert_vertex(10);
+        tx.insert_vertex(20);
+        tx.commit();
+    }
+    {
+        auto tx = teseo.start_transaction();
+        tx.remove_vertex(20);
+        tx.commit();
+    }
+
+    Segment* segment = nullptr;
+    {
+        ScopedEpoch epoch;
+        segment = memstore->index()->find(0).leaf()->get_segment(0);
+        REQUIRE(segment->num_removals() == 1);
+    }
+
+    { // the budget is already exhausted, nothing is visited
+        MergeBudget budget { 0ms, 1ull << 30 };
+        MergeOperator merge_operator { Context{ memstore }, &budget };
+        REQUIRE(merge_operator.execute(KEY_MIN, KEY_MAX) == KEY_MIN);
+        REQUIRE(segment->num_removals() == 1);
+    }
+
+    { // the pass leaves the key ranges untouched
+        MergeBudget budget { 1000s, 0 };
+        vector<pair<Key, Key>> ranges { { KEY_MIN, Key{ 15 } }, { Key{ 15 }, KEY_MAX } };
+        MergePass pass { memstore, ranges, &budget };
+        global_context()->runtime()->merge_leaves(&pass);
+        REQUIRE(ranges[0].first == KEY_MIN);
+        REQUIRE(ranges[1].first == Key{ 15 });
+    }
+
+    { // unlimited budget
+        MergeOperator merge_operator { Context{ memstore } };
+        REQUIRE(merge_operator.execute(KEY_MIN, KEY_MAX) == KEY_MAX);
+        REQUIRE(segment->num_removals() == 0);
+        REQUIRE(segment->used_space() > 0);
+    }
+}
 
+/**
+ * After most vertices have been removed, the compaction merges the leaves into a single leaf, rehashes the vertex
+ * table down and releases the memory of the old leaves
+ */
+TEST_CASE("merger_compact", "[merger]"){
+    Teseo teseo;
+    Memstore* memstore = global_context()->memstore();
+    MergerService* merger = memstore->merger();
+    VertexTable* vt = memstore->vertex_table();
+
+    constexpr uint64_t vertex_max = 2000;
+
+    for(uint64_t vertex_id = 10; vertex_id <= vertex_max; vertex_id += 10){
+        auto tx = teseo.start_transaction();
+        tx.insert_vertex(vertex_id);
+        tx.commit();
+        this_thread::sleep_for(10ms); // give time to the rebalancers to pick up
+    }
+    merger->execute_now(); // prune the old versions and register the vertices in the vertex table
+
+    const uint64_t footprint_before = Leaf::memory_footprint();
+    const uint64_t capacity_before = vt->capacity();
+    {
+        ScopedEpoch epoch;
+        REQUIRE(memstore->index()->find(0).leaf()->get_hfkey() != KEY_MAX); // multiple leaves
+    }
+
+    // keep only the vertices 500, 1000, 1500 and 2000
+    for(uint64_t vertex_id = 10; vertex_id <= vertex_max; vertex_id += 10){
+        if(vertex_id % 500 == 0) continue;
+        auto tx = teseo.start_transaction();
+        tx.remove_vertex(vertex_id);
+        tx.commit();
+        this_thread::sleep_for(10ms); // give time to the rebalancers to pick up
+    }
+
+    merger->compact_now();
+
+    { // all elements are now stored in a single leaf
+        ScopedEpoch epoch;
+        REQUIRE(memstore->index()->find(0).leaf()->get_hfkey() == KEY_MAX);
+    }
+    REQUIRE(vt->capacity() < capacity_before);
+
+    // the old leaves are released by the garbage collector
+    for(uint64_t i = 0; i < 100 && Leaf::memory_footprint() >= footprint_before; i++){ this_thread::sleep_for(50ms); }
+    REQUIRE(Leaf::memory_footprint() < footprint_before);
+
+    auto tx = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx.num_vertices() == 4);
+    for(uint64_t vertex_id = 10; vertex_id <= vertex_max; vertex_id += 10){
+        REQUIRE(tx.has_vertex(vertex_id) == (vertex_id % 500 == 0));
+    }
+}
@@ -27,6 +27,7 @@
 #include "teseo/aux/view.hpp"
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/static_configuration.hpp"
+#include "teseo/memstore/leaf.hpp"
 #include "teseo/memstore/memstore.hpp"
 #include "teseo/transaction/transaction_impl.hpp"
 #include "teseo/util/thread.hpp"
@@ -110,4 +111,52 @@ TEST_CASE("numa_aux_view", "[numa]") {
     }
 }
 
+/**
+ * Pin a thread to a single CPU, as done for the workers of the runtime
+ */
+TEST_CASE("numa_affinity", "[numa]") {
+    thread([](){
+        auto allowed = util::Thread::get_affinity();
+        REQUIRE(!allowed.empty());
+        int cpu_id = allowed.back();
+        util::Thread::set_affinity(cpu_id);
+        REQUIRE(util::Thread::get_affinity() == vector<int>{ cpu_id });
+        REQUIRE(util::Thread::get_cpu_id() == cpu_id);
+    }).join();
+}
+
+/**
+ * On a machine with two NUMA nodes, check whether the leaves are allocated in the node of the thread creating them
+ */
+TEST_CASE("numa_leaf", "[numa]") {
+    if(context::StaticConfiguration::numa_num_nodes >= 2){
+        for(int node = 0; node < 2; node++){
+            thread([node](){
+                // pin the thread to the given NUMA node
+                auto numa_bitmask = numa_allocate_cpumask();
+                int rc = numa_node_to_cpus(node, numa_bitmask);
+                REQUIRE(rc == 0);
+                cpu_set_t cpu_bitmask;
+                CPU_ZERO(&cpu_bitmask);
+                for(unsigned int i = 0, end = numa_num_possible_cpus(); i < end; i++){
+                    if(numa_bitmask_isbitset(numa_bitmask, i)){
+                        CPU_SET(i, &cpu_bitmask);
+                    }
+                }
+                numa_free_cpumask(numa_bitmask);
+                rc = sched_setaffinity(/* calling process */ 0, sizeof(cpu_set_t), &cpu_bitmask);
+                REQUIRE(rc == 0);
+
+                memstore::Leaf* leaf = memstore::internal::allocate_leaf();
+                REQUIRE(leaf->numa_node() == node);
+                int mem_node = -1;
+                rc = get_mempolicy(&mem_node, /* node mask */ nullptr, /* node mask size */ 0, /* address */ leaf, MPOL_F_NODE | MPOL_F_ADDR);
+                REQUIRE(rc == 0);
+                REQUIRE(mem_node == node);
+                memstore::internal::deallocate_leaf(leaf);
+            }).join();
+        }
+    }
+}
+
 #endif
@@ -715,3 +715,101 @@ TEST_CASE("parallel_iter_rw2", "[parallel][iter_parallel]"){
     for(auto& t: threads) t.join();
 }
 
+
+/**
+ * Process the vertices of the graph with Teseo#parallel_for, with and without a transaction
+ */
+TEST_CASE("parallel_for", "[parallel][parallel_for]"){
+    Teseo teseo;
+    const uint64_t num_vertices = 1000;
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 10; vertex_id <= num_vertices * 10; vertex_id += 10){
+        tx.insert_vertex(vertex_id);
+        if(vertex_id > 10){ tx.insert_edge(10, vertex_id, vertex_id); }
+    }
+    tx.commit();
+
+    // without a transaction
+    vector<atomic<uint64_t>> counts ( num_vertices );
+    for(auto& c : counts) { c = 0; }
+    teseo.parallel_for(0, num_vertices, 16, [&](uint64_t i){ counts[i]++; });
+    for(uint64_t i = 0; i < num_vertices; i++){ REQUIRE(counts[i] == 1); }
+
+    // empty interval
+    teseo.parallel_for(10, 10, 1, [&](uint64_t i){ counts[i]++; });
+    REQUIRE(counts[10] == 1);
+
+    // with a transaction
+    auto tx_ro = teseo.start_transaction(/* read only ? */ true);
+    atomic<uint64_t> sum_degrees = 0;
+    atomic<uint64_t> sum_weights = 0;
+    teseo.parallel_for(tx_ro, 0, num_vertices, 7, [&](Transaction& tx, Iterator& it, uint64_t logical_id){
+        sum_degrees += tx.degree(logical_id, /* logical ? */ true);
+        it.edges(tx.vertex_id(logical_id), false, [&](uint64_t destination, double weight){
+            sum_weights += static_cast<uint64_t>(weight);
+        });
+    });
+    REQUIRE(sum_degrees == 2 * (num_vertices -1));
+    REQUIRE(sum_weights == 2 * (10 * num_vertices * (num_vertices +1) / 2 - 10));
+    tx_ro.commit(); // all copies and iterators have been released
+}
+
+/**
+ * An exception raised inside Teseo#parallel_for is propagated to the caller
+ */
+TEST_CASE("parallel_for_exception", "[parallel][parallel_for]"){
+    Teseo teseo;
+    auto tx = teseo.start_transaction(/* read only ? */ true);
+
+    REQUIRE_THROWS_AS( teseo.parallel_for(tx, 0, 1000, 10, [](Transaction& tx, Iterator&, uint64_t i){
+        tx.degree(i +1); // the vertex does not exist
+    }), LogicalError );
+    REQUIRE_THROWS_AS( teseo.parallel_for(0, 1000, 10, [](uint64_t i){
+        if(i == 500) throw std::runtime_error("expected");
+    }), std::runtime_error );
+
+    tx.commit();
+}
+
+/**
+ * Spawn a few closures, also recursively, in a task group
+ */
+TEST_CASE("parallel_task_group", "[parallel][parallel_for]"){
+    Teseo teseo;
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 10; vertex_id <= 100; vertex_id += 10){ tx.insert_vertex(vertex_id); }
+    tx.commit();
+    tx = teseo.start_transaction(/* read only ? */ true);
+
+    atomic<uint64_t> num_executed = 0;
+    atomic<uint64_t> num_vertices = 0;
+    { // without a transaction
+        TaskGroup group { teseo };
+        for(uint64_t i = 0; i < 10; i++){
+            group.run([&](){
+                num_executed++;
+                group.run([&](){ num_executed++; });
+            });
+        }
+        group.wait();
+        REQUIRE(num_executed == 20);
+
+        REQUIRE_THROWS_AS( group.run([](Transaction&, Iterator&){ /* nop */ }), LogicalError );
+        group.run([](){ throw std::runtime_error("expected"); });
+        REQUIRE_THROWS_AS( group.wait(), std::runtime_error );
+        group.wait(); // the error has already been reported
+    }
+
+    { // with a transaction
+        TaskGroup group { teseo, tx };
+        for(uint64_t i = 0; i < 10; i++){
+            group.run([&, i](Transaction& tx, Iterator&){
+                if(tx.has_vertex((i +1) * 10)){ num_vertices++; }
+            });
+        }
+        group.wait();
+        REQUIRE(num_vertices == 10);
+    }
+
+    tx.commit();
+}
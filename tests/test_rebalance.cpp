@@ -26,12 +26,15 @@
 #include "teseo/context/global_context.hpp"
 #include "teseo/context/scoped_epoch.hpp"
 #include "teseo/context/static_configuration.hpp"
+#include "teseo/context/thread_context.hpp"
 #include "teseo/memstore/context.hpp"
 #include "teseo/memstore/index.hpp"
 #include "teseo/memstore/leaf.hpp"
 #include "teseo/memstore/memstore.hpp"
 #include "teseo/memstore/segment.hpp"
+#include "teseo/memstore/sparse_file.hpp"
 #include "teseo/rebalance/crawler.hpp"
+#include "teseo/rebalance/plan.hpp"
 #include "teseo/rebalance/scratchpad.hpp"
 #include "teseo/rebalance/spread_operator.hpp"
 #include "teseo/runtime/runtime.hpp"
@@ -609,3 +612,232 @@ TEST_CASE("rb_async2", "[rebalance]"){
         tx.commit();
     }
 }
+
+/**
+ * Rebalance the leaves from a runtime worker, so that the content of the segments is loaded and saved back
+ * in parallel with the help of the other workers. The edges of the vertex 10 span many segments, thus most
+ * batches of segments start with a dummy vertex.
+ */
+TEST_CASE("rb_parallel", "[rebalance]"){
+    static_assert(StaticConfiguration::rebalance_parallel_threshold <= StaticConfiguration::memstore_max_num_segments_per_leaf, "Otherwise the rebalances are always serial");
+    Teseo teseo;
+    Memstore* memstore = global_context()->memstore();
+    constexpr uint64_t MAX_VERTEX_ID = 2000;
+
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 10; vertex_id <= MAX_VERTEX_ID; vertex_id += 10){
+        tx.insert_vertex(vertex_id);
+        if(vertex_id > 10){ tx.insert_edge(10, vertex_id, vertex_id); }
+    }
+    tx.commit();
+
+    auto tx_ro = teseo.start_transaction(/* read only ? */ true);
+    auto tx_pending = teseo.start_transaction(); // its changes are still versioned while the leaves are rebalanced
+    for(uint64_t vertex_id = 20; vertex_id <= MAX_VERTEX_ID; vertex_id += 20){
+        tx_pending.remove_edge(10, vertex_id);
+    }
+
+    for(uint64_t vertex_id = 10; vertex_id <= MAX_VERTEX_ID; vertex_id += 100){
+        ScopedEpoch epoch;
+        Leaf* leaf = memstore->index()->find(vertex_id +1).leaf();
+        Segment* segment = leaf->get_segment(0);
+        segment->set_flag_rebal_requested();
+        global_context()->runtime()->rebalance_segment_sync(memstore, segment->m_fence_key);
+    }
+
+    // the older transaction still sees all edges
+    constexpr uint64_t num_vertices = MAX_VERTEX_ID / 10;
+    REQUIRE(tx_ro.num_vertices() == num_vertices);
+    REQUIRE(tx_ro.degree(10) == num_vertices -1);
+    uint64_t num_edges = 0;
+    uint64_t sum_weights = 0;
+    tx_ro.iterator().edges(10, false, [&](uint64_t destination, double weight){
+        num_edges++;
+        sum_weights += weight;
+        REQUIRE(destination == weight);
+        return true;
+    });
+    REQUIRE(num_edges == num_vertices -1);
+    REQUIRE(sum_weights == 10 * num_vertices * (num_vertices +1) /2 -10);
+
+    // the pending removals are preserved
+    tx_pending.commit();
+    tx = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx.num_vertices() == num_vertices);
+    REQUIRE(tx.degree(10) == num_vertices /2 -1);
+    for(uint64_t vertex_id = 20; vertex_id <= MAX_VERTEX_ID; vertex_id += 10){
+        REQUIRE(tx.has_vertex(vertex_id));
+        REQUIRE(tx.has_edge(10, vertex_id) == (vertex_id % 20 != 0));
+    }
+}
+
+/**
+ * The requests for the same leaf are coalesced, and the most urgent request is handled first
+ */
+TEST_CASE("rb_scheduler", "[rebalance]"){
+    Teseo teseo;
+    global_context()->runtime()->disable_rebalance(); // we'll do the rebalances manually
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 10; vertex_id <= 40; vertex_id += 10){ tx.insert_vertex(vertex_id); }
+    tx.commit();
+
+    ScopedEpoch epoch;
+    Memstore* memstore = global_context()->memstore();
+    Leaf* leaf = memstore->index()->find(0).leaf();
+    REQUIRE(leaf->get_segment(0)->used_space() > 0);
+    REQUIRE(leaf->get_segment(1)->used_space() == 0);
+    runtime::RebalanceScheduler scheduler;
+    int worker_id = -1;
+
+    // the scheduler never dereferences the leaf, a different address is enough to simulate another leaf
+    Context context_b { memstore };
+    context_b.m_leaf = reinterpret_cast<Leaf*>(reinterpret_cast<uintptr_t>(leaf) + 64);
+    context_b.m_segment = leaf->get_segment(1); // empty
+    REQUIRE(scheduler.request(context_b, Key{100}, /* workers */ {0}, 0ms, &worker_id) == true);
+    REQUIRE(worker_id == 0);
+
+    Context context_a { memstore };
+    context_a.m_leaf = leaf;
+    context_a.m_segment = leaf->get_segment(1);
+    REQUIRE(scheduler.request(context_a, Key{20}, /* workers */ {0}, 0ms, &worker_id) == true);
+    context_a.m_segment = leaf->get_segment(0);
+    REQUIRE(scheduler.request(context_a, Key{0}, /* workers */ {0}, 0ms, &worker_id) == false); // coalesced
+    REQUIRE(scheduler.request(context_a, Key{20}, /* workers */ {0}, 0ms, &worker_id) == false); // coalesced
+    REQUIRE(scheduler.size() == 2);
+
+    REQUIRE(scheduler.fetch(/* worker id */ 1) == nullptr);
+
+    auto request_a = scheduler.fetch(0);
+    REQUIRE(request_a != nullptr);
+    REQUIRE(request_a->m_leaf == leaf);
+    auto keys = request_a->keys();
+    REQUIRE(keys.size() == 2); // without duplicates
+    REQUIRE(keys[0] == Key{0}); // the filled segment first
+    REQUIRE(keys[1] == Key{20});
+    delete request_a;
+
+    auto request_b = scheduler.fetch(0);
+    REQUIRE(request_b != nullptr);
+    REQUIRE(request_b->m_leaf == context_b.m_leaf);
+    REQUIRE(request_b->keys().size() == 1);
+    delete request_b;
+
+    REQUIRE(scheduler.fetch(0) == nullptr);
+    REQUIRE(scheduler.size() == 0);
+}
+
+/**
+ * Split the last leaf when the vertices are appended in increasing order: the existing leaf is filled up to the brim and
+ * the rest is moved to a new leaf, whose last segments are left empty for the next appends
+ */
+TEST_CASE("rb_append", "[rebalance]"){
+    Teseo teseo;
+    Memstore* memstore = global_context()->memstore();
+    global_context()->runtime()->disable_rebalance(); // we'll do the rebalances manually
+    const uint64_t MAX_VERTEX_ID = 400;
+
+    auto rebalance_tail = [memstore](){
+        ScopedEpoch epoch;
+        Context context { memstore };
+        Leaf* leaf = memstore->index()->find(0).leaf();
+        int64_t segment_id = leaf->num_segments() -1;
+        while(segment_id > 0 && leaf->get_segment(segment_id)->used_space() == 0){ segment_id--; }
+        Segment* segment = leaf->get_segment(segment_id);
+        segment->set_flag_rebal_requested();
+        Crawler crawler { context, segment->m_fence_key };
+        Plan plan = crawler.make_plan();
+        ScratchPad scratchpad { plan.cardinality() };
+        SpreadOperator rebalance { context, scratchpad, plan };
+        rebalance();
+        return plan;
+    };
+
+    auto tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 10; vertex_id <= 80; vertex_id += 10){ tx.insert_vertex(vertex_id); }
+    tx.commit();
+    Plan plan1 = rebalance_tail(); // first rebalance at the tail
+    REQUIRE(plan1.is_rebalance());
+    REQUIRE(!plan1.is_append());
+
+    tx = teseo.start_transaction();
+    for(uint64_t vertex_id = 90; vertex_id <= MAX_VERTEX_ID; vertex_id += 10){ tx.insert_vertex(vertex_id); }
+    tx.commit();
+    Plan plan2 = rebalance_tail(); // second rebalance at the tail, split for the appends
+    REQUIRE(plan2.is_resize());
+    REQUIRE(plan2.is_append());
+
+    { // validate the layout of the two leaves
+        ScopedEpoch epoch;
+        Leaf* leaf1 = memstore->index()->find(0).leaf();
+        REQUIRE(leaf1->get_hfkey() != KEY_MAX);
+        for(uint64_t segment_id = 0; segment_id < leaf1->num_segments(); segment_id++){
+            Segment* segment = leaf1->get_segment(segment_id);
+            REQUIRE(segment->get_state() == Segment::State::FREE);
+            REQUIRE(segment->used_space() >= SparseFile::max_num_qwords() /2);
+        }
+
+        Leaf* leaf2 = memstore->index()->find(leaf1->get_hfkey().source()).leaf();
+        REQUIRE(leaf2 != leaf1);
+        REQUIRE(leaf2->get_hfkey() == KEY_MAX);
+        REQUIRE(leaf2->num_segments() == StaticConfiguration::memstore_max_num_segments_per_leaf);
+        REQUIRE(leaf2->get_segment(0)->used_space() > 0);
+        REQUIRE(leaf2->get_segment(leaf2->num_segments() -1)->used_space() == 0);
+    }
+
+    tx = teseo.start_transaction();
+    REQUIRE(tx.num_vertices() == MAX_VERTEX_ID /10);
+    for(uint64_t vertex_id = 10; vertex_id <= MAX_VERTEX_ID; vertex_id += 10){
+        REQUIRE(tx.has_vertex(vertex_id));
+    }
+    tx.commit();
+
+    // keep appending
+    tx = teseo.start_transaction();
+    for(uint64_t vertex_id = MAX_VERTEX_ID +10; vertex_id <= 2 * MAX_VERTEX_ID; vertex_id += 10){ tx.insert_vertex(vertex_id); }
+    tx.commit();
+
+    tx = teseo.start_transaction();
+    REQUIRE(tx.num_vertices() == 2 * MAX_VERTEX_ID /10);
+    for(uint64_t vertex_id = 10; vertex_id <= 2 * MAX_VERTEX_ID; vertex_id += 10){
+        REQUIRE(tx.has_vertex(vertex_id));
+    }
+    tx.commit();
+}
+
+/**
+ * The scratchpad of the thread context is kept among the rebalances, growing to the largest one
+ */
+TEST_CASE("rb_scratchpad", "[rebalance]"){
+    Teseo teseo;
+
+    ScratchPad& scratchpad = thread_context()->scratchpad();
+    REQUIRE(&scratchpad == &(thread_context()->scratchpad()));
+    REQUIRE(thread_context()->segment_buffer() == thread_context()->segment_buffer());
+
+    // large enough to be backed by the huge pages
+    constexpr uint64_t num_vertices = 1ull << 18;
+    scratchpad.clear();
+    scratchpad.ensure_capacity(num_vertices);
+    REQUIRE(scratchpad.capacity() >= num_vertices);
+    for(uint64_t i = 1; i <= num_vertices; i++){
+        Vertex vertex; vertex.m_vertex_id = i; vertex.m_first = 1; vertex.m_lock = 0; vertex.m_count = 0;
+        scratchpad.load_vertex(&vertex, nullptr);
+    }
+    REQUIRE(scratchpad.size() == num_vertices);
+
+    // grow, the loaded elements are preserved
+    scratchpad.ensure_capacity(num_vertices +1);
+    REQUIRE(scratchpad.capacity() >= num_vertices + num_vertices /2);
+    REQUIRE(scratchpad.size() == num_vertices);
+    for(uint64_t i = 1; i <= num_vertices; i++){
+        REQUIRE(scratchpad.get_vertex(i -1)->m_vertex_id == i);
+        REQUIRE(!scratchpad.has_version(i -1));
+    }
+
+    // reused, the capacity is retained
+    const uint64_t capacity = scratchpad.capacity();
+    scratchpad.clear();
+    scratchpad.ensure_capacity(10);
+    REQUIRE(scratchpad.capacity() == capacity);
+    REQUIRE(scratchpad.size() == 0);
+}
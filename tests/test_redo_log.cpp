@@ -0,0 +1,153 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "teseo.hpp"
+
+using namespace std;
+using namespace teseo;
+
+static string redo_log_path(const char* name){
+    return string("/tmp/teseo_") + name + "_" + to_string(getpid()) + ".log";
+}
+
+/**
+ * Restore the committed transactions from the redo log in a new instance
+ */
+TEST_CASE("redo_log_recovery", "[redo_log]"){
+    string path = redo_log_path("redo_log_recovery");
+    remove(path.c_str());
+
+    { // first instance
+        Teseo teseo;
+        teseo.enable_redo_log(path);
+
+        auto tx1 = teseo.start_transaction();
+        tx1.insert_vertex(10);
+        tx1.insert_vertex(20);
+        tx1.insert_vertex(30);
+        tx1.insert_edge(10, 20, 1020);
+        tx1.insert_edge(20, 30, 2030);
+        tx1.commit();
+
+        auto tx2 = teseo.start_transaction();
+        REQUIRE(tx2.remove_vertex(30) == 1);
+        tx2.commit();
+
+        auto tx3 = teseo.start_transaction();
+        tx3.insert_vertex(50);
+        tx3.rollback(); // this should not be recorded
+
+        auto tx4 = teseo.start_transaction();
+        tx4.insert_vertex(40);
+        tx4.insert_edge(10, 40, 1040);
+        tx4.commit();
+    }
+
+    { // second instance, recover from the log and append more changes
+        Teseo teseo;
+        teseo.enable_redo_log(path);
+
+        auto tx = teseo.start_transaction(/* read only ? */ true);
+        REQUIRE(tx.num_vertices() == 3);
+        REQUIRE(tx.num_edges() == 2);
+        REQUIRE(tx.has_vertex(10));
+        REQUIRE(tx.has_vertex(20));
+        REQUIRE(!tx.has_vertex(30));
+        REQUIRE(tx.has_vertex(40));
+        REQUIRE(!tx.has_vertex(50));
+        REQUIRE(tx.get_weight(10, 20) == 1020);
+        REQUIRE(tx.get_weight(40, 10) == 1040);
+        REQUIRE(!tx.has_edge(20, 30));
+        REQUIRE(tx.degree(10) == 2);
+        REQUIRE(tx.degree(20) == 1);
+
+        auto tx2 = teseo.start_transaction();
+        tx2.insert_vertex(60);
+        tx2.remove_edge(10, 20);
+        tx2.commit();
+    }
+
+    { // third instance
+        Teseo teseo;
+        teseo.enable_redo_log(path);
+
+        auto tx = teseo.start_transaction(/* read only ? */ true);
+        REQUIRE(tx.num_vertices() == 4);
+        REQUIRE(tx.num_edges() == 1);
+        REQUIRE(tx.has_vertex(60));
+        REQUIRE(!tx.has_edge(10, 20));
+        REQUIRE(tx.has_edge(10, 40));
+    }
+
+    remove(path.c_str());
+}
+
+/**
+ * Multiple threads committing concurrently, then recover the log in parallel
+ */
+TEST_CASE("redo_log_group_commit", "[redo_log]"){
+    string path = redo_log_path("redo_log_group_commit");
+    remove(path.c_str());
+    constexpr uint64_t num_threads = 4;
+    constexpr uint64_t num_vertices = 1000; // per thread
+
+    { // first instance
+        Teseo teseo;
+        teseo.enable_redo_log(path);
+
+        vector<thread> threads;
+        for(uint64_t i = 0; i < num_threads; i++){
+            threads.emplace_back([&teseo, i](){
+                teseo.register_thread();
+                uint64_t base = (i +1) * 100000;
+                for(uint64_t j = 1; j <= num_vertices; j++){
+                    auto tx = teseo.start_transaction();
+                    tx.insert_vertex(base + j);
+                    if(j > 1){ tx.insert_edge(base + j -1, base + j, j); }
+                    tx.commit();
+                }
+                teseo.unregister_thread();
+            });
+        }
+        for(auto& t : threads) t.join();
+    }
+
+    { // second instance
+        Teseo teseo;
+        teseo.enable_redo_log(path);
+
+        auto tx = teseo.start_transaction(/* read only ? */ true);
+        REQUIRE(tx.num_vertices() == num_threads * num_vertices);
+        REQUIRE(tx.num_edges() == num_threads * (num_vertices -1));
+        for(uint64_t i = 0; i < num_threads; i++){
+            uint64_t base = (i +1) * 100000;
+            REQUIRE(tx.degree(base +1) == 1);
+            REQUIRE(tx.degree(base + num_vertices / 2) == 2);
+            REQUIRE(tx.get_weight(base + num_vertices -1, base + num_vertices) == num_vertices);
+        }
+    }
+
+    remove(path.c_str());
+}
@@ -29,6 +29,7 @@
 #include "teseo/memstore/leaf.hpp"
 #include "teseo/memstore/memstore.hpp"
 #include "teseo/memstore/segment.hpp"
+#include "teseo/memstore/sparse_file.hpp"
 #include "teseo/rebalance/crawler.hpp" // RebalanceNotNecessary
 #include "teseo/runtime/runtime.hpp"
 #include "teseo/util/compiler.hpp"
@@ -1110,3 +1111,42 @@ TEST_CASE("segment_wait_optimistic3", "[segment]" ) {
 }
 
 
+
+/**
+ * Check that a segment whose versions area exceeds the threshold is asynchronously pruned by the runtime
+ */
+TEST_CASE("segment_async_prune", "[segment]" ) {
+    Teseo teseo;
+    Memstore* memstore = global_context()->memstore();
+
+    auto tx = teseo.start_transaction();
+    tx.insert_vertex(10);
+    tx.insert_vertex(20);
+    tx.insert_vertex(30);
+    tx.insert_vertex(40);
+    tx.insert_edge(10, 20, 1020);
+    tx.insert_edge(10, 30, 1030);
+    tx.insert_edge(10, 40, 1040);
+    tx.commit();
+
+    auto versions_space = [memstore](){
+        ScopedEpoch epoch;
+        Context context { memstore };
+        context.m_leaf = memstore->index()->find(0).leaf();
+        context.m_segment = context.m_leaf->get_segment(0);
+        return context.sparse_file()->versions_space();
+    };
+
+    // wait for the runtime to prune the segment
+    uint64_t num_attempts = 0;
+    while(versions_space() > 0 && num_attempts < 100){
+        this_thread::sleep_for(20ms);
+        num_attempts++;
+    }
+    REQUIRE(versions_space() == 0);
+
+    auto tx_ro = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx_ro.num_vertices() == 4);
+    REQUIRE(tx_ro.num_edges() == 3);
+    REQUIRE(tx_ro.get_weight(10, 30) == 1030);
+}
@@ -17,7 +17,14 @@
 
 #include "catch.hpp"
 
-
+#include <atomic>
+#include <thread>
+
+#include "teseo.hpp"
+#include "teseo/context/global_context.hpp"
+#include "teseo/context/scoped_epoch.hpp"
+#include "teseo/context/static_configuration.hpp"
+#include "teseo/gc/garbage_collector.hpp"
 #include "teseo/gc/item.hpp"
 #include "teseo/gc/simple_queue.hpp"
 
@@ -26,6 +33,9 @@ using namespace teseo::gc;
 
 void tcqueue_deleter(void*){ /* nop */ }
 
+static uint64_t g_tcqueue_num_deleted = 0;
+void tcqueue_counting_deleter(void*){ g_tcqueue_num_deleted++; }
+
 
 TEST_CASE("tcqueue_simple", "[tcqueue]"){
     SimpleQueue queue { 6 };
@@ -214,3 +224,60 @@ TEST_CASE("tcqueue_resize", "[tcqueue]"){
 }
 
 
+
+/**
+ * The delay between two passes of the GC adapts to its backlog
+ */
+TEST_CASE("tcqueue_gc_pacing", "[tcqueue][gc]"){
+    using namespace teseo;
+    using SC = context::StaticConfiguration;
+    Teseo teseo;
+    GarbageCollector gc { context::global_context() };
+    g_tcqueue_num_deleted = 0;
+    REQUIRE(gc.delay() == SC::runtime_gc_frequency);
+
+    // idle, back off
+    gc.execute();
+    REQUIRE(gc.backlog() == 0);
+    REQUIRE(gc.delay() == 2 * SC::runtime_gc_frequency);
+    for(int i = 0; i < 10; i++){ gc.execute(); }
+    REQUIRE(gc.delay() == SC::runtime_gc_max_delay);
+
+    // a few items, back to the default frequency
+    for(uint64_t i = 1; i <= 10; i++){ gc.mark((void*) i, tcqueue_counting_deleter); }
+    gc.execute();
+    REQUIRE(g_tcqueue_num_deleted == 10);
+    REQUIRE(gc.backlog() == 0);
+    REQUIRE(gc.delay() == SC::runtime_gc_frequency);
+
+    // a large backlog, while another thread prevents the newest items to be released
+    for(uint64_t i = 1; i <= 10; i++){ gc.mark((void*) i, tcqueue_counting_deleter); }
+    atomic<int> state = 0; // 0 = init, 1 = in the epoch, 2 = exit the epoch
+    thread reader([&](){
+        teseo.register_thread();
+        {
+            context::ScopedEpoch epoch;
+            state = 1;
+            while(state != 2) { this_thread::yield(); }
+        }
+        teseo.unregister_thread();
+    });
+    while(state != 1){ this_thread::yield(); }
+    for(uint64_t i = 1; i <= SC::gc_backlog_threshold; i++){ gc.mark((void*) i, tcqueue_counting_deleter); }
+    gc.execute();
+    REQUIRE(g_tcqueue_num_deleted == 20);
+    REQUIRE(gc.backlog() == SC::gc_backlog_threshold);
+    REQUIRE(gc.delay() == SC::runtime_gc_min_delay);
+
+    // nothing can be released, retrying sooner would not help
+    gc.execute();
+    REQUIRE(g_tcqueue_num_deleted == 20);
+    REQUIRE(gc.delay() == SC::runtime_gc_frequency);
+
+    state = 2;
+    reader.join();
+    gc.execute();
+    REQUIRE(g_tcqueue_num_deleted == 20 + SC::gc_backlog_threshold);
+    REQUIRE(gc.backlog() == 0);
+    REQUIRE(gc.delay() == SC::runtime_gc_frequency);
+}
@@ -28,7 +28,9 @@
 #include "teseo/context/thread_context.hpp"
 #include "teseo/runtime/runtime.hpp"
 #include "teseo/transaction/memory_pool.hpp"
+#include "teseo/transaction/memory_pool_list.hpp"
 #include "teseo/transaction/transaction_impl.hpp"
+#include "teseo/transaction/undo_buffer.hpp"
 
 #include "teseo.hpp"
 
@@ -227,3 +229,61 @@ TEST_CASE("txn_mempool_reuse5", "[transaction]"){
     REQUIRE(txpool1->is_empty() == true);
     REQUIRE(txpool1->fill_factor() == 0);
 }
+
+// Check the undo buffers released to a transaction pool list are recycled by the next acquisitions
+TEST_CASE("txn_mempool_undo_recycle", "[transaction]"){
+    Teseo teseo;
+    MemoryPoolList* list = thread_context()->undo_buffer_cache();
+    REQUIRE(list != nullptr);
+    REQUIRE(list->undo_cached_bytes() == 0);
+
+    const uint32_t buffer_sz = StaticConfiguration::transaction_undo_buffer_size;
+    UndoBuffer* buffer1 = list->acquire_undo_buffer(buffer_sz);
+    REQUIRE(buffer1->m_space_total == buffer_sz);
+    REQUIRE(buffer1->m_cache == list);
+    buffer1->m_space_left = 0; // pretend it has been filled
+    UndoBuffer::recycle(buffer1);
+    REQUIRE(list->undo_cached_bytes() == buffer_sz);
+
+    // the same buffer should be returned, in a clean state
+    UndoBuffer* buffer2 = list->acquire_undo_buffer(buffer_sz);
+    REQUIRE(buffer2 == buffer1);
+    REQUIRE(buffer2->m_space_left == buffer_sz);
+    REQUIRE(buffer2->m_next == nullptr);
+    REQUIRE(list->undo_cached_bytes() == 0);
+
+    // a different size class does not share the free list
+    UndoBuffer* buffer3 = list->acquire_undo_buffer(buffer_sz * 2);
+    REQUIRE(buffer3 != buffer2);
+    REQUIRE(buffer3->m_space_total == buffer_sz * 2);
+
+    // buffers with an irregular size are never retained
+    UndoBuffer* buffer4 = list->acquire_undo_buffer(buffer_sz + 8);
+    REQUIRE(buffer4->m_cache == nullptr);
+
+    UndoBuffer::recycle(buffer2);
+    UndoBuffer::recycle(buffer3);
+    UndoBuffer::recycle(buffer4);
+    REQUIRE(list->undo_cached_bytes() == buffer_sz * 3);
+}
+
+// Ensure that large transactions can still be rolled back after acquiring several (larger) undo buffers
+TEST_CASE("txn_mempool_undo_growth", "[transaction]"){
+    Teseo teseo;
+    auto tx = teseo.start_transaction();
+    for(uint64_t i = 1; i <= 2000; i++){
+        tx.insert_vertex(i * 10);
+    }
+    REQUIRE(tx.num_vertices() == 2000);
+    tx.rollback();
+
+    auto tx2 = teseo.start_transaction();
+    REQUIRE(tx2.num_vertices() == 0);
+    for(uint64_t i = 1; i <= 2000; i++){
+        tx2.insert_vertex(i * 10);
+    }
+    tx2.commit();
+
+    auto tx3 = teseo.start_transaction(/* read only ? */ true);
+    REQUIRE(tx3.num_vertices() == 2000);
+}